@@ -0,0 +1,388 @@
+// GL 없이 도는 microbenchmark : 행렬 helper 와 OBJ loader 의 핵심 부분을 잽니다.
+// usage: ./scop_bench [--filter <name>] [--samples <n>] [--json <file>|-]
+// case 마다 sample 하나가 20 ms 쯤 되도록 맞춘 뒤 n 번 (기본 15) 잽니다. --json 은 git revision 과 같은 숫자를 씁니다.
+
+#include "utils.hpp"
+#include "MeshData.hpp"
+#include "OcclusionBuffer.hpp"
+#include "TriangleBVH.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#ifndef BENCH_REVISION
+# define BENCH_REVISION "unknown"
+#endif
+
+namespace
+{
+	const double	TARGET_SAMPLE_NS = 20e6;
+
+	// 결과를 여기에 더해서 계산이 지워지지 않게 합니다.
+	volatile float	g_sink;
+
+	struct	BenchResult {
+		std::string					name;
+		std::string					unit;				// op 하나가 무엇인지
+		double							bytesPerOp;	// 0 이면 MB/s 를 쓰지 않습니다
+		size_t							opsPerSample;
+		std::vector<double>	nsPerOp;
+		double							mean, stddev, min, median;
+	};
+
+	struct	BenchOptions {
+		std::string	filter;
+		std::string	jsonPath;
+		size_t			samples;
+
+		BenchOptions() : samples(15)
+		{
+		}
+	};
+
+	double	elapsedNs(std::chrono::steady_clock::time_point begin)
+	{
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	void	summarize(BenchResult& result)
+	{
+		std::vector<double>	sorted = result.nsPerOp;
+		std::sort(sorted.begin(), sorted.end());
+		double	sum = 0.0, squares = 0.0;
+		for (size_t i = 0; i < sorted.size(); i++)
+			sum += sorted[i];
+		result.mean = sum / sorted.size();
+		for (size_t i = 0; i < sorted.size(); i++)
+			squares += (sorted[i] - result.mean) * (sorted[i] - result.mean);
+		result.stddev = sorted.size() > 1 ? std::sqrt(squares / (sorted.size() - 1)) : 0.0;
+		result.min = sorted.front();
+		result.median = sorted.size() % 2 ? sorted[sorted.size() / 2]
+			: (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2.0;
+	}
+
+	// body() 한 번이 opsPerCall 개의 op 를 합니다. 반복 횟수는 한 sample 이 TARGET_SAMPLE_NS 쯤 되게 맞춥니다.
+	template <typename F>
+	void	runCase(std::vector<BenchResult>& results, const BenchOptions& options, const char* name,
+					const char* unit, size_t opsPerCall, double bytesPerOp, F body)
+	{
+		if (!options.filter.empty() && std::string(name).find(options.filter) == std::string::npos)
+			return ;
+
+		size_t	calls = 1;
+		for (;;)
+		{
+			std::chrono::steady_clock::time_point	begin = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < calls; i++)
+				body();
+			double	ns = elapsedNs(begin);
+			if (ns >= TARGET_SAMPLE_NS / 4 || calls >= (1u << 30))
+			{
+				calls = std::max<size_t>(1, static_cast<size_t>(calls * TARGET_SAMPLE_NS / std::max(ns, 1.0)));
+				break ;
+			}
+			calls *= 2;
+		}
+
+		BenchResult	result;
+		result.name = name;
+		result.unit = unit;
+		result.bytesPerOp = bytesPerOp;
+		result.opsPerSample = calls * opsPerCall;
+		for (size_t sample = 0; sample < options.samples; sample++)
+		{
+			std::chrono::steady_clock::time_point	begin = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < calls; i++)
+				body();
+			result.nsPerOp.push_back(elapsedNs(begin) / result.opsPerSample);
+		}
+		summarize(result);
+		results.push_back(result);
+
+		// --json - 이면 stdout 에는 JSON 만 나가도록 표는 stderr 로 보냅니다.
+		FILE*	table = options.jsonPath == "-" ? stderr : stdout;
+		std::fprintf(table, "%-24s %10.2f ns/%-8s ±%6.2f  min %10.2f  median %10.2f  %12.0f %s/s",
+			name, result.mean, unit, result.stddev, result.min, result.median, 1e9 / result.mean, unit);
+		if (bytesPerOp > 0.0)
+			std::fprintf(table, "  %8.1f MB/s", bytesPerOp * 1e3 / result.mean);
+		std::fprintf(table, "\n");
+	}
+
+	void	writeJson(const std::vector<BenchResult>& results, const BenchOptions& options)
+	{
+		FILE*	out = options.jsonPath == "-" ? stdout : std::fopen(options.jsonPath.c_str(), "w");
+		if (!out)
+			throw std::runtime_error("ERROR::BENCH::JSON::PATH_ERROR\nfailed to open " + options.jsonPath);
+
+		std::fprintf(out, "{\n  \"revision\": \"%s\",\n  \"compiler\": \"%s\",\n  \"samples\": %zu,\n  \"results\": [\n",
+			BENCH_REVISION, __VERSION__, options.samples);
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const BenchResult&	r = results[i];
+			std::fprintf(out, "    {\"name\": \"%s\", \"unit\": \"%s\", \"ops_per_sample\": %zu, "
+				"\"ns_per_op\": {\"mean\": %.4f, \"stddev\": %.4f, \"variance\": %.4f, \"min\": %.4f, \"median\": %.4f}, "
+				"\"ops_per_sec\": %.1f",
+				r.name.c_str(), r.unit.c_str(), r.opsPerSample, r.mean, r.stddev, r.stddev * r.stddev, r.min, r.median,
+				1e9 / r.mean);
+			if (r.bytesPerOp > 0.0)
+				std::fprintf(out, ", \"mb_per_sec\": %.2f", r.bytesPerOp * 1e3 / r.mean);
+			std::fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+		}
+		std::fprintf(out, "  ]\n}\n");
+		if (out != stdout)
+			std::fclose(out);
+	}
+
+	// v / vt / vn / f 가 실제 모델과 비슷한 비율로 섞인 OBJ 줄들
+	std::vector<std::string>	makeObjLines(size_t count, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float>	coord(-10.0f, 10.0f);
+		std::vector<std::string>							lines;
+		char																	buffer[128];
+
+		for (size_t i = 0; i < count; i++)
+		{
+			int	index = 1 + static_cast<int>(i % 1000);
+			switch (i % 8)
+			{
+				case 0: case 1:
+					std::snprintf(buffer, sizeof(buffer), "v %f %f %f", coord(rng), coord(rng), coord(rng));
+					break;
+				case 2:
+					std::snprintf(buffer, sizeof(buffer), "vt %f %f 0.000000", coord(rng) / 20 + 0.5f, coord(rng) / 20 + 0.5f);
+					break;
+				case 3:
+					std::snprintf(buffer, sizeof(buffer), "vn %f %f %f", coord(rng) / 10, coord(rng) / 10, coord(rng) / 10);
+					break;
+				default:
+					std::snprintf(buffer, sizeof(buffer), "f %d/%d/%d %d/%d/%d %d/%d/%d", index, index, index,
+						index + 1, index + 1, index + 1, index + 2, index + 2, index + 2);
+					break;
+			}
+			lines.push_back(buffer);
+		}
+		return lines;
+	}
+
+	void	parseArgs(int argc, char* argv[], BenchOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string	arg = argv[i];
+			if (arg == "--filter" && i + 1 < argc)
+				options.filter = argv[++i];
+			else if (arg == "--samples" && i + 1 < argc)
+				options.samples = std::max(2, std::atoi(argv[++i]));
+			else if (arg == "--json" && i + 1 < argc)
+				options.jsonPath = argv[++i];
+			else
+				throw std::runtime_error("ERROR::BENCH::ARGS::FORMAT_ERROR\nusage: " + std::string(argv[0])
+					+ " [--filter <name>] [--samples <n>] [--json <file>|-]");
+		}
+	}
+}
+
+int	main(int argc, char* argv[])
+{
+	BenchOptions	options;
+	try
+	{
+		parseArgs(argc, argv, options);
+	}
+	catch (const std::exception& e)
+	{
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	std::mt19937								rng(42);
+	std::uniform_real_distribution<float>	angle(-360.0f, 360.0f);
+	std::vector<BenchResult>		results;
+
+	// 행렬 helper
+	float	a[16], b[16], m[16];
+	makeRotation(a, 30.0f, 45.0f, 60.0f);
+	makePerspective(b, 45.0f, 4.0f / 3.0f, 0.1f, 100.0f);
+	runCase(results, options, "multiplyMatrix", "op", 1, 0.0, [&]() {
+		multiplyMatrix(m, a, b);
+		a[12] = m[0];
+		g_sink = m[15];
+	});
+
+	float	degree = 0.0f;
+	runCase(results, options, "makeRotation", "op", 1, 0.0, [&]() {
+		degree += 0.5f;
+		makeRotation(m, degree, degree * 0.5f, -degree);
+		g_sink = m[5];
+	});
+
+	const size_t				BATCH = 1024;
+	std::vector<float>	ax(BATCH), ay(BATCH), az(BATCH), batch(BATCH * 16);
+	for (size_t i = 0; i < BATCH; i++)
+	{
+		ax[i] = angle(rng);
+		ay[i] = angle(rng);
+		az[i] = angle(rng);
+	}
+	runCase(results, options, "makeRotationBatch", "op", BATCH, 0.0, [&]() {
+		makeRotationBatch(batch.data(), ax.data(), ay.data(), az.data(), BATCH);
+		ax[0] = batch[5];
+		g_sink = batch[BATCH * 16 - 11];
+	});
+
+	float	eye = 5.0f;
+	runCase(results, options, "makeLookAt", "op", 1, 0.0, [&]() {
+		eye = eye > 50.0f ? 5.0f : eye + 0.001f;
+		makeLookAt(m, 1.0f, 2.0f, eye, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+		g_sink = m[14];
+	});
+
+	// loader kernel
+	const size_t				TRIANGLES = 4096;
+	std::vector<float>	triangles(TRIANGLES * 9);
+	for (size_t i = 0; i < triangles.size(); i++)
+		triangles[i] = angle(rng) / 36.0f;
+	runCase(results, options, "findNormal", "triangle", TRIANGLES, 36.0, [&]() {
+		float	sum = 0.0f;
+		for (size_t i = 0; i < TRIANGLES; i++)
+		{
+			const float*				t = &triangles[i * 9];
+			std::vector<float>	normal = findNormal(t, t + 3, t + 6);
+			sum += normal[0] + normal[1] + normal[2];
+		}
+		g_sink = sum;
+	});
+
+	const size_t				VERTICES = 65536;
+	std::vector<float>	source(VERTICES * 3), vertices;
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = angle(rng);
+	runCase(results, options, "shiftToCentre", "vertex", VERTICES, 12.0, [&]() {
+		vertices = source;
+		shiftToCentre(vertices);
+		g_sink = vertices[VERTICES];
+	});
+
+	std::vector<std::string>	lines = makeObjLines(8192, rng);
+	double										lineBytes = 0.0;
+	for (size_t i = 0; i < lines.size(); i++)
+		lineBytes += lines[i].size() + 1;
+	runCase(results, options, "parseObjLine", "line", lines.size(), lineBytes / lines.size(), [&]() {
+		ObjData			data;
+		std::string	mtlFile;
+		for (size_t i = 0; i < lines.size(); i++)
+			parseObjLine(lines[i], data, mtlFile);
+		g_sink = data.vertices.back() + static_cast<float>(data.faceData.size());
+	});
+
+	// occlusion culling : 화면 가운데를 덮는 격자 occluder (삼각형 1024 개) 를 그리고 작은 상자 256 개를 검사합니다.
+	std::vector<float>		grid;
+	std::vector<FaceData>	gridFaces;
+	for (int y = 0; y <= 16; y++)
+		for (int x = 0; x <= 32; x++)
+		{
+			grid.push_back(x / 32.0f - 0.5f);
+			grid.push_back(y / 32.0f - 0.25f);
+			grid.push_back(0.02f * ((x + y) % 2));
+		}
+	for (int y = 0; y < 16; y++)
+		for (int x = 0; x < 32; x++)
+		{
+			int	corner = y * 33 + x, quad[6] = { corner, corner + 1, corner + 34, corner, corner + 34, corner + 33 };
+			for (int k = 0; k < 6; k++)
+				gridFaces.push_back({quad[k], -1, -1});
+		}
+	std::vector<Vec4>	occluder;
+	Bounds						gridBounds = shiftToCentre(grid);
+	OcclusionBuffer::makeOccluder(grid, gridFaces, occluder);
+	Mat4	viewProjection = Mat4::perspective(45.0f, 2.0f, 0.1f, 100.0f) * Mat4::lookAt(0.0f, 0.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+	Mat4	occluderMVP = viewProjection * Mat4::translation(0.0f, 0.0f, 2.0f) * Mat4::scale(4.0f, 4.0f, 4.0f);
+	Bounds	box = { { -0.1f, -0.1f, -0.1f }, { 0.1f, 0.1f, 0.1f }, 0.18f };
+	std::vector<Mat4>	boxes;
+	for (int i = 0; i < 256; i++)
+		boxes.push_back(viewProjection * Mat4::translation(angle(rng) / 120.0f, angle(rng) / 240.0f, angle(rng) / 180.0f));
+	OcclusionBuffer&	occlusion = OcclusionBuffer::getInstance();
+	runCase(results, options, "occlusionFrame", "frame", 1, 0.0, [&]() {
+		occlusion.begin();
+		occlusion.addOccluder(occluderMVP, gridBounds, occluder);
+		occlusion.render();
+		int	hidden = 0;
+		for (size_t i = 0; i < boxes.size(); i++)
+			hidden += occlusion.isOccluded(boxes[i], box);
+		g_sink = static_cast<float>(hidden);
+	});
+
+	// 마우스 선택 : 울퉁불퉁한 구 (삼각형 131072 개) 의 BVH 를 만들고, 밖에서 가운데 쪽으로 광선을 쏩니다.
+	const int							RINGS = 256, SEGMENTS = 256;
+	std::vector<float>		sphere;
+	std::vector<FaceData>	sphereFaces;
+	for (int ring = 0; ring <= RINGS; ring++)
+		for (int segment = 0; segment <= SEGMENTS; segment++)
+		{
+			float	theta = static_cast<float>(M_PI) * ring / RINGS, phi = 2.0f * static_cast<float>(M_PI) * segment / SEGMENTS;
+			float	radius = 1.0f + 0.05f * std::sin(theta * 9.0f) * std::cos(phi * 7.0f);
+			sphere.push_back(radius * std::sin(theta) * std::cos(phi));
+			sphere.push_back(radius * std::cos(theta));
+			sphere.push_back(radius * std::sin(theta) * std::sin(phi));
+		}
+	for (int ring = 0; ring < RINGS; ring++)
+		for (int segment = 0; segment < SEGMENTS; segment++)
+		{
+			int	corner = ring * (SEGMENTS + 1) + segment;
+			int	quad[6] = { corner, corner + 1, corner + SEGMENTS + 2, corner, corner + SEGMENTS + 2, corner + SEGMENTS + 1 };
+			for (int k = 0; k < 6; k++)
+				sphereFaces.push_back({quad[k], -1, -1});
+		}
+	TriangleBVH	bvh;
+	runCase(results, options, "triangleBVHBuild", "triangle", sphereFaces.size() / 3, 0.0, [&]() {
+		bvh.build(sphere, sphereFaces);
+		g_sink = static_cast<float>(bvh.nodeCount());
+	});
+
+	const size_t				RAYS = 1024;
+	std::vector<float>	rays(RAYS * 6);
+	for (size_t i = 0; i < RAYS; i++)
+	{
+		float	from[3] = { angle(rng), angle(rng), angle(rng) }, length = 0.0f;
+		for (int axis = 0; axis < 3; axis++)
+			length += from[axis] * from[axis];
+		length = std::sqrt(length);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			rays[i * 6 + axis] = from[axis] / length * 3.0f;
+			rays[i * 6 + 3 + axis] = angle(rng) / 720.0f - rays[i * 6 + axis];
+		}
+	}
+	runCase(results, options, "triangleBVHRay", "ray", RAYS, 0.0, [&]() {
+		float	sum = 0.0f;
+		for (size_t i = 0; i < RAYS; i++)
+		{
+			float	distance = 1.0f;
+			bvh.intersect(&rays[i * 6], &rays[i * 6 + 3], distance);
+			sum += distance;
+		}
+		g_sink = sum;
+	});
+
+	if (!options.jsonPath.empty())
+	{
+		try
+		{
+			writeJson(results, options);
+		}
+		catch (const std::exception& e)
+		{
+			std::fprintf(stderr, "%s\n", e.what());
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,165 @@
+// GL 없이 도는 검사 : MatrixExpr 의 constexpr builder 와 식이 실행 중 helper 와 같은 값을 내는지 봅니다.
+// usage: ./scop_check (make check)
+// fov 45 의 카메라는 bit 까지 같아야 하고, 다른 fov 는 tan 이 1 ulp (f 는 2 ulp) 까지 다를 수 있습니다. 틀리면 1 로 끝납니다.
+
+#include "utils.hpp"
+#include "MatrixExpr.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <random>
+
+namespace
+{
+	int	g_failures = 0;
+
+	// 같은 부호의 두 float 사이의 ulp 수
+	long	ulpDistance(float a, float b)
+	{
+		int32_t	ia, ib;
+		std::memcpy(&ia, &a, sizeof(a));
+		std::memcpy(&ib, &b, sizeof(b));
+		if (ia < 0)
+			ia = INT32_MIN - ia;
+		if (ib < 0)
+			ib = INT32_MIN - ib;
+		return std::labs(static_cast<long>(ia) - static_cast<long>(ib));
+	}
+
+	long	maxUlp(const float* a, const float* b)
+	{
+		long	worst = 0;
+		for (int i = 0; i < 16; i++)
+			worst = std::max(worst, ulpDistance(a[i], b[i]));
+		return worst;
+	}
+
+	void	report(const char* name, int mismatches, int total)
+	{
+		std::printf("%-32s %s (%d / %d mismatched)\n", name, mismatches ? "FAIL" : "ok", mismatches, total);
+		if (mismatches)
+			g_failures++;
+	}
+
+	// main.cpp 의 cameraViewProjection() 과 같은 식
+	static constexpr TMat<4, 4>	CAMERA_VIEW = constLookAt(0.0f, 0.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+	static constexpr TMat<4, 4>	CAMERA_PROJECTION = constPerspective(45.0f, 1.0f, 0.1f, 100.0f);
+
+	void	checkCamera()
+	{
+		const float	aspects[] = { 800.0f / 600.0f, 1.0f, 1920.0f / 1080.0f, 600.0f / 800.0f, 2560.0f / 1440.0f };
+		int					mismatches = 0;
+		for (size_t i = 0; i < sizeof(aspects) / sizeof(aspects[0]); i++)
+		{
+			TMat<4, 4>	proj = CAMERA_PROJECTION;
+			proj.at(0, 0) = CAMERA_PROJECTION(1, 1) / aspects[i];
+			Mat4				folded = toMat4(proj * CAMERA_VIEW);
+
+			float	p[16], v[16], expected[16];
+			makePerspective(p, 45.0f, aspects[i], 0.1f, 100.0f);
+			makeLookAt(v, 0.0f, 0.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+			multiplyMatrix(expected, p, v);
+			mismatches += std::memcmp(folded.m, expected, sizeof(expected)) != 0;
+		}
+		report("camera view-projection", mismatches, static_cast<int>(sizeof(aspects) / sizeof(aspects[0])));
+	}
+
+	void	checkLookAt(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float>	coord(-50.0f, 50.0f);
+		const int															COUNT = 10000;
+		int																		mismatches = 0;
+		for (int i = 0; i < COUNT; i++)
+		{
+			float	p[9];
+			for (int k = 0; k < 9; k++)
+				p[k] = coord(rng);
+			if (i % 2)
+			{
+				p[6] = 0.0f;
+				p[7] = 1.0f;
+				p[8] = 0.0f;
+			}
+			Mat4	folded = toMat4(constLookAt(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8]));
+			float	expected[16];
+			makeLookAt(expected, p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8]);
+			mismatches += std::memcmp(folded.m, expected, sizeof(expected)) != 0;
+		}
+		report("constLookAt", mismatches, COUNT);
+	}
+
+	void	checkPerspective()
+	{
+		const float	aspects[] = { 800.0f / 600.0f, 1.0f, 0.5f };
+		int					total = 0, mismatches = 0, differing = 0;
+		for (int fov = 1; fov < 180; fov++)
+		{
+			float	x = static_cast<float>(fov) * 0.5f * 3.1415926f / 180.0f;
+			long	tanUlps = ulpDistance(constTan(x), tanf(x));
+			differing += tanUlps != 0;
+			mismatches += fov == 45 ? tanUlps != 0 : tanUlps > 1;
+			for (size_t i = 0; i < sizeof(aspects) / sizeof(aspects[0]); i++)
+			{
+				Mat4	folded = toMat4(constPerspective(static_cast<float>(fov), aspects[i], 0.1f, 100.0f));
+				float	expected[16];
+				makePerspective(expected, static_cast<float>(fov), aspects[i], 0.1f, 100.0f);
+				long	ulps = maxUlp(folded.m, expected);
+				total++;
+				mismatches += fov == 45 ? ulps != 0 : ulps > 2;
+			}
+		}
+		report("constPerspective", mismatches, total);
+		std::printf("%-32s %d / 179 fovs where libm tanf differs by 1 ulp\n", "", differing);
+	}
+
+	// a * b * c (식 하나) 와 multiplyMatrix 를 차례로 부른 결과
+	void	checkProducts(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float>	value(-10.0f, 10.0f), angle(-360.0f, 360.0f);
+		const int															COUNT = 10000;
+		int																		mismatches = 0;
+		for (int i = 0; i < COUNT; i++)
+		{
+			TMat<4, 4>	a, b, c, d;
+			for (int k = 0; k < 16; k++)
+			{
+				a.m[k] = value(rng);
+				b.m[k] = value(rng);
+				c.m[k] = value(rng);
+			}
+			float	x = value(rng), y = value(rng), z = value(rng);
+			TMat<4, 4>	translation = constTranslation(x, y, z), scale = constScale(y, z, x);
+			d = translation * scale;
+
+			float	ab[16], abc[16], abcd[16], t[16], s[16], ts[16];
+			multiplyMatrix(ab, a.m, b.m);
+			multiplyMatrix(abc, ab, c.m);
+			makeTranslation(t, x, y, z);
+			makeScale(s, y, z, x);
+			multiplyMatrix(ts, t, s);
+			multiplyMatrix(abcd, abc, ts);
+
+			Mat4	folded2 = toMat4(a * b), folded3 = toMat4(a * b * c), folded4 = toMat4(a * b * c * d);
+			mismatches += std::memcmp(folded2.m, ab, sizeof(ab)) != 0 || std::memcmp(folded3.m, abc, sizeof(abc)) != 0
+				|| std::memcmp(folded4.m, abcd, sizeof(abcd)) != 0 || std::memcmp(d.m, ts, sizeof(ts)) != 0;
+		}
+		report("chained products", mismatches, COUNT);
+	}
+}
+
+int	main()
+{
+	std::mt19937	rng(42);
+	checkCamera();
+	checkLookAt(rng);
+	checkPerspective();
+	checkProducts(rng);
+	if (g_failures)
+	{
+		std::printf("%d check group(s) failed\n", g_failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,397 @@
+#include "BCEncoder.hpp"
+
+unsigned int	bcBlockBytes(BCFormat format)
+{
+	return format == BC_FORMAT_BC1 ? 8 : 16;
+}
+
+size_t	bcEncodedSize(unsigned int width, unsigned int height, BCFormat format)
+{
+	size_t	blocksX = (width + 3) / 4;
+	size_t	blocksY = (height + 3) / 4;
+	return blocksX * blocksY * bcBlockBytes(format);
+}
+
+namespace
+{
+	// 4x4 블록을 가져옵니다. 이미지 경계 밖의 픽셀은 가장자리 픽셀을 복제합니다.
+	void	fetchBlock(const unsigned char* rgba, unsigned int width, unsigned int height,
+						unsigned int bx, unsigned int by, unsigned char block[64])
+	{
+		for (unsigned int y = 0; y < 4; y++)
+		{
+			unsigned int	sy = std::min(by * 4 + y, height - 1);
+			if (bx * 4 + 3 < width)
+			{
+				std::memcpy(block + y * 16, rgba + (sy * width + bx * 4) * 4, 16);
+				continue;
+			}
+			for (unsigned int x = 0; x < 4; x++)
+			{
+				unsigned int	sx = std::min(bx * 4 + x, width - 1);
+				std::memcpy(block + (y * 4 + x) * 4, rgba + (sy * width + sx) * 4, 4);
+			}
+		}
+	}
+
+	unsigned short	pack565(const float c[3])
+	{
+		int	r = static_cast<int>(c[0] * (31.0f / 255.0f) + 0.5f);
+		int	g = static_cast<int>(c[1] * (63.0f / 255.0f) + 0.5f);
+		int	b = static_cast<int>(c[2] * (31.0f / 255.0f) + 0.5f);
+		r = std::max(0, std::min(31, r));
+		g = std::max(0, std::min(63, g));
+		b = std::max(0, std::min(31, b));
+		return static_cast<unsigned short>((r << 11) | (g << 5) | b);
+	}
+
+	void	unpack565(unsigned short v, float c[3])
+	{
+		int	r = (v >> 11) & 31;
+		int	g = (v >> 5) & 63;
+		int	b = v & 31;
+		c[0] = static_cast<float>((r << 3) | (r >> 2));
+		c[1] = static_cast<float>((g << 2) | (g >> 4));
+		c[2] = static_cast<float>((b << 3) | (b >> 2));
+	}
+
+	// 16 픽셀 각각에 가장 가까운 팔레트 색을 찾습니다. (2bit index * 16)
+	unsigned int	selectIndices(const float* r, const float* g, const float* b,
+								const float palette[4][3], float& error)
+	{
+		unsigned int	indices = 0;
+		error = 0.0f;
+#if defined(__SSE2__)
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128	pr = _mm_load_ps(r + i);
+			__m128	pg = _mm_load_ps(g + i);
+			__m128	pb = _mm_load_ps(b + i);
+			__m128	best = _mm_set1_ps(3.4e38f);
+			__m128i	bestIdx = _mm_setzero_si128();
+			for (int k = 0; k < 4; k++)
+			{
+				__m128	dr = _mm_sub_ps(pr, _mm_set1_ps(palette[k][0]));
+				__m128	dg = _mm_sub_ps(pg, _mm_set1_ps(palette[k][1]));
+				__m128	db = _mm_sub_ps(pb, _mm_set1_ps(palette[k][2]));
+				__m128	d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+				__m128i	mask = _mm_castps_si128(_mm_cmplt_ps(d, best));
+				best = _mm_min_ps(d, best);
+				bestIdx = _mm_or_si128(_mm_andnot_si128(mask, bestIdx), _mm_and_si128(mask, _mm_set1_epi32(k)));
+			}
+			alignas(16) int		idx[4];
+			alignas(16) float	err[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(idx), bestIdx);
+			_mm_store_ps(err, best);
+			for (int j = 0; j < 4; j++)
+			{
+				indices |= static_cast<unsigned int>(idx[j]) << (2 * (i + j));
+				error += err[j];
+			}
+		}
+#else
+		for (int i = 0; i < 16; i++)
+		{
+			float	best = 3.4e38f;
+			int		bestIdx = 0;
+			for (int k = 0; k < 4; k++)
+			{
+				float	dr = r[i] - palette[k][0];
+				float	dg = g[i] - palette[k][1];
+				float	db = b[i] - palette[k][2];
+				float	d = dr * dr + dg * dg + db * db;
+				if (d < best)
+				{
+					best = d;
+					bestIdx = k;
+				}
+			}
+			indices |= static_cast<unsigned int>(bestIdx) << (2 * i);
+			error += best;
+		}
+#endif
+		return indices;
+	}
+
+	// 양 끝 색을 565로 양자화하고 팔레트를 만든 뒤 index를 고릅니다.
+	float	quantizeBC1(const float* r, const float* g, const float* b,
+					const float end0[3], const float end1[3], unsigned char out[8])
+	{
+		unsigned short	c0 = pack565(end0);
+		unsigned short	c1 = pack565(end1);
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		float	palette[4][3];
+		unpack565(c0, palette[0]);
+		unpack565(c1, palette[1]);
+		for (int i = 0; i < 3; i++)
+		{
+			palette[2][i] = (2.0f * palette[0][i] + palette[1][i]) / 3.0f;
+			palette[3][i] = (palette[0][i] + 2.0f * palette[1][i]) / 3.0f;
+		}
+
+		// c0 == c1 이면 팔레트가 모두 같은 색이므로 index 는 전부 0 이 됩니다.
+		float			error;
+		unsigned int	indices = selectIndices(r, g, b, palette, error);
+
+		out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+		out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+		out[4] = indices & 0xFF;         out[5] = (indices >> 8) & 0xFF;
+		out[6] = (indices >> 16) & 0xFF; out[7] = (indices >> 24) & 0xFF;
+		return error;
+	}
+
+	void	boundingBoxEndpoints(const unsigned char block[64], float end0[3], float end1[3])
+	{
+		unsigned char	lo[4], hi[4];
+#if defined(__SSE2__)
+		__m128i	row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+		__m128i	row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16));
+		__m128i	row2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32));
+		__m128i	row3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 48));
+		__m128i	mn = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+		__m128i	mx = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+		mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 8));
+		mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 8));
+		mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 4));
+		mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 4));
+		int	mnBits = _mm_cvtsi128_si32(mn);
+		int	mxBits = _mm_cvtsi128_si32(mx);
+		std::memcpy(lo, &mnBits, 4);
+		std::memcpy(hi, &mxBits, 4);
+#else
+		for (int c = 0; c < 4; c++)
+		{
+			lo[c] = 255;
+			hi[c] = 0;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				lo[c] = std::min(lo[c], block[i * 4 + c]);
+				hi[c] = std::max(hi[c], block[i * 4 + c]);
+			}
+		}
+#endif
+		// 양 끝을 조금 안쪽으로 당겨서 평균 오차를 줄입니다.
+		for (int c = 0; c < 3; c++)
+		{
+			float	inset = (hi[c] - lo[c]) / 16.0f;
+			end0[c] = hi[c] - inset;
+			end1[c] = lo[c] + inset;
+		}
+	}
+
+	void	principalAxisEndpoints(const float* r, const float* g, const float* b, float end0[3], float end1[3])
+	{
+		float	mean[3] = {0, 0, 0};
+		for (int i = 0; i < 16; i++)
+		{
+			mean[0] += r[i];
+			mean[1] += g[i];
+			mean[2] += b[i];
+		}
+		for (int c = 0; c < 3; c++)
+			mean[c] /= 16.0f;
+
+		// 공분산 행렬 (대칭)
+		float	cov[6] = {0, 0, 0, 0, 0, 0};
+		for (int i = 0; i < 16; i++)
+		{
+			float	dr = r[i] - mean[0], dg = g[i] - mean[1], db = b[i] - mean[2];
+			cov[0] += dr * dr; cov[1] += dr * dg; cov[2] += dr * db;
+			cov[3] += dg * dg; cov[4] += dg * db; cov[5] += db * db;
+		}
+
+		// power iteration 으로 주축을 구합니다.
+		float	axis[3] = {1.0f, 1.0f, 1.0f};
+		for (int iter = 0; iter < 4; iter++)
+		{
+			float	next[3] = {
+				cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+				cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+				cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]
+			};
+			float	len = std::max(std::fabs(next[0]), std::max(std::fabs(next[1]), std::fabs(next[2])));
+			if (len < 1e-6f)
+				break ;
+			for (int c = 0; c < 3; c++)
+				axis[c] = next[c] / len;
+		}
+
+		float	minT = 3.4e38f, maxT = -3.4e38f;
+		for (int i = 0; i < 16; i++)
+		{
+			float	t = (r[i] - mean[0]) * axis[0] + (g[i] - mean[1]) * axis[1] + (b[i] - mean[2]) * axis[2];
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+		float	lenSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		if (lenSq > 0.0f)
+		{
+			minT /= lenSq;
+			maxT /= lenSq;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			end0[c] = std::max(0.0f, std::min(255.0f, mean[c] + axis[c] * maxT));
+			end1[c] = std::max(0.0f, std::min(255.0f, mean[c] + axis[c] * minT));
+		}
+	}
+
+	// 현재 index 배정으로 양 끝 색을 최소제곱으로 다시 맞춥니다.
+	bool	refineEndpoints(const float* r, const float* g, const float* b,
+						const unsigned char encoded[8], float end0[3], float end1[3])
+	{
+		static const float	weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+		unsigned int	indices = encoded[4] | (encoded[5] << 8) | (encoded[6] << 16) | (static_cast<unsigned int>(encoded[7]) << 24);
+		float			aa = 0, bb = 0, ab = 0;
+		float			ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+
+		for (int i = 0; i < 16; i++)
+		{
+			float	w = weights[(indices >> (2 * i)) & 3];
+			float	v = 1.0f - w;
+			float	px[3] = {r[i], g[i], b[i]};
+			aa += w * w; bb += v * v; ab += w * v;
+			for (int c = 0; c < 3; c++)
+			{
+				ax[c] += w * px[c];
+				bx[c] += v * px[c];
+			}
+		}
+		float	det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f)
+			return false;
+		for (int c = 0; c < 3; c++)
+		{
+			end0[c] = std::max(0.0f, std::min(255.0f, (ax[c] * bb - bx[c] * ab) / det));
+			end1[c] = std::max(0.0f, std::min(255.0f, (bx[c] * aa - ax[c] * ab) / det));
+		}
+		return true;
+	}
+
+	void	encodeBC1Block(const unsigned char block[64], BCQuality quality, unsigned char out[8])
+	{
+		alignas(16) float	r[16], g[16], b[16];
+		for (int i = 0; i < 16; i++)
+		{
+			r[i] = block[i * 4 + 0];
+			g[i] = block[i * 4 + 1];
+			b[i] = block[i * 4 + 2];
+		}
+
+		float	end0[3], end1[3];
+		if (quality == BC_QUALITY_FAST)
+		{
+			boundingBoxEndpoints(block, end0, end1);
+			quantizeBC1(r, g, b, end0, end1, out);
+			return ;
+		}
+
+		principalAxisEndpoints(r, g, b, end0, end1);
+		float	error = quantizeBC1(r, g, b, end0, end1, out);
+		if (quality != BC_QUALITY_HIGH)
+			return ;
+
+		for (int iter = 0; iter < 2 && error > 0.0f; iter++)
+		{
+			unsigned char	candidate[8];
+			if (!refineEndpoints(r, g, b, out, end0, end1))
+				break ;
+			float	candidateError = quantizeBC1(r, g, b, end0, end1, candidate);
+			if (candidateError >= error)
+				break ;
+			error = candidateError;
+			std::memcpy(out, candidate, 8);
+		}
+	}
+
+	// 한 채널 블록 (BC3 alpha, BC5 red / green). 8 단계 보간 모드만 사용합니다.
+	void	encodeBC4Block(const unsigned char block[64], int channel, unsigned char out[8])
+	{
+		unsigned char	lo = 255, hi = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			lo = std::min(lo, block[i * 4 + channel]);
+			hi = std::max(hi, block[i * 4 + channel]);
+		}
+
+		unsigned long long	indices = 0;
+		if (hi != lo)
+		{
+			float	scale = 7.0f / (hi - lo);
+			for (int i = 0; i < 16; i++)
+			{
+				// t : 0 (= lo) ~ 7 (= hi), index 0 = hi, 1 = lo, 2 ~ 7 = hi 에서 lo 쪽으로 보간
+				int	t = static_cast<int>((block[i * 4 + channel] - lo) * scale + 0.5f);
+				int	index = t == 7 ? 0 : (t == 0 ? 1 : 8 - t);
+				indices |= static_cast<unsigned long long>(index) << (3 * i);
+			}
+		}
+		out[0] = hi;
+		out[1] = lo;
+		for (int i = 0; i < 6; i++)
+			out[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+	}
+
+	void	encodeRows(const unsigned char* rgba, unsigned int width, unsigned int height,
+					BCFormat format, BCQuality quality, unsigned char* out,
+					unsigned int rowBegin, unsigned int rowEnd)
+	{
+		unsigned int	blocksX = (width + 3) / 4;
+		unsigned int	blockBytes = bcBlockBytes(format);
+		unsigned char	block[64];
+
+		for (unsigned int by = rowBegin; by < rowEnd; by++)
+		{
+			for (unsigned int bx = 0; bx < blocksX; bx++)
+			{
+				unsigned char*	dst = out + (static_cast<size_t>(by) * blocksX + bx) * blockBytes;
+				fetchBlock(rgba, width, height, bx, by, block);
+				switch (format)
+				{
+					case BC_FORMAT_BC1:
+						encodeBC1Block(block, quality, dst);
+						break;
+					case BC_FORMAT_BC3:
+						encodeBC4Block(block, 3, dst);
+						encodeBC1Block(block, quality, dst + 8);
+						break;
+					case BC_FORMAT_BC5:
+						encodeBC4Block(block, 0, dst);
+						encodeBC4Block(block, 1, dst + 8);
+						break;
+				}
+			}
+		}
+	}
+}
+
+void	encodeBC(const unsigned char* rgba, unsigned int width, unsigned int height,
+				BCFormat format, BCQuality quality, unsigned char* out, unsigned int threadCount)
+{
+	if (width == 0 || height == 0)
+		return ;
+
+	unsigned int	blocksY = (height + 3) / 4;
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	threadCount = std::min(threadCount, blocksY);
+
+	// 블록 행 단위로 나눠서 스레드마다 인코딩합니다.
+	std::vector<std::thread>	workers;
+	unsigned int				rowsPerThread = (blocksY + threadCount - 1) / threadCount;
+	for (unsigned int t = 1; t < threadCount; t++)
+	{
+		unsigned int	begin = t * rowsPerThread;
+		unsigned int	end = std::min(blocksY, begin + rowsPerThread);
+		if (begin < end)
+			workers.push_back(std::thread(encodeRows, rgba, width, height, format, quality, out, begin, end));
+	}
+	encodeRows(rgba, width, height, format, quality, out, 0, std::min(blocksY, rowsPerThread));
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
@@ -0,0 +1,41 @@
+#ifndef __BCENCODER_HPP__
+# define __BCENCODER_HPP__
+
+# include <vector>
+# include <cstring>
+# include <cmath>
+# include <thread>
+# include <algorithm>
+
+# if defined(__SSE2__)
+#  include <emmintrin.h>
+# endif
+
+// 블록 압축 포맷
+// ------------
+// BC1 : RGB, 4x4 블록당 8 byte  (diffuse)
+// BC3 : RGBA, 4x4 블록당 16 byte (alpha 가 있는 diffuse)
+// BC5 : RG, 4x4 블록당 16 byte  (bump / normal)
+enum	BCFormat {
+	BC_FORMAT_BC1,
+	BC_FORMAT_BC3,
+	BC_FORMAT_BC5
+};
+
+// FAST   : bounding box 양 끝
+// NORMAL : 주축 양 끝
+// HIGH   : 주축 + least squares 로 끝점 보정
+enum	BCQuality {
+	BC_QUALITY_FAST,
+	BC_QUALITY_NORMAL,
+	BC_QUALITY_HIGH
+};
+
+unsigned int	bcBlockBytes(BCFormat format);
+size_t				bcEncodedSize(unsigned int width, unsigned int height, BCFormat format);
+
+// rgba 는 width * height * 4 byte, out 은 bcEncodedSize() byte, threadCount 가 0 이면 코어 수만큼
+void					encodeBC(const unsigned char* rgba, unsigned int width, unsigned int height,
+								BCFormat format, BCQuality quality, unsigned char* out, unsigned int threadCount = 0);
+
+#endif
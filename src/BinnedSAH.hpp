@@ -0,0 +1,75 @@
+#ifndef __BINNEDSAH_HPP__
+# define __BINNEDSAH_HPP__
+
+# include <algorithm>
+# include <cstddef>
+
+// SceneTree 와 TriangleBVH 가 같이 쓰는 binned SAH : 상자들을 중심의 bin 에 넣은 뒤, bin 경계마다 나눈 cost 를 비교합니다.
+
+// 상자 겉넓이의 절반 : cost 는 서로 비교만 하므로 충분합니다.
+inline float	boxArea(const float* min, const float* max)
+{
+	float	dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+	return dx * dy + dy * dz + dz * dx;
+}
+
+struct	SAHBin {
+	float		min[3];
+	float		max[3];
+	size_t	count;
+
+	void	reset()
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			min[axis] = 1e30f;
+			max[axis] = -1e30f;
+		}
+		count = 0;
+	}
+
+	void	grow(const float* otherMin, const float* otherMax)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			min[axis] = std::min(min[axis], otherMin[axis]);
+			max[axis] = std::max(max[axis], otherMax[axis]);
+		}
+	}
+};
+
+// 한 축의 bin 들에서 가장 싼 경계 split (bins[0, split) 이 왼쪽) 을 돌려주고 그 cost 를 cost 에 넣습니다.
+// count 는 bin 에 든 상자 수의 합이고, 한쪽이 비는 경계는 건너뜁니다. 나눌 경계가 없으면 0 입니다.
+template <size_t BINS>
+inline size_t	findSAHSplit(const SAHBin (&bins)[BINS], size_t count, float& cost)
+{
+	// 오른쪽에서부터 쌓은 cost 를 먼저 구해 두고, 왼쪽에서 쌓으면서 비교합니다.
+	float		rightCost[BINS];
+	SAHBin	right;
+	right.reset();
+	for (size_t b = BINS - 1; b > 0; b--)
+	{
+		right.grow(bins[b].min, bins[b].max);
+		right.count += bins[b].count;
+		rightCost[b] = right.count ? boxArea(right.min, right.max) * right.count : 0.0f;
+	}
+	size_t	best = 0;
+	SAHBin	left;
+	left.reset();
+	for (size_t split = 1; split < BINS; split++)
+	{
+		left.grow(bins[split - 1].min, bins[split - 1].max);
+		left.count += bins[split - 1].count;
+		if (left.count == 0 || left.count == count)
+			continue ;
+		float	splitCost = boxArea(left.min, left.max) * left.count + rightCost[split];
+		if (best == 0 || splitCost < cost)
+		{
+			best = split;
+			cost = splitCost;
+		}
+	}
+	return best;
+}
+
+#endif
@@ -0,0 +1,372 @@
+#include "BmpDecoder.hpp"
+
+namespace
+{
+	const unsigned int	MAX_BMP_SIZE = 1u << 16;
+	const unsigned int	BMP_ALPHABITFIELDS = 6;
+
+	// 파일의 little endian 값을 byte 단위로 읽습니다. (정렬되지 않은 주소를 int 로 읽지 않게)
+	unsigned int	readU16(const unsigned char* p)
+	{
+		return p[0] | (p[1] << 8);
+	}
+
+	unsigned int	readU32(const unsigned char* p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+	}
+
+	void	wrongFormat(const char* message)
+	{
+		throw std::runtime_error(std::string("ERROR::LOADER::BMP::WRONG_FORMAT\n") + message);
+	}
+
+	struct	Channel {
+		unsigned int	mask;
+		unsigned int	shift;
+		unsigned int	bits;
+	};
+
+	Channel	channelOf(unsigned int mask)
+	{
+		Channel	channel = {mask, 0, 0};
+		if (!mask)
+			return channel;
+		while (!((mask >> channel.shift) & 1))
+			channel.shift++;
+		while (channel.shift + channel.bits < 32 && ((mask >> (channel.shift + channel.bits)) & 1))
+			channel.bits++;
+		return channel;
+	}
+
+	// mask 로 꺼낸 값을 8 bit 로 늘리거나 줄입니다. mask 가 없는 alpha 는 불투명입니다.
+	unsigned char	expand(unsigned int pixel, const Channel& channel, unsigned char missing)
+	{
+		if (!channel.bits)
+			return missing;
+		unsigned int	value = (pixel & channel.mask) >> channel.shift;
+		if (channel.bits >= 8)
+			return static_cast<unsigned char>(value >> (channel.bits - 8));
+		unsigned int	max = (1u << channel.bits) - 1;
+		return static_cast<unsigned char>((value * 255 + max / 2) / max);
+	}
+
+	// BGR -> RGBA
+	void	swizzle24(const unsigned char* src, unsigned char* dst, unsigned int width)
+	{
+		unsigned int	x = 0;
+#if defined(__SSE2__)
+		const __m128i	greenMask = _mm_set1_epi32(0x0000FF00);
+		const __m128i	redBlueMask = _mm_set1_epi32(0x00FF00FF);
+		const __m128i	alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+		// 16 byte 를 읽으므로 행 끝에서 2 픽셀 이상 남았을 때만 씁니다.
+		for (; x + 6 <= width; x += 4)
+		{
+			__m128i	bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+			// 픽셀마다 3 byte 씩 밀어서 dword 하나에 B G R (+ 다음 픽셀의 1 byte) 가 오게 합니다.
+			__m128i	pixels01 = _mm_unpacklo_epi32(bytes, _mm_srli_si128(bytes, 3));
+			__m128i	pixels23 = _mm_unpacklo_epi32(_mm_srli_si128(bytes, 6), _mm_srli_si128(bytes, 9));
+			__m128i	pixels = _mm_unpacklo_epi64(pixels01, pixels23);
+			__m128i	redBlue = _mm_and_si128(pixels, redBlueMask);
+			redBlue = _mm_shufflehi_epi16(_mm_shufflelo_epi16(redBlue, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			__m128i	out = _mm_or_si128(_mm_or_si128(redBlue, _mm_and_si128(pixels, greenMask)), alpha);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), out);
+		}
+#endif
+		for (; x < width; x++)
+		{
+			dst[x * 4 + 0] = src[x * 3 + 2];
+			dst[x * 4 + 1] = src[x * 3 + 1];
+			dst[x * 4 + 2] = src[x * 3 + 0];
+			dst[x * 4 + 3] = 255;
+		}
+	}
+
+	// 채널마다 8 bit 인 32 bit 픽셀 (BGRX, BGRA, RGBA ...) -> RGBA
+	void	swizzle32(const unsigned char* src, unsigned char* dst, unsigned int width, const Channel channels[4])
+	{
+		unsigned int	x = 0;
+#if defined(__SSE2__)
+		const __m128i	byteMask = _mm_set1_epi32(0xFF);
+		const __m128i	opaque = _mm_set1_epi32(channels[3].bits ? 0 : static_cast<int>(0xFF000000u));
+		__m128i				shifts[4];
+		for (int c = 0; c < 4; c++)
+			shifts[c] = _mm_cvtsi32_si128(channels[c].shift);
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i	pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+			__m128i	r = _mm_and_si128(_mm_srl_epi32(pixels, shifts[0]), byteMask);
+			__m128i	g = _mm_and_si128(_mm_srl_epi32(pixels, shifts[1]), byteMask);
+			__m128i	b = _mm_and_si128(_mm_srl_epi32(pixels, shifts[2]), byteMask);
+			__m128i	out = _mm_or_si128(r, _mm_or_si128(_mm_slli_epi32(g, 8), _mm_slli_epi32(b, 16)));
+			if (channels[3].bits)
+				out = _mm_or_si128(out, _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(pixels, shifts[3]), byteMask), 24));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_or_si128(out, opaque));
+		}
+#endif
+		for (; x < width; x++)
+		{
+			unsigned int	pixel = readU32(src + x * 4);
+			for (int c = 0; c < 4; c++)
+				dst[x * 4 + c] = expand(pixel, channels[c], 255);
+		}
+	}
+
+	// 16 bit, 또는 채널이 8 bit 가 아닌 32 bit (10:10:10:2 등)
+	void	expandBitfields(const unsigned char* src, unsigned char* dst, unsigned int width, unsigned int bytes,
+						const Channel channels[4])
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			unsigned int	pixel = bytes == 2 ? readU16(src + x * 2) : readU32(src + x * 4);
+			for (int c = 0; c < 4; c++)
+				dst[x * 4 + c] = expand(pixel, channels[c], 255);
+		}
+	}
+
+	void	expandPalette(const BMPInfo& info, const unsigned char* src, unsigned char* dst)
+	{
+		unsigned int	perByte = 8 / info.bitCount;
+		unsigned int	mask = (1u << info.bitCount) - 1;
+		for (unsigned int x = 0; x < info.width; x++)
+		{
+			// 왼쪽 픽셀이 byte 의 높은 bit 에 있습니다.
+			unsigned int	shift = (perByte - 1 - x % perByte) * info.bitCount;
+			unsigned int	index = (src[x / perByte] >> shift) & mask;
+			std::memcpy(dst + x * 4, info.palette[index], 4);
+		}
+	}
+
+	bool	isByteChannels(const Channel channels[4])
+	{
+		for (int c = 0; c < 4; c++)
+			if (channels[c].mask && (channels[c].bits != 8 || channels[c].shift % 8))
+				return false;
+		return channels[0].mask && channels[1].mask && channels[2].mask;
+	}
+
+	void	decodeRLE8(const unsigned char* file, size_t size, const BMPInfo& info, unsigned char* rgba)
+	{
+		// 건너뛴 (delta, 행 끝) 픽셀은 불투명한 검정입니다.
+		for (size_t i = 0; i < static_cast<size_t>(info.width) * info.height; i++)
+		{
+			rgba[i * 4 + 0] = 0;
+			rgba[i * 4 + 1] = 0;
+			rgba[i * 4 + 2] = 0;
+			rgba[i * 4 + 3] = 255;
+		}
+
+		size_t				pos = info.dataOffset;
+		unsigned int	x = 0, y = 0;
+		while (pos + 1 < size && y < info.height)
+		{
+			unsigned int	count = file[pos], value = file[pos + 1];
+			pos += 2;
+			if (count > 0)
+			{
+				// 같은 index 를 count 번
+				for (unsigned int i = 0; i < count; i++, x++)
+					if (x < info.width)
+						std::memcpy(rgba + (static_cast<size_t>(y) * info.width + x) * 4, info.palette[value], 4);
+			}
+			else if (value == 0)
+			{
+				x = 0;
+				y++;
+			}
+			else if (value == 1)
+				break ;
+			else if (value == 2)
+			{
+				if (pos + 1 >= size)
+					break ;
+				x += file[pos];
+				y += file[pos + 1];
+				pos += 2;
+			}
+			else
+			{
+				// value 개의 index 가 그대로 이어지고, 2 byte 단위로 채워집니다.
+				if (pos + value > size)
+					wrongFormat("truncated rle data.");
+				for (unsigned int i = 0; i < value; i++, x++)
+					if (x < info.width)
+						std::memcpy(rgba + (static_cast<size_t>(y) * info.width + x) * 4, info.palette[file[pos + i]], 4);
+				pos += (value + 1) & ~1u;
+			}
+		}
+	}
+
+	// 헤더의 크기만 믿고 출력 버퍼를 잡지 않도록, 픽셀 데이터가 그만큼 있는지 먼저 봅니다.
+	// 무압축은 모든 행이 (마지막 행은 padding 없이) 있어야 합니다.
+	// RLE8 은 2 byte run 하나가 최대 255 픽셀이므로, 그만큼도 안 되는 데이터는 거절합니다.
+	// (delta / 끝 표시로 대부분을 비워 두는 아주 큰 파일도 여기서 거절됩니다)
+	void	checkBMPData(size_t size, const BMPInfo& info)
+	{
+		if (info.dataOffset >= size)
+			wrongFormat("image data not found.");
+		size_t	available = size - info.dataOffset;
+		if (info.compression == BMP_RLE8)
+		{
+			size_t	pixels = static_cast<size_t>(info.width) * info.height;
+			if (available < (pixels + 254) / 255 * 2)
+				wrongFormat("truncated rle data.");
+			return ;
+		}
+		size_t	lastRow = (static_cast<size_t>(info.width) * info.bitCount + 7) / 8;
+		if (info.rowSize * (info.height - 1) + lastRow > available)
+			wrongFormat("image data not found.");
+	}
+}
+
+void	readBMPInfo(const unsigned char* data, size_t size, BMPInfo& info)
+{
+	if (size < 26 || data[0] != 'B' || data[1] != 'M')
+		wrongFormat("wrong bmp file header format.");
+
+	unsigned int	headerSize = readU32(data + 0x0E);
+	int						width, height;
+	unsigned int	colorsUsed = 0, paletteEntry = 4;
+	if (headerSize == 12)
+	{
+		// OS/2 BITMAPCOREHEADER
+		width = readU16(data + 0x12);
+		height = static_cast<short>(readU16(data + 0x14));
+		info.bitCount = readU16(data + 0x18);
+		info.compression = BMP_RGB;
+		paletteEntry = 3;
+	}
+	else if (headerSize >= 40 && size >= 14 + 40)
+	{
+		width = static_cast<int>(readU32(data + 0x12));
+		height = static_cast<int>(readU32(data + 0x16));
+		info.bitCount = readU16(data + 0x1C);
+		info.compression = readU32(data + 0x1E);
+		colorsUsed = readU32(data + 0x2E);
+	}
+	else
+		wrongFormat("unknown bmp info header.");
+
+	if (width <= 0 || height == 0 || static_cast<unsigned int>(width) > MAX_BMP_SIZE
+		|| (height < 0 ? -static_cast<long long>(height) : height) > MAX_BMP_SIZE)
+		wrongFormat("invalid image size.");
+	info.width = width;
+	info.height = height < 0 ? -height : height;
+	info.topDown = height < 0;
+	info.dataOffset = readU32(data + 0x0A);
+
+	bool	palette = info.bitCount == 1 || info.bitCount == 4 || info.bitCount == 8;
+	bool	supported = (info.compression == BMP_RGB && (palette || info.bitCount == 16 || info.bitCount == 24 || info.bitCount == 32))
+					|| (info.compression == BMP_RLE8 && info.bitCount == 8 && !info.topDown)
+					|| ((info.compression == BMP_BITFIELDS || info.compression == BMP_ALPHABITFIELDS)
+						&& (info.bitCount == 16 || info.bitCount == 32));
+	if (!supported)
+		throw std::runtime_error("ERROR::LOADER::BMP::UNSUPPORTED\nunsupported bmp format.");
+
+	// BI_RGB 의 기본 mask. 32 bit BI_RGB 의 네 번째 byte 는 쓰이지 않습니다.
+	unsigned int	tableOffset = 14 + headerSize;
+	if (info.bitCount == 16)
+	{
+		info.masks[0] = 0x7C00;
+		info.masks[1] = 0x03E0;
+		info.masks[2] = 0x001F;
+	}
+	else
+	{
+		info.masks[0] = 0x00FF0000;
+		info.masks[1] = 0x0000FF00;
+		info.masks[2] = 0x000000FF;
+	}
+	info.masks[3] = 0;
+	if (info.compression == BMP_BITFIELDS || info.compression == BMP_ALPHABITFIELDS)
+	{
+		// V2 이상의 헤더는 mask 를 헤더 안에, 40 byte 헤더는 헤더 바로 뒤에 둡니다. (위치는 같음)
+		unsigned int	maskCount = (info.compression == BMP_ALPHABITFIELDS || headerSize >= 56) ? 4 : 3;
+		if (size < 0x36 + maskCount * 4)
+			wrongFormat("bitfield masks not found.");
+		for (unsigned int i = 0; i < maskCount; i++)
+			info.masks[i] = readU32(data + 0x36 + i * 4);
+		if (headerSize == 40)
+			tableOffset += maskCount * 4;
+		if (!info.masks[0] || !info.masks[1] || !info.masks[2])
+			wrongFormat("invalid bitfield masks.");
+	}
+
+	std::memset(info.palette, 0, sizeof(info.palette));
+	if (palette)
+	{
+		unsigned int	count = colorsUsed ? std::min(colorsUsed, 1u << info.bitCount) : 1u << info.bitCount;
+		if (tableOffset + static_cast<size_t>(count) * paletteEntry > size)
+			wrongFormat("palette not found.");
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			const unsigned char*	entry = data + tableOffset + (i < count ? i : 0) * paletteEntry;
+			info.palette[i][0] = entry[2];
+			info.palette[i][1] = entry[1];
+			info.palette[i][2] = entry[0];
+			info.palette[i][3] = 255;
+		}
+		tableOffset += count * paletteEntry;
+	}
+
+	// 몇몇 BMP 파일들은 포맷이 잘못되었습니다. 데이터 위치가 없으면 헤더 바로 뒤로 봅니다.
+	if (info.dataOffset == 0)
+		info.dataOffset = tableOffset;
+	info.rowSize = ((static_cast<size_t>(info.width) * info.bitCount + 31) / 32) * 4;
+}
+
+bool	isBMPRowSeekable(const BMPInfo& info)
+{
+	return info.compression != BMP_RLE8;
+}
+
+// 무압축 행 하나를 RGBA 로 바꿉니다.
+void	decodeBMPRow(const BMPInfo& info, const unsigned char* src, unsigned char* rgba)
+{
+	Channel	channels[4];
+	switch (info.bitCount)
+	{
+		case 24:
+			swizzle24(src, rgba, info.width);
+			break;
+		case 16:
+		case 32:
+			for (int c = 0; c < 4; c++)
+				channels[c] = channelOf(info.masks[c]);
+			if (info.bitCount == 32 && isByteChannels(channels))
+				swizzle32(src, rgba, info.width, channels);
+			else
+				expandBitfields(src, rgba, info.width, info.bitCount / 8, channels);
+			break;
+		default:
+			expandPalette(info, src, rgba);
+			break;
+	}
+}
+
+void	decodeBMP(const unsigned char* file, size_t size, const BMPInfo& info, unsigned char* rgba)
+{
+	checkBMPData(size, info);
+	if (info.compression == BMP_RLE8)
+	{
+		decodeRLE8(file, size, info, rgba);
+		return ;
+	}
+	for (unsigned int y = 0; y < info.height; y++)
+	{
+		unsigned int	row = info.topDown ? info.height - 1 - y : y;
+		decodeBMPRow(info, file + info.dataOffset + info.rowSize * y, rgba + static_cast<size_t>(row) * info.width * 4);
+	}
+}
+
+void	decodeBMP(const std::vector<unsigned char>& file, std::vector<unsigned char>& rgba,
+					unsigned int& width, unsigned int& height)
+{
+	BMPInfo	info;
+	readBMPInfo(file.data(), file.size(), info);
+	checkBMPData(file.size(), info);
+	rgba.resize(static_cast<size_t>(info.width) * info.height * 4);
+	decodeBMP(file.data(), file.size(), info, rgba.data());
+	width = info.width;
+	height = info.height;
+}
@@ -0,0 +1,44 @@
+#ifndef __BMPDECODER_HPP__
+# define __BMPDECODER_HPP__
+
+# include <vector>
+# include <cstring>
+# include <stdexcept>
+# include <algorithm>
+
+# if defined(__SSE2__)
+#  include <emmintrin.h>
+# endif
+
+enum	BMPCompression {
+	BMP_RGB = 0,
+	BMP_RLE8 = 1,
+	BMP_BITFIELDS = 3
+};
+
+// 헤더와 palette 를 읽는 데 필요한 최대 크기 (file header + V5 header + mask + palette 256 개)
+static const size_t	BMP_HEADER_BYTES = 14 + 124 + 16 + 256 * 4;
+
+struct	BMPInfo {
+	unsigned int	width;
+	unsigned int	height;
+	bool					topDown;
+	unsigned int	bitCount;
+	unsigned int	compression;
+	unsigned int	dataOffset;
+	size_t				rowSize;				// 무압축 행의 byte 수 (4 byte 정렬)
+	unsigned int	masks[4];				// BI_BITFIELDS / 16, 32 bit 의 r, g, b, a mask
+	unsigned char	palette[256][4];	// 8 bit 의 RGBA palette
+};
+
+// BMP 디코더 : 1 / 4 / 8 bit palette, 16 / 24 / 32 bit, BI_RGB / BI_BITFIELDS / BI_RLE8,
+// 아래쪽부터 (bottom-up) 또는 위쪽부터 (top-down) 저장된 행을 지원합니다.
+// rgba 는 늘 아래쪽부터 width * height * 4 byte 로 호출한 쪽 버퍼 (map 된 GPU 메모리일 수도 있음) 에 바로 씁니다.
+void	readBMPInfo(const unsigned char* data, size_t size, BMPInfo& info);
+bool	isBMPRowSeekable(const BMPInfo& info);
+void	decodeBMPRow(const BMPInfo& info, const unsigned char* src, unsigned char* rgba);
+void	decodeBMP(const unsigned char* file, size_t size, const BMPInfo& info, unsigned char* rgba);
+void	decodeBMP(const std::vector<unsigned char>& file, std::vector<unsigned char>& rgba,
+					unsigned int& width, unsigned int& height);
+
+#endif
@@ -0,0 +1,817 @@
+#include "JpegDecoder.hpp"
+
+namespace
+{
+	// zigzag 순서의 i 번째 계수가 8x8 블록에서 위치하는 곳
+	const int	ZIGZAG[64] = {
+		 0,  1,  8, 16,  9,  2,  3, 10,
+		17, 24, 32, 25, 18, 11,  4,  5,
+		12, 19, 26, 33, 40, 48, 41, 34,
+		27, 20, 13,  6,  7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36,
+		29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46,
+		53, 60, 61, 54, 47, 55, 62, 63
+	};
+
+	void	corrupt(const char* reason)
+	{
+		throw std::runtime_error(std::string("ERROR::LOADER::JPEG::WRONG_FORMAT\n") + reason);
+	}
+
+	struct	HuffmanTable {
+		bool					defined;
+		unsigned char	lookupLength[512];	// 9 bit 이하 코드는 한 번에 찾습니다.
+		unsigned char	lookupSymbol[512];
+		int						maxCode[18];
+		int						valueOffset[18];
+		unsigned char	symbols[256];
+	};
+
+	void	buildHuffman(HuffmanTable& table, const unsigned char counts[16], const unsigned char* symbols, int total)
+	{
+		int	code = 0, k = 0;
+
+		std::memset(table.lookupLength, 0, sizeof(table.lookupLength));
+		std::memcpy(table.symbols, symbols, total);
+		for (int length = 1; length <= 16; length++)
+		{
+			table.valueOffset[length] = k - code;
+			for (int i = 0; i < counts[length - 1]; i++, k++, code++)
+			{
+				// 길이가 length 인 코드가 모자라면 (개수가 너무 많으면) lookup 범위를 넘습니다.
+				if (code >= (1 << length))
+					corrupt("invalid huffman table.");
+				if (length > 9)
+					continue ;
+				int	shift = 9 - length;
+				for (int j = 0; j < (1 << shift); j++)
+				{
+					table.lookupLength[(code << shift) | j] = length;
+					table.lookupSymbol[(code << shift) | j] = symbols[k];
+				}
+			}
+			table.maxCode[length] = counts[length - 1] ? code - 1 : -1;
+			code <<= 1;
+		}
+		table.defined = true;
+	}
+
+	// entropy 데이터 비트 리더. 0xFF00 은 0xFF 로, marker 를 만나면 0 을 채웁니다.
+	struct	BitReader {
+		const unsigned char*	data;
+		size_t								pos;
+		size_t								end;
+		unsigned int					buffer;
+		int										bits;
+
+		BitReader(const unsigned char* d, size_t begin, size_t finish) : data(d), pos(begin), end(finish), buffer(0), bits(0)
+		{
+		}
+
+		void	fill()
+		{
+			while (bits <= 24)
+			{
+				unsigned int	byte = 0;
+				if (pos < end)
+				{
+					byte = data[pos];
+					if (byte != 0xFF)
+						pos++;
+					else if (pos + 1 < end && data[pos + 1] == 0x00)
+						pos += 2;
+					else
+						byte = 0;
+				}
+				buffer |= byte << (24 - bits);
+				bits += 8;
+			}
+		}
+
+		int		getBits(int n)
+		{
+			if (n == 0)
+				return 0;
+			fill();
+			int	value = buffer >> (32 - n);
+			buffer <<= n;
+			bits -= n;
+			return value;
+		}
+
+		int		decode(const HuffmanTable& table)
+		{
+			fill();
+			int	look = buffer >> 23;
+			int	length = table.lookupLength[look];
+			if (length)
+			{
+				buffer <<= length;
+				bits -= length;
+				return table.lookupSymbol[look];
+			}
+			int	code = getBits(9);
+			for (length = 10; length <= 16; length++)
+			{
+				code = (code << 1) | getBits(1);
+				if (code <= table.maxCode[length])
+					return table.symbols[code + table.valueOffset[length]];
+			}
+			corrupt("invalid huffman code.");
+			return 0;
+		}
+	};
+
+	int	extend(int value, int size)
+	{
+		return value < (1 << (size - 1)) ? value - (1 << size) + 1 : value;
+	}
+
+	struct	Component {
+		int													id;
+		int													h;
+		int													v;
+		int													quantTable;
+		int													blocksPerLine;		// MCU 단위로 채운 크기
+		int													blocksPerColumn;
+		int													scanBlocksX;			// non-interleaved scan 이 도는 크기
+		int													scanBlocksY;
+		std::vector<short>					coefs;
+		std::vector<unsigned char>	plane;
+	};
+
+	struct	Scan {
+		int	count;
+		int	components[4];
+		int	dcTable[4];
+		int	acTable[4];
+		int	ss, se, ah, al;
+	};
+
+	// 예외를 모아서 join 후 다시 던지는 parallel for
+	template <typename Fn>
+	void	parallelFor(int count, unsigned int threadCount, Fn fn)
+	{
+		std::atomic<int>		next(0);
+		std::exception_ptr	error;
+		std::atomic<bool>		failed(false);
+
+		auto	worker = [&]()
+		{
+			try
+			{
+				for (int i = next++; i < count && !failed; i = next++)
+					fn(i);
+			}
+			catch (...)
+			{
+				if (!failed.exchange(true))
+					error = std::current_exception();
+			}
+		};
+
+		unsigned int							threads = std::min<unsigned int>(threadCount, std::max(count, 1));
+		std::vector<std::thread>	workers;
+		for (unsigned int t = 1; t < threads; t++)
+			workers.push_back(std::thread(worker));
+		worker();
+		for (size_t t = 0; t < workers.size(); t++)
+			workers[t].join();
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	class	Decoder
+	{
+		private:
+			const std::vector<unsigned char>&	_file;
+			unsigned int											_threads;
+			HuffmanTable											_dc[4], _ac[4];
+			unsigned short										_quant[4][64];	// natural order
+			int																_restartInterval;
+			bool															_progressive;
+			bool															_frameRead;
+			int																_width, _height;
+			int																_hmax, _vmax;
+			int																_mcusX, _mcusY;
+			std::vector<Component>						_components;
+			float															_idct[64];
+
+			int		read16(size_t pos) const
+			{
+				if (pos + 1 >= _file.size())
+					corrupt("unexpected end of file.");
+				return (_file[pos] << 8) | _file[pos + 1];
+			}
+
+			void	readQuant(size_t pos, size_t end)
+			{
+				while (pos < end)
+				{
+					int	precision = _file[pos] >> 4, id = _file[pos] & 15;
+					pos++;
+					if (id > 3 || pos + 64 * (precision + 1) > end)
+						corrupt("invalid quantization table.");
+					for (int i = 0; i < 64; i++)
+					{
+						_quant[id][ZIGZAG[i]] = precision ? read16(pos) : _file[pos];
+						pos += precision + 1;
+					}
+				}
+			}
+
+			void	readHuffman(size_t pos, size_t end)
+			{
+				while (pos < end)
+				{
+					int	tableClass = _file[pos] >> 4, id = _file[pos] & 15;
+					if (id > 3 || pos + 17 > end)
+						corrupt("invalid huffman table.");
+					unsigned char	counts[16];
+					int						total = 0;
+					for (int i = 0; i < 16; i++)
+					{
+						counts[i] = _file[pos + 1 + i];
+						total += counts[i];
+					}
+					pos += 17;
+					if (total > 256 || pos + total > end)
+						corrupt("invalid huffman table.");
+					buildHuffman(tableClass ? _ac[id] : _dc[id], counts, &_file[pos], total);
+					pos += total;
+				}
+			}
+
+			void	readFrame(size_t pos, size_t end, bool progressive)
+			{
+				if (_frameRead || pos + 6 > end || _file[pos] != 8)
+					corrupt("unsupported frame header.");
+				_progressive = progressive;
+				_height = read16(pos + 1);
+				_width = read16(pos + 3);
+				int	count = _file[pos + 5];
+				if (_width <= 0 || _height <= 0 || (count != 1 && count != 3) || pos + 6 + count * 3 > end)
+					corrupt("unsupported frame header.");
+
+				_hmax = 1;
+				_vmax = 1;
+				_components.resize(count);
+				for (int i = 0; i < count; i++)
+				{
+					Component&	c = _components[i];
+					c.id = _file[pos + 6 + i * 3];
+					c.h = _file[pos + 7 + i * 3] >> 4;
+					c.v = _file[pos + 7 + i * 3] & 15;
+					c.quantTable = _file[pos + 8 + i * 3] & 3;
+					if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4)
+						corrupt("invalid sampling factor.");
+					_hmax = std::max(_hmax, c.h);
+					_vmax = std::max(_vmax, c.v);
+				}
+				_mcusX = (_width + 8 * _hmax - 1) / (8 * _hmax);
+				_mcusY = (_height + 8 * _vmax - 1) / (8 * _vmax);
+				for (int i = 0; i < count; i++)
+				{
+					Component&	c = _components[i];
+					c.blocksPerLine = _mcusX * c.h;
+					c.blocksPerColumn = _mcusY * c.v;
+					c.scanBlocksX = ((_width * c.h + _hmax - 1) / _hmax + 7) / 8;
+					c.scanBlocksY = ((_height * c.v + _vmax - 1) / _vmax + 7) / 8;
+					c.coefs.assign(static_cast<size_t>(c.blocksPerLine) * c.blocksPerColumn * 64, 0);
+				}
+				_frameRead = true;
+			}
+
+			size_t	readScan(size_t pos, size_t end)
+			{
+				Scan	scan;
+				if (!_frameRead || pos >= end)
+					corrupt("scan before frame header.");
+				scan.count = _file[pos];
+				if (scan.count < 1 || scan.count > static_cast<int>(_components.size()) || pos + 1 + scan.count * 2 + 3 > end)
+					corrupt("invalid scan header.");
+				for (int i = 0; i < scan.count; i++)
+				{
+					int	id = _file[pos + 1 + i * 2];
+					int	tables = _file[pos + 2 + i * 2];
+					scan.components[i] = -1;
+					for (size_t c = 0; c < _components.size(); c++)
+						if (_components[c].id == id)
+							scan.components[i] = c;
+					scan.dcTable[i] = (tables >> 4) & 3;
+					scan.acTable[i] = tables & 3;
+					if (scan.components[i] < 0)
+						corrupt("invalid scan component.");
+				}
+				size_t	p = pos + 1 + scan.count * 2;
+				scan.ss = _file[p];
+				scan.se = _file[p + 1];
+				scan.ah = _file[p + 2] >> 4;
+				scan.al = _file[p + 2] & 15;
+				if (!_progressive)
+				{
+					scan.ss = 0;
+					scan.se = 63;
+					scan.ah = 0;
+					scan.al = 0;
+				}
+				if (scan.ss > scan.se || scan.se > 63 || (scan.ss == 0 && scan.se != 0 && _progressive)
+					|| (scan.ss > 0 && scan.count != 1))
+					corrupt("invalid spectral selection.");
+				for (int i = 0; i < scan.count; i++)
+				{
+					if ((scan.ss == 0 && scan.ah == 0 && !_dc[scan.dcTable[i]].defined)
+						|| (scan.se > 0 && !_ac[scan.acTable[i]].defined))
+						corrupt("missing huffman table.");
+				}
+				return decodeScan(scan, end);
+			}
+
+			// restart marker 로 나뉜 구간들은 서로 독립적이므로 병렬로 디코딩합니다.
+			size_t	decodeScan(const Scan& scan, size_t begin)
+			{
+				std::vector<size_t>	starts(1, begin), ends;
+				size_t							p = begin;
+				const size_t				size = _file.size();
+				while (p + 1 < size)
+				{
+					const void*	ff = std::memchr(&_file[p], 0xFF, size - 1 - p);
+					if (!ff)
+					{
+						p = size;
+						break ;
+					}
+					p = static_cast<const unsigned char*>(ff) - _file.data();
+					unsigned char	marker = _file[p + 1];
+					if (marker == 0x00 || marker == 0xFF)
+						p += marker == 0x00 ? 2 : 1;
+					else if (marker >= 0xD0 && marker <= 0xD7)
+					{
+						ends.push_back(p);
+						starts.push_back(p + 2);
+						p += 2;
+					}
+					else
+						break ;
+				}
+				p = std::min(p, size);
+				ends.push_back(p);
+
+				int	totalMCUs = scan.count == 1
+					? _components[scan.components[0]].scanBlocksX * _components[scan.components[0]].scanBlocksY
+					: _mcusX * _mcusY;
+				if (_restartInterval > 0)
+				{
+					int	segments = std::min<int>(starts.size(), (totalMCUs + _restartInterval - 1) / _restartInterval);
+					parallelFor(segments, _threads, [&](int i)
+					{
+						decodeSegment(scan, starts[i], ends[i], i * _restartInterval,
+							std::min(totalMCUs, (i + 1) * _restartInterval));
+					});
+				}
+				else
+					decodeSegment(scan, starts[0], ends.back(), 0, totalMCUs);
+				return p;
+			}
+
+			void	decodeSegment(const Scan& scan, size_t begin, size_t end, int mcuBegin, int mcuEnd)
+			{
+				BitReader	reader(_file.data(), begin, end);
+				int				dcPred[4] = {0, 0, 0, 0};
+				int				eobrun = 0;
+
+				for (int mcu = mcuBegin; mcu < mcuEnd; mcu++)
+				{
+					if (scan.count == 1)
+					{
+						Component&	c = _components[scan.components[0]];
+						int					bx = mcu % c.scanBlocksX, by = mcu / c.scanBlocksX;
+						decodeBlock(scan, 0, reader, &c.coefs[(static_cast<size_t>(by) * c.blocksPerLine + bx) * 64], dcPred[0], eobrun);
+						continue ;
+					}
+					int	mx = mcu % _mcusX, my = mcu / _mcusX;
+					for (int i = 0; i < scan.count; i++)
+					{
+						Component&	c = _components[scan.components[i]];
+						for (int v = 0; v < c.v; v++)
+						{
+							for (int h = 0; h < c.h; h++)
+							{
+								size_t	block = static_cast<size_t>(my * c.v + v) * c.blocksPerLine + mx * c.h + h;
+								decodeBlock(scan, i, reader, &c.coefs[block * 64], dcPred[i], eobrun);
+							}
+						}
+					}
+				}
+			}
+
+			// DC 차이값 : 8 bit 샘플의 category 는 11 까지입니다. 더 크면 bit 를 읽기 전에 거절합니다. (shift 가 32 를 넘음)
+			static int	decodeDC(BitReader& reader, const HuffmanTable& dc)
+			{
+				int	t = reader.decode(dc);
+				if (t > 11)
+					corrupt("invalid DC category.");
+				return t ? extend(reader.getBits(t), t) : 0;
+			}
+
+			void	decodeBlock(const Scan& scan, int index, BitReader& reader, short* coef, int& dcPred, int& eobrun) const
+			{
+				const HuffmanTable&	dc = _dc[scan.dcTable[index]];
+				const HuffmanTable&	ac = _ac[scan.acTable[index]];
+
+				if (!_progressive)
+				{
+					dcPred += decodeDC(reader, dc);
+					coef[0] = dcPred;
+					for (int k = 1; k < 64;)
+					{
+						int	rs = reader.decode(ac), r = rs >> 4, s = rs & 15;
+						if (s)
+						{
+							k += r;
+							if (k > 63)
+								corrupt("coefficient out of block.");
+							coef[ZIGZAG[k++]] = extend(reader.getBits(s), s);
+						}
+						else if (r == 15)
+							k += 16;
+						else
+							break ;
+					}
+					return ;
+				}
+
+				if (scan.ss == 0)
+				{
+					// DC first / refine
+					if (scan.ah == 0)
+					{
+						dcPred += decodeDC(reader, dc);
+						coef[0] = dcPred * (1 << scan.al);
+					}
+					else if (reader.getBits(1))
+						coef[0] |= 1 << scan.al;
+					return ;
+				}
+
+				if (scan.ah == 0)
+				{
+					// AC first
+					if (eobrun > 0)
+					{
+						eobrun--;
+						return ;
+					}
+					for (int k = scan.ss; k <= scan.se; k++)
+					{
+						int	rs = reader.decode(ac), r = rs >> 4, s = rs & 15;
+						if (s)
+						{
+							k += r;
+							if (k > 63)
+								corrupt("coefficient out of block.");
+							coef[ZIGZAG[k]] = extend(reader.getBits(s), s) * (1 << scan.al);
+						}
+						else if (r == 15)
+							k += 15;
+						else
+						{
+							eobrun = (1 << r) - 1;
+							if (r)
+								eobrun += reader.getBits(r);
+							break ;
+						}
+					}
+					return ;
+				}
+
+				// AC refine
+				int	p1 = 1 << scan.al, m1 = -1 * (1 << scan.al);
+				int	k = scan.ss;
+				if (eobrun == 0)
+				{
+					for (; k <= scan.se; k++)
+					{
+						int	rs = reader.decode(ac), r = rs >> 4, s = rs & 15;
+						if (s)
+							s = reader.getBits(1) ? p1 : m1;
+						else if (r != 15)
+						{
+							eobrun = 1 << r;
+							if (r)
+								eobrun += reader.getBits(r);
+							break ;
+						}
+						do
+						{
+							short*	c = &coef[ZIGZAG[k]];
+							if (*c != 0)
+							{
+								if (reader.getBits(1) && (*c & p1) == 0)
+									*c += *c >= 0 ? p1 : m1;
+							}
+							else if (--r < 0)
+								break ;
+							k++;
+						} while (k <= scan.se);
+						if (s && k <= scan.se)
+							coef[ZIGZAG[k]] = s;
+					}
+				}
+				if (eobrun > 0)
+				{
+					for (; k <= scan.se; k++)
+					{
+						short*	c = &coef[ZIGZAG[k]];
+						if (*c != 0 && reader.getBits(1) && (*c & p1) == 0)
+							*c += *c >= 0 ? p1 : m1;
+					}
+					eobrun--;
+				}
+			}
+
+			// 8x8 역 DCT : f = C^T * F * C (행 / 열 두 번의 행렬 곱)
+			void	idctBlock(const short* coef, const unsigned short* quant, unsigned char* out, int stride) const
+			{
+				alignas(16) float	in[64], tmp[64];
+				for (int i = 0; i < 64; i++)
+					in[i] = static_cast<float>(coef[i] * quant[i]);
+#if defined(__SSE2__)
+				for (int pass = 0; pass < 2; pass++)
+				{
+					const float*	src = pass == 0 ? in : tmp;
+					float*				dst = pass == 0 ? tmp : in;
+					for (int r = 0; r < 8; r++)
+					{
+						__m128	lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+						for (int k = 0; k < 8; k++)
+						{
+							// pass 0 : 행 r 에 대해 sum_k F[r][k] * C[k][:]
+							// pass 1 : 출력 행 r 에 대해 sum_k C[k][r] * tmp[k][:]
+							__m128	w = _mm_set1_ps(pass == 0 ? src[r * 8 + k] : _idct[k * 8 + r]);
+							const float*	row = pass == 0 ? &_idct[k * 8] : &src[k * 8];
+							lo = _mm_add_ps(lo, _mm_mul_ps(w, _mm_loadu_ps(row)));
+							hi = _mm_add_ps(hi, _mm_mul_ps(w, _mm_loadu_ps(row + 4)));
+						}
+						_mm_store_ps(&dst[r * 8], lo);
+						_mm_store_ps(&dst[r * 8 + 4], hi);
+					}
+				}
+				__m128	bias = _mm_set1_ps(128.0f);
+				for (int r = 0; r < 8; r++)
+				{
+					__m128i	lo = _mm_cvtps_epi32(_mm_add_ps(_mm_load_ps(&in[r * 8]), bias));
+					__m128i	hi = _mm_cvtps_epi32(_mm_add_ps(_mm_load_ps(&in[r * 8 + 4]), bias));
+					__m128i	packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(out + r * stride), packed);
+				}
+#else
+				for (int r = 0; r < 8; r++)
+				{
+					for (int x = 0; x < 8; x++)
+					{
+						float	sum = 0.0f;
+						for (int k = 0; k < 8; k++)
+							sum += in[r * 8 + k] * _idct[k * 8 + x];
+						tmp[r * 8 + x] = sum;
+					}
+				}
+				for (int y = 0; y < 8; y++)
+				{
+					for (int x = 0; x < 8; x++)
+					{
+						float	sum = 0.0f;
+						for (int k = 0; k < 8; k++)
+							sum += _idct[k * 8 + y] * tmp[k * 8 + x];
+						int	value = static_cast<int>(std::lround(sum + 128.0f));
+						out[y * stride + x] = static_cast<unsigned char>(std::min(255, std::max(0, value)));
+					}
+				}
+#endif
+			}
+
+			void	convertRow(const unsigned char* y, const unsigned char* cb, const unsigned char* cr, unsigned char* out) const
+			{
+				int	x = 0;
+#if defined(__SSE2__)
+				const __m128i	zero = _mm_setzero_si128();
+				const __m128	offset = _mm_set1_ps(128.0f);
+				const __m128i	alpha = _mm_set1_epi32(255);
+				for (; x + 4 <= _width; x += 4)
+				{
+					int	yBits, cbBits, crBits;
+					std::memcpy(&yBits, y + x, 4);
+					std::memcpy(&cbBits, cb + x, 4);
+					std::memcpy(&crBits, cr + x, 4);
+					__m128	fy = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(yBits), zero), zero));
+					__m128	fcb = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(cbBits), zero), zero)), offset);
+					__m128	fcr = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(crBits), zero), zero)), offset);
+					__m128i	r = _mm_cvtps_epi32(_mm_add_ps(fy, _mm_mul_ps(fcr, _mm_set1_ps(1.402f))));
+					__m128i	g = _mm_cvtps_epi32(_mm_sub_ps(fy, _mm_add_ps(_mm_mul_ps(fcb, _mm_set1_ps(0.344136f)),
+											_mm_mul_ps(fcr, _mm_set1_ps(0.714136f)))));
+					__m128i	b = _mm_cvtps_epi32(_mm_add_ps(fy, _mm_mul_ps(fcb, _mm_set1_ps(1.772f))));
+					// r0 r1 r2 r3 g0 .. / b0 .. a3 -> r0 g0 b0 a0 r1 ..
+					__m128i	rg = _mm_packs_epi32(r, g);
+					__m128i	ba = _mm_packs_epi32(b, alpha);
+					__m128i	rb = _mm_unpacklo_epi16(rg, ba);
+					__m128i	ga = _mm_unpackhi_epi16(rg, ba);
+					__m128i	pixels = _mm_packus_epi16(_mm_unpacklo_epi16(rb, ga), _mm_unpackhi_epi16(rb, ga));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), pixels);
+				}
+#endif
+				for (; x < _width; x++)
+				{
+					float	fy = y[x], fcb = cb[x] - 128.0f, fcr = cr[x] - 128.0f;
+					float	rgb[3] = {
+						fy + 1.402f * fcr,
+						fy - 0.344136f * fcb - 0.714136f * fcr,
+						fy + 1.772f * fcb
+					};
+					for (int c = 0; c < 3; c++)
+						out[x * 4 + c] = static_cast<unsigned char>(std::min(255, std::max(0, static_cast<int>(std::lround(rgb[c])))));
+					out[x * 4 + 3] = 255;
+				}
+			}
+
+			void	reconstruct(std::vector<unsigned char>& rgba)
+			{
+				// 1. 역양자화 + IDCT, 블록 행 단위로 병렬 처리
+				std::vector<std::pair<int, int> >	rows;
+				for (size_t c = 0; c < _components.size(); c++)
+				{
+					Component&	comp = _components[c];
+					comp.plane.resize(static_cast<size_t>(comp.blocksPerLine) * 8 * comp.blocksPerColumn * 8);
+					for (int by = 0; by < comp.blocksPerColumn; by++)
+						rows.push_back(std::make_pair(static_cast<int>(c), by));
+				}
+				parallelFor(rows.size(), _threads, [&](int i)
+				{
+					Component&	comp = _components[rows[i].first];
+					int					by = rows[i].second, stride = comp.blocksPerLine * 8;
+					for (int bx = 0; bx < comp.blocksPerLine; bx++)
+					{
+						idctBlock(&comp.coefs[(static_cast<size_t>(by) * comp.blocksPerLine + bx) * 64], _quant[comp.quantTable],
+							&comp.plane[static_cast<size_t>(by) * 8 * stride + bx * 8], stride);
+					}
+				});
+
+				// 2. chroma 업샘플링 + YCbCr -> RGBA, 행 묶음 단위로 병렬 처리 (아래쪽 행부터 저장)
+				rgba.resize(static_cast<size_t>(_width) * _height * 4);
+				const int	rowsPerTask = 16;
+				parallelFor((_height + rowsPerTask - 1) / rowsPerTask, _threads, [&](int task)
+				{
+					std::vector<unsigned char>	upsampled[3];
+					const unsigned char*				source[3] = {0, 0, 0};
+					for (int y = task * rowsPerTask; y < std::min(_height, (task + 1) * rowsPerTask); y++)
+					{
+						for (size_t c = 0; c < _components.size(); c++)
+						{
+							const Component&		comp = _components[c];
+							int									stride = comp.blocksPerLine * 8;
+							const unsigned char*	row = &comp.plane[static_cast<size_t>(y * comp.v / _vmax) * stride];
+							if (comp.h == _hmax)
+							{
+								source[c] = row;
+								continue ;
+							}
+							upsampled[c].resize(_width);
+							for (int x = 0; x < _width; x++)
+								upsampled[c][x] = row[x * comp.h / _hmax];
+							source[c] = upsampled[c].data();
+						}
+						unsigned char*	out = &rgba[static_cast<size_t>(_height - 1 - y) * _width * 4];
+						if (_components.size() == 3)
+							convertRow(source[0], source[1], source[2], out);
+						else
+						{
+							for (int x = 0; x < _width; x++)
+							{
+								out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = source[0][x];
+								out[x * 4 + 3] = 255;
+							}
+						}
+					}
+				});
+			}
+
+		public:
+			Decoder(const std::vector<unsigned char>& file, unsigned int threads) :
+			_file(file), _threads(threads), _restartInterval(0), _progressive(false), _frameRead(false),
+			_width(0), _height(0), _hmax(1), _vmax(1), _mcusX(0), _mcusY(0)
+			{
+				for (int i = 0; i < 4; i++)
+				{
+					_dc[i].defined = false;
+					_ac[i].defined = false;
+					for (int j = 0; j < 64; j++)
+						_quant[i][j] = 1;
+				}
+				for (int k = 0; k < 8; k++)
+				{
+					float	scale = k == 0 ? std::sqrt(0.125f) : 0.5f;
+					for (int n = 0; n < 8; n++)
+						_idct[k * 8 + n] = scale * std::cos((2 * n + 1) * k * 3.14159265358979f / 16.0f);
+				}
+			}
+
+			void	decode(std::vector<unsigned char>& rgba, unsigned int& width, unsigned int& height)
+			{
+				if (_file.size() < 4 || _file[0] != 0xFF || _file[1] != 0xD8)
+					corrupt("wrong jpeg file header format.");
+
+				size_t	pos = 2;
+				while (true)
+				{
+					// marker 앞의 채움 바이트(0xFF) 는 건너뜁니다.
+					while (pos < _file.size() && _file[pos] == 0xFF && pos + 1 < _file.size() && _file[pos + 1] == 0xFF)
+						pos++;
+					if (pos + 1 >= _file.size() || _file[pos] != 0xFF)
+						corrupt("marker not found.");
+					unsigned char	marker = _file[pos + 1];
+					pos += 2;
+					if (marker == 0xD9)
+						break ;
+					if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+						continue ;
+
+					size_t	length = read16(pos);
+					size_t	end = pos + length;
+					if (length < 2 || end > _file.size())
+						corrupt("segment out of file.");
+					switch (marker)
+					{
+						case 0xC0:
+						case 0xC1:
+							readFrame(pos + 2, end, false);
+							break;
+						case 0xC2:
+							readFrame(pos + 2, end, true);
+							break;
+						case 0xC4:
+							readHuffman(pos + 2, end);
+							break;
+						case 0xDB:
+							readQuant(pos + 2, end);
+							break;
+						case 0xDD:
+							_restartInterval = read16(pos + 2);
+							break;
+						case 0xDA:
+							end = readScan(pos + 2, end);
+							break;
+						default:
+							if ((marker >= 0xC3 && marker <= 0xCF) && marker != 0xC8 && marker != 0xCC)
+								throw std::runtime_error("ERROR::LOADER::JPEG::UNSUPPORTED\nonly baseline and progressive huffman jpeg are supported.");
+							break;
+					}
+					pos = end;
+				}
+				if (!_frameRead)
+					corrupt("frame header not found.");
+
+				reconstruct(rgba);
+				width = _width;
+				height = _height;
+			}
+	};
+}
+
+void	decodeJPEG(const std::vector<unsigned char>& file, std::vector<unsigned char>& rgba,
+					unsigned int& width, unsigned int& height, unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	Decoder	decoder(file, threadCount);
+	decoder.decode(rgba, width, height);
+}
+
+bool	readJPEGSize(const std::vector<unsigned char>& file, unsigned int& width, unsigned int& height)
+{
+	size_t	pos = 2;
+
+	if (file.size() < 4 || file[0] != 0xFF || file[1] != 0xD8)
+		return false;
+	while (pos + 3 < file.size())
+	{
+		if (file[pos] != 0xFF)
+			return false;
+		unsigned char	marker = file[pos + 1];
+		if (marker == 0xFF)
+		{
+			pos++;
+			continue ;
+		}
+		size_t	length = (file[pos + 2] << 8) | file[pos + 3];
+		if (marker == 0xC0 || marker == 0xC1 || marker == 0xC2)
+		{
+			if (pos + 9 > file.size())
+				return false;
+			height = (file[pos + 5] << 8) | file[pos + 6];
+			width = (file[pos + 7] << 8) | file[pos + 8];
+			return width > 0 && height > 0;
+		}
+		pos += 2 + length;
+	}
+	return false;
+}
@@ -0,0 +1,25 @@
+#ifndef __JPEGDECODER_HPP__
+# define __JPEGDECODER_HPP__
+
+# include <vector>
+# include <string>
+# include <cstring>
+# include <cmath>
+# include <stdexcept>
+# include <thread>
+# include <atomic>
+# include <exception>
+# include <algorithm>
+
+# if defined(__SSE2__)
+#  include <emmintrin.h>
+# endif
+
+// JPEG 디코더 : baseline (SOF0 / SOF1) 과 progressive (SOF2) huffman JPEG,
+// gray (1 component) 또는 YCbCr (3 component) 를 지원합니다.
+// restart 구간과 MCU 줄 단위로 여러 스레드에서 디코딩하고, rgba 는 BMP 처럼 아래쪽부터 씁니다.
+void	decodeJPEG(const std::vector<unsigned char>& file, std::vector<unsigned char>& rgba,
+					unsigned int& width, unsigned int& height, unsigned int threadCount = 0);
+bool	readJPEGSize(const std::vector<unsigned char>& file, unsigned int& width, unsigned int& height);
+
+#endif
@@ -0,0 +1,300 @@
+#include "Ktx2File.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+	const unsigned char	KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+	const size_t				KTX2_HEADER_BYTES = 80;
+	const size_t				KTX2_LEVEL_INDEX_BYTES = 24;
+	const char					SOURCE_KEY[] = "scop.source";
+
+	// Khronos Data Format 의 color model
+	const unsigned int	KHR_DF_MODEL_RGBSDA = 1;
+	const unsigned int	KHR_DF_MODEL_BC1A = 128;
+	const unsigned int	KHR_DF_MODEL_BC3 = 130;
+	const unsigned int	KHR_DF_MODEL_BC5 = 132;
+
+	unsigned int	readU32(const unsigned char* p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+	}
+
+	unsigned long long	readU64(const unsigned char* p)
+	{
+		return readU32(p) | (static_cast<unsigned long long>(readU32(p + 4)) << 32);
+	}
+
+	void	putU32(std::vector<unsigned char>& out, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+			out.push_back(static_cast<unsigned char>(value >> (i * 8)));
+	}
+
+	void	putU64(std::vector<unsigned char>& out, unsigned long long value)
+	{
+		putU32(out, static_cast<unsigned int>(value));
+		putU32(out, static_cast<unsigned int>(value >> 32));
+	}
+
+	void	setU64(std::vector<unsigned char>& out, size_t pos, unsigned long long value)
+	{
+		for (int i = 0; i < 8; i++)
+			out[pos + i] = static_cast<unsigned char>(value >> (i * 8));
+	}
+
+	void	padTo(std::vector<unsigned char>& out, size_t alignment)
+	{
+		while (out.size() % alignment)
+			out.push_back(0);
+	}
+
+	// RGBA8 은 texel 하나, BC 는 4x4 블록 하나의 byte 수
+	size_t	blockBytes(unsigned int vkFormat)
+	{
+		switch (vkFormat)
+		{
+			case VK_FORMAT_R8G8B8A8_UNORM:
+				return 4;
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+				return 8;
+			default:
+				return 16;
+		}
+	}
+
+	size_t	levelBytes(unsigned int vkFormat, unsigned int width, unsigned int height)
+	{
+		if (vkFormat == VK_FORMAT_R8G8B8A8_UNORM)
+			return static_cast<size_t>(width) * height * 4;
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes(vkFormat);
+	}
+
+	// sample 하나 : bit 위치, bit 수, channel, 값의 범위
+	void	putSample(std::vector<unsigned char>& out, unsigned int offset, unsigned int bits, unsigned int channel,
+					unsigned int upper)
+	{
+		putU32(out, offset | ((bits - 1) << 16) | (channel << 24));
+		putU32(out, 0);
+		putU32(out, 0);
+		putU32(out, upper);
+	}
+
+	// Data Format Descriptor : basic descriptor block 하나
+	void	putDFD(std::vector<unsigned char>& out, unsigned int vkFormat)
+	{
+		std::vector<unsigned char>	samples;
+		unsigned int								model, blockSize = 3;
+		switch (vkFormat)
+		{
+			case VK_FORMAT_R8G8B8A8_UNORM:
+				model = KHR_DF_MODEL_RGBSDA;
+				blockSize = 0;
+				putSample(samples, 0, 8, 0, 255);
+				putSample(samples, 8, 8, 1, 255);
+				putSample(samples, 16, 8, 2, 255);
+				putSample(samples, 24, 8, 15, 255);
+				break;
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+				model = KHR_DF_MODEL_BC1A;
+				putSample(samples, 0, 64, 0, 0xFFFFFFFFu);
+				break;
+			case VK_FORMAT_BC3_UNORM_BLOCK:
+				model = KHR_DF_MODEL_BC3;
+				putSample(samples, 0, 64, 15, 0xFFFFFFFFu);
+				putSample(samples, 64, 64, 0, 0xFFFFFFFFu);
+				break;
+			default:
+				model = KHR_DF_MODEL_BC5;
+				putSample(samples, 0, 64, 0, 0xFFFFFFFFu);
+				putSample(samples, 64, 64, 1, 0xFFFFFFFFu);
+				break;
+		}
+		unsigned int	descriptorSize = 24 + samples.size();
+		putU32(out, 4 + descriptorSize);
+		putU32(out, 0);															// vendor Khronos, basic descriptor
+		putU32(out, 2 | (descriptorSize << 16));		// version 1.3
+		putU32(out, model | (1 << 8) | (1 << 16));	// BT.709 primaries, linear transfer
+		putU32(out, blockSize | (blockSize << 8));	// texel block 크기 - 1
+		putU32(out, blockBytes(vkFormat));					// plane 0 의 byte 수
+		putU32(out, 0);
+		out.insert(out.end(), samples.begin(), samples.end());
+	}
+
+	void	putKeyValue(std::vector<unsigned char>& out, const std::string& key, const std::string& value)
+	{
+		putU32(out, key.size() + 1 + value.size() + 1);
+		out.insert(out.end(), key.begin(), key.end());
+		out.push_back(0);
+		out.insert(out.end(), value.begin(), value.end());
+		out.push_back(0);
+		padTo(out, 4);
+	}
+}
+
+Ktx2File::Ktx2File() : _map(0), _size(0)
+{
+}
+
+Ktx2File::~Ktx2File()
+{
+	close();
+}
+
+void	Ktx2File::close()
+{
+	if (_map)
+		munmap(_map, _size);
+	_map = 0;
+	_size = 0;
+	_levels.clear();
+}
+
+const std::vector<Ktx2Level>&	Ktx2File::levels() const
+{
+	return _levels;
+}
+
+bool	Ktx2File::open(const std::string& path, unsigned int vkFormat, const std::string& source)
+{
+	close();
+
+	int					fd = ::open(path.c_str(), O_RDONLY);
+	struct stat	info;
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(KTX2_HEADER_BYTES))
+	{
+		::close(fd);
+		return false;
+	}
+	void*	map = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+		return false;
+	_map = static_cast<unsigned char*>(map);
+	_size = info.st_size;
+
+	if (!validate(vkFormat, source))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool	Ktx2File::validate(unsigned int vkFormat, const std::string& source)
+{
+	const unsigned char*	header = _map;
+	if (std::memcmp(header, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) || readU32(header + 12) != vkFormat)
+		return false;
+
+	unsigned int	width = readU32(header + 20), height = readU32(header + 24), levelCount = readU32(header + 40);
+	if (!width || !height || readU32(header + 28) != 0 || readU32(header + 32) != 0 || readU32(header + 36) != 1
+		|| readU32(header + 44) != 0 || levelCount == 0 || levelCount > 32
+		|| KTX2_HEADER_BYTES + static_cast<size_t>(levelCount) * KTX2_LEVEL_INDEX_BYTES > _size)
+		return false;
+
+	// 원본과 인코더 설정이 같은지 확인합니다.
+	size_t	kvdOffset = readU32(header + 56), kvdLength = readU32(header + 60);
+	bool		matched = false;
+	if (kvdOffset > _size || kvdLength > _size - kvdOffset)
+		return false;
+	for (size_t pos = kvdOffset; pos + 4 <= kvdOffset + kvdLength;)
+	{
+		size_t				length = readU32(_map + pos);
+		const char*		entry = reinterpret_cast<const char*>(_map + pos + 4);
+		if (length > kvdOffset + kvdLength - pos - 4)
+			return false;
+		std::string	keyValue(entry, length);
+		size_t			split = keyValue.find('\0');
+		if (split != std::string::npos && keyValue.substr(0, split) == SOURCE_KEY)
+			matched = keyValue.substr(split + 1) == source + '\0';
+		pos += 4 + ((length + 3) & ~static_cast<size_t>(3));
+	}
+	if (!matched)
+		return false;
+
+	_levels.resize(levelCount);
+	for (unsigned int i = 0; i < levelCount; i++)
+	{
+		const unsigned char*	index = header + KTX2_HEADER_BYTES + i * KTX2_LEVEL_INDEX_BYTES;
+		unsigned long long		offset = readU64(index), length = readU64(index + 8);
+		Ktx2Level&						level = _levels[i];
+		level.width = std::max(1u, width >> i);
+		level.height = std::max(1u, height >> i);
+		level.size = levelBytes(vkFormat, level.width, level.height);
+		if (length != level.size || offset > _size || length > _size - offset)
+			return false;
+		level.data = _map + offset;
+	}
+	return true;
+}
+
+void	Ktx2File::write(const std::string& path, unsigned int vkFormat, const std::string& source,
+						const std::vector<Ktx2Level>& levels)
+{
+	std::vector<unsigned char>	head(KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+	putU32(head, vkFormat);
+	putU32(head, 1);										// typeSize
+	putU32(head, levels[0].width);
+	putU32(head, levels[0].height);
+	putU32(head, 0);										// pixelDepth
+	putU32(head, 0);										// layerCount
+	putU32(head, 1);										// faceCount
+	putU32(head, levels.size());
+	putU32(head, 0);										// supercompressionScheme
+	size_t	indexPos = head.size();
+	head.resize(KTX2_HEADER_BYTES + levels.size() * KTX2_LEVEL_INDEX_BYTES, 0);
+
+	size_t	dfdOffset = head.size();
+	putDFD(head, vkFormat);
+	size_t	kvdOffset = head.size();
+	putKeyValue(head, "KTXwriter", "scop");
+	putKeyValue(head, SOURCE_KEY, source);
+
+	// dfd / kvd 위치, sgd 없음
+	std::vector<unsigned char>	index;
+	putU32(index, dfdOffset);
+	putU32(index, kvdOffset - dfdOffset);
+	putU32(index, kvdOffset);
+	putU32(index, head.size() - kvdOffset);
+	putU64(index, 0);
+	putU64(index, 0);
+	std::copy(index.begin(), index.end(), head.begin() + indexPos);
+
+	// level 데이터는 가장 작은 level 부터 이어지고, 각각 블록 크기 (와 4) 에 맞춰 정렬됩니다.
+	size_t							alignment = blockBytes(vkFormat);
+	size_t							offset = head.size();
+	std::vector<size_t>	levelOffset(levels.size());
+	for (size_t i = levels.size(); i-- > 0;)
+	{
+		size_t	entry = KTX2_HEADER_BYTES + i * KTX2_LEVEL_INDEX_BYTES;
+		offset = (offset + alignment - 1) / alignment * alignment;
+		levelOffset[i] = offset;
+		setU64(head, entry, offset);
+		setU64(head, entry + 8, levels[i].size);
+		setU64(head, entry + 16, levels[i].size);
+		offset += levels[i].size;
+	}
+
+	std::string		tmpPath = path + ".tmp";
+	std::ofstream	out(tmpPath, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return ;
+	out.write(reinterpret_cast<const char*>(head.data()), head.size());
+	size_t	written = head.size();
+	for (size_t i = levels.size(); i-- > 0;)
+	{
+		static const char	zeros[16] = {0};
+		out.write(zeros, levelOffset[i] - written);
+		out.write(reinterpret_cast<const char*>(levels[i].data), levels[i].size);
+		written = levelOffset[i] + levels[i].size;
+	}
+	out.close();
+	if (!out || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+		std::remove(tmpPath.c_str());
+}
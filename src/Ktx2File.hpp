@@ -0,0 +1,52 @@
+#ifndef __KTX2FILE_HPP__
+# define __KTX2FILE_HPP__
+
+# include <vector>
+# include <string>
+# include <fstream>
+# include <cstdio>
+# include <cstring>
+# include <algorithm>
+
+// 텍스처 캐시에 쓰는 VkFormat 값
+static const unsigned int	VK_FORMAT_R8G8B8A8_UNORM = 37;
+static const unsigned int	VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+static const unsigned int	VK_FORMAT_BC3_UNORM_BLOCK = 137;
+static const unsigned int	VK_FORMAT_BC5_UNORM_BLOCK = 141;
+
+struct	Ktx2Level {
+	unsigned int					width;
+	unsigned int					height;
+	const unsigned char*	data;
+	size_t								size;
+};
+
+// KTX2 컨테이너 (2D, layer / face 1 개, supercompression 없음) 를 읽고 씁니다.
+// format, mip chain, "scop.source" (원본 hash, 압축 품질, 캐시 버전) 이 모두 맞아야 캐시로 씁니다.
+// 파일은 map 되고, level 의 data 는 close() 또는 소멸 전까지 그 mapping 을 가리킵니다.
+class Ktx2File
+{
+	private:
+		unsigned char*					_map;
+		size_t									_size;
+		std::vector<Ktx2Level>	_levels;
+
+		Ktx2File(const Ktx2File&);
+		Ktx2File&	operator=(const Ktx2File&);
+
+		bool	validate(unsigned int vkFormat, const std::string& source);
+
+	public:
+		Ktx2File();
+		~Ktx2File();
+
+		bool														open(const std::string& path, unsigned int vkFormat, const std::string& source);
+		void														close();
+		const std::vector<Ktx2Level>&		levels() const;
+
+		// 임시 파일에 쓴 뒤 이름을 바꿉니다. 쓰지 못하면 (읽기 전용 디렉토리 등) 조용히 넘어갑니다.
+		static void	write(const std::string& path, unsigned int vkFormat, const std::string& source,
+								const std::vector<Ktx2Level>& levels);
+};
+
+#endif
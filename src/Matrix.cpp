@@ -0,0 +1,632 @@
+#include "Matrix.hpp"
+
+namespace
+{
+	// in 의 4 성분 벡터 count 개를 m 으로 변환합니다. (행렬 곱은 b 의 column 4 개를 변환하는 것과 같습니다)
+	// out 은 in 과 같아도 되지만 m 과 겹치면 안 됩니다.
+	void	transformColumns(const float* m, const float* in, float* out, size_t count)
+	{
+		size_t	i = 0;
+#if defined(__AVX__)
+		// column 을 두 lane 에 복제하고, 벡터 두 개를 한 번에 변환합니다.
+		__m256	c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m));
+		__m256	c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m + 4));
+		__m256	c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m + 8));
+		__m256	c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m + 12));
+		for (; i + 2 <= count; i += 2)
+		{
+			__m256	v = _mm256_loadu_ps(in + i * 4);
+			__m256	r = _mm256_mul_ps(c0, _mm256_permute_ps(v, 0x00));
+			r = _mm256_add_ps(r, _mm256_mul_ps(c1, _mm256_permute_ps(v, 0x55)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(c2, _mm256_permute_ps(v, 0xAA)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(c3, _mm256_permute_ps(v, 0xFF)));
+			_mm256_storeu_ps(out + i * 4, r);
+		}
+#endif
+#if defined(__SSE2__)
+		__m128	s0 = _mm_loadu_ps(m), s1 = _mm_loadu_ps(m + 4), s2 = _mm_loadu_ps(m + 8), s3 = _mm_loadu_ps(m + 12);
+		for (; i < count; i++)
+		{
+			const float*	v = in + i * 4;
+			__m128				r = _mm_mul_ps(s0, _mm_set1_ps(v[0]));
+			r = _mm_add_ps(r, _mm_mul_ps(s1, _mm_set1_ps(v[1])));
+			r = _mm_add_ps(r, _mm_mul_ps(s2, _mm_set1_ps(v[2])));
+			r = _mm_add_ps(r, _mm_mul_ps(s3, _mm_set1_ps(v[3])));
+			_mm_storeu_ps(out + i * 4, r);
+		}
+#elif defined(__ARM_NEON)
+		// vmla 는 AArch64 에서 fused 가 될 수 있으므로 곱셈과 덧셈을 따로 합니다.
+		float32x4_t	n0 = vld1q_f32(m), n1 = vld1q_f32(m + 4), n2 = vld1q_f32(m + 8), n3 = vld1q_f32(m + 12);
+		for (; i < count; i++)
+		{
+			float32x4_t	v = vld1q_f32(in + i * 4);
+			float32x4_t	r = vmulq_lane_f32(n0, vget_low_f32(v), 0);
+			r = vaddq_f32(r, vmulq_lane_f32(n1, vget_low_f32(v), 1));
+			r = vaddq_f32(r, vmulq_lane_f32(n2, vget_high_f32(v), 0));
+			r = vaddq_f32(r, vmulq_lane_f32(n3, vget_high_f32(v), 1));
+			vst1q_f32(out + i * 4, r);
+		}
+#else
+		for (; i < count; i++)
+			transformVec4Scalar(out + i * 4, m, in + i * 4);
+#endif
+	}
+
+#if defined(__SSE2__)
+	// 2x2 행렬 (x, y, z, w) = | x y |
+	//                         | z w |  의 곱, adjugate 곱
+	__m128	swizzle(__m128 v, int mask)
+	{
+		return _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(v), mask));
+	}
+
+	__m128	mat2Mul(__m128 a, __m128 b)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, swizzle(b, _MM_SHUFFLE(3, 0, 3, 0))),
+			_mm_mul_ps(swizzle(a, _MM_SHUFFLE(2, 3, 0, 1)), swizzle(b, _MM_SHUFFLE(1, 2, 1, 2))));
+	}
+
+	__m128	mat2AdjMul(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(swizzle(a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+			_mm_mul_ps(swizzle(a, _MM_SHUFFLE(2, 2, 1, 1)), swizzle(b, _MM_SHUFFLE(1, 0, 3, 2))));
+	}
+
+	__m128	mat2MulAdj(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(a, swizzle(b, _MM_SHUFFLE(0, 3, 0, 3))),
+			_mm_mul_ps(swizzle(a, _MM_SHUFFLE(2, 3, 0, 1)), swizzle(b, _MM_SHUFFLE(1, 2, 1, 2))));
+	}
+#endif
+
+	// m 에 단위 행렬을 바로 씁니다. (Mat4 임시 객체를 만들어 복사하면 store forwarding 이 막혀서 몇 배 느립니다)
+	void	storeIdentity(float* m)
+	{
+		std::memset(m, 0, sizeof(float) * 16);
+		m[0] = m[5] = m[10] = m[15] = 1.0f;
+	}
+
+	// sinCos : x = j * (pi / 2) + r, |r| <= pi / 4 로 줄이고 r 의 minimax 다항식을 구합니다.
+	// pi / 2 는 세 조각 (Cody-Waite) 으로 빼므로 |j| < 2^13 에서 j * PIO2_1, j * PIO2_2 는 정확합니다.
+	const float	TWO_OVER_PI = 0.636619772367581343f;
+	const float	PIO2_1 = 1.5703125f;
+	const float	PIO2_2 = 4.837512969970703125e-4f;
+	const float	PIO2_3 = 7.54978995489188216e-8f;
+	// [-pi / 4, pi / 4] 의 minimax 계수
+	const float	SIN_C1 = -1.6666654611e-1f, SIN_C2 = 8.3321608736e-3f, SIN_C3 = -1.9515295891e-4f;
+	const float	COS_C1 = 4.166664568298827e-2f, COS_C2 = -1.388731625493765e-3f, COS_C3 = 2.443315711809948e-5f;
+
+#if defined(__SSE2__)
+	// 4 개씩. 사분면 (j & 3) 은 정수로 구합니다. (cvtps 는 기본 반올림 모드에서 nearbyintf 와 같습니다)
+	void	sinCos4(const float* x, float* sines, float* cosines)
+	{
+		__m128	v = _mm_loadu_ps(x);
+		__m128i	ji = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(TWO_OVER_PI)));
+		__m128	j = _mm_cvtepi32_ps(ji);
+		__m128	r = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(v, _mm_mul_ps(j, _mm_set1_ps(PIO2_1))),
+						_mm_mul_ps(j, _mm_set1_ps(PIO2_2))), _mm_mul_ps(j, _mm_set1_ps(PIO2_3)));
+		__m128	z = _mm_mul_ps(r, r);
+
+		__m128	sp = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_C3), z), _mm_set1_ps(SIN_C2));
+		sp = _mm_add_ps(_mm_mul_ps(sp, z), _mm_set1_ps(SIN_C1));
+		sp = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sp, z), r), r);
+		__m128	cp = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_C3), z), _mm_set1_ps(COS_C2));
+		cp = _mm_add_ps(_mm_mul_ps(cp, z), _mm_set1_ps(COS_C1));
+		cp = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cp, z), z), _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+		// q = 1, 3 : sin 과 cos 를 바꿉니다. q = 2, 3 : sin 부호, q = 1, 2 : cos 부호
+		__m128i	q = _mm_and_si128(ji, _mm_set1_epi32(3));
+		__m128	swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		__m128	sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(q, 1), 31));
+		__m128	cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_xor_si128(q, _mm_srli_epi32(q, 1)), 31));
+		__m128	sine = _mm_or_ps(_mm_and_ps(swap, cp), _mm_andnot_ps(swap, sp));
+		__m128	cosine = _mm_or_ps(_mm_and_ps(swap, sp), _mm_andnot_ps(swap, cp));
+		_mm_storeu_ps(sines, _mm_xor_ps(sine, sinSign));
+		_mm_storeu_ps(cosines, _mm_xor_ps(cosine, cosSign));
+	}
+#endif
+
+#if defined(__AVX__)
+	// 8 개씩. AVX 에는 256 bit 정수 연산이 없으므로 사분면을 float 로 구합니다.
+	void	sinCos8(const float* x, float* sines, float* cosines)
+	{
+		__m256	v = _mm256_loadu_ps(x);
+		__m256	j = _mm256_round_ps(_mm256_mul_ps(v, _mm256_set1_ps(TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256	r = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(v, _mm256_mul_ps(j, _mm256_set1_ps(PIO2_1))),
+						_mm256_mul_ps(j, _mm256_set1_ps(PIO2_2))), _mm256_mul_ps(j, _mm256_set1_ps(PIO2_3)));
+		__m256	z = _mm256_mul_ps(r, r);
+
+		__m256	sp = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_C3), z), _mm256_set1_ps(SIN_C2));
+		sp = _mm256_add_ps(_mm256_mul_ps(sp, z), _mm256_set1_ps(SIN_C1));
+		sp = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sp, z), r), r);
+		__m256	cp = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_C3), z), _mm256_set1_ps(COS_C2));
+		cp = _mm256_add_ps(_mm256_mul_ps(cp, z), _mm256_set1_ps(COS_C1));
+		cp = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(cp, z), z), _mm256_mul_ps(z, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.0f));
+
+		// q = j - 4 * floor(j / 4) 는 0 ~ 3 의 정확한 float 입니다.
+		__m256	q = _mm256_sub_ps(j, _mm256_mul_ps(_mm256_floor_ps(_mm256_mul_ps(j, _mm256_set1_ps(0.25f))), _mm256_set1_ps(4.0f)));
+		__m256	one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), three = _mm256_set1_ps(3.0f);
+		__m256	swap = _mm256_or_ps(_mm256_cmp_ps(q, one, _CMP_EQ_OQ), _mm256_cmp_ps(q, three, _CMP_EQ_OQ));
+		__m256	sinNeg = _mm256_cmp_ps(q, two, _CMP_GE_OQ);
+		__m256	cosNeg = _mm256_or_ps(_mm256_cmp_ps(q, one, _CMP_EQ_OQ), _mm256_cmp_ps(q, two, _CMP_EQ_OQ));
+		__m256	signBit = _mm256_set1_ps(-0.0f);
+		__m256	sine = _mm256_or_ps(_mm256_and_ps(swap, cp), _mm256_andnot_ps(swap, sp));
+		__m256	cosine = _mm256_or_ps(_mm256_and_ps(swap, sp), _mm256_andnot_ps(swap, cp));
+		_mm256_storeu_ps(sines, _mm256_xor_ps(sine, _mm256_and_ps(sinNeg, signBit)));
+		_mm256_storeu_ps(cosines, _mm256_xor_ps(cosine, _mm256_and_ps(cosNeg, signBit)));
+	}
+#endif
+}
+
+Vec4::Vec4()
+{
+	v[0] = v[1] = v[2] = v[3] = 0.0f;
+}
+
+Vec4::Vec4(float x, float y, float z, float w)
+{
+	v[0] = x;
+	v[1] = y;
+	v[2] = z;
+	v[3] = w;
+}
+
+Mat4::Mat4()
+{
+	std::memset(m, 0, sizeof(m));
+	m[0] = m[5] = m[10] = m[15] = 1.0f;
+}
+
+Mat4	Mat4::load(const float* src)
+{
+	Mat4	result;
+	std::memcpy(result.m, src, sizeof(result.m));
+	return result;
+}
+
+void	Mat4::store(float* dst) const
+{
+	std::memcpy(dst, m, sizeof(m));
+}
+
+Mat4	Mat4::translation(float x, float y, float z)
+{
+	Mat4	result;
+	result.m[12] = x;
+	result.m[13] = y;
+	result.m[14] = z;
+	return result;
+}
+
+Mat4	Mat4::scale(float sx, float sy, float sz)
+{
+	Mat4	result;
+	result.m[0] = sx;
+	result.m[5] = sy;
+	result.m[10] = sz;
+	return result;
+}
+
+Mat4	Mat4::rotationX(float angleDeg)
+{
+	float	angleRad = angleDeg * (3.1415926f / 180.0f);
+	float	c = cosf(angleRad);
+	float	s = sinf(angleRad);
+	Mat4	result;
+
+	result.m[5] = c; result.m[9] = -s;
+	result.m[6] = s; result.m[10] = c;
+	return result;
+}
+
+Mat4	Mat4::rotationY(float angleDeg)
+{
+	float	angleRad = angleDeg * 3.1415926f / 180.0f;
+	float	c = cosf(angleRad);
+	float	s = sinf(angleRad);
+	Mat4	result;
+
+	result.m[0] = c;  result.m[8] = s;
+	result.m[2] = -s; result.m[10] = c;
+	return result;
+}
+
+Mat4	Mat4::rotationZ(float angleDeg)
+{
+	float	angleRad = angleDeg * (3.1415926f / 180.0f);
+	float	c = cosf(angleRad);
+	float	s = sinf(angleRad);
+	Mat4	result;
+
+	result.m[0] = c; result.m[4] = -s;
+	result.m[1] = s; result.m[5] = c;
+	return result;
+}
+
+Mat4	Mat4::rotation(float angleDegX, float angleDegY, float angleDegZ)
+{
+	float	angleRadX = angleDegX * (3.1415926f / 180.0f);
+	float	angleRadY = angleDegY * (3.1415926f / 180.0f);
+	float	angleRadZ = angleDegZ * (3.1415926f / 180.0f);
+
+	float	cx = cosf(angleRadX), cy = cosf(angleRadY), cz = cosf(angleRadZ);
+	float	sx = sinf(angleRadX), sy = sinf(angleRadY), sz = sinf(angleRadZ);
+	Mat4	result;
+
+	result.m[0] = cz * cy;  result.m[4] = sx * sy * cz + cx * sz;  result.m[8] = -cz * sy * cx + sx * sz;
+	result.m[1] = -cy * sz; result.m[5] = -sx * sy * sz + cx * cz; result.m[9] = cx * sy * sz + sx * cz;
+	result.m[2] = sy;       result.m[6] = -sx * cy;                result.m[10] = cx * cy;
+	return result;
+}
+
+// 여러 각도를 SINCOS_BATCH 개씩 sinCos() 로 한 번에 구합니다. 행렬 모양과 각도 변환은 한 개짜리와 같습니다.
+// out 은 float[16 * count] 이고 행렬을 차례로 씁니다.
+void	Mat4::rotationX(const float* angleDeg, float* out, size_t count)
+{
+	float	rad[SINCOS_BATCH], s[SINCOS_BATCH], c[SINCOS_BATCH];
+	for (size_t begin = 0; begin < count; begin += SINCOS_BATCH)
+	{
+		size_t	n = count - begin < SINCOS_BATCH ? count - begin : SINCOS_BATCH;
+		for (size_t i = 0; i < n; i++)
+			rad[i] = angleDeg[begin + i] * (3.1415926f / 180.0f);
+		sinCos(rad, s, c, n);
+		for (size_t i = 0; i < n; i++)
+		{
+			float*	result = out + (begin + i) * 16;
+			storeIdentity(result);
+			result[5] = c[i]; result[9] = -s[i];
+			result[6] = s[i]; result[10] = c[i];
+		}
+	}
+}
+
+void	Mat4::rotationY(const float* angleDeg, float* out, size_t count)
+{
+	float	rad[SINCOS_BATCH], s[SINCOS_BATCH], c[SINCOS_BATCH];
+	for (size_t begin = 0; begin < count; begin += SINCOS_BATCH)
+	{
+		size_t	n = count - begin < SINCOS_BATCH ? count - begin : SINCOS_BATCH;
+		for (size_t i = 0; i < n; i++)
+			rad[i] = angleDeg[begin + i] * 3.1415926f / 180.0f;
+		sinCos(rad, s, c, n);
+		for (size_t i = 0; i < n; i++)
+		{
+			float*	result = out + (begin + i) * 16;
+			storeIdentity(result);
+			result[0] = c[i];  result[8] = s[i];
+			result[2] = -s[i]; result[10] = c[i];
+		}
+	}
+}
+
+void	Mat4::rotationZ(const float* angleDeg, float* out, size_t count)
+{
+	float	rad[SINCOS_BATCH], s[SINCOS_BATCH], c[SINCOS_BATCH];
+	for (size_t begin = 0; begin < count; begin += SINCOS_BATCH)
+	{
+		size_t	n = count - begin < SINCOS_BATCH ? count - begin : SINCOS_BATCH;
+		for (size_t i = 0; i < n; i++)
+			rad[i] = angleDeg[begin + i] * (3.1415926f / 180.0f);
+		sinCos(rad, s, c, n);
+		for (size_t i = 0; i < n; i++)
+		{
+			float*	result = out + (begin + i) * 16;
+			storeIdentity(result);
+			result[0] = c[i]; result[4] = -s[i];
+			result[1] = s[i]; result[5] = c[i];
+		}
+	}
+}
+
+// 세 축의 각도를 한 배열에 이어 붙여서 sinCos() 를 한 번 부릅니다.
+void	Mat4::rotation(const float* angleDegX, const float* angleDegY, const float* angleDegZ, float* out, size_t count)
+{
+	const size_t	n3 = SINCOS_BATCH * 3;
+	float					rad[n3], s[n3], c[n3];
+	for (size_t begin = 0; begin < count; begin += SINCOS_BATCH)
+	{
+		size_t	n = count - begin < SINCOS_BATCH ? count - begin : SINCOS_BATCH;
+		for (size_t i = 0; i < n; i++)
+		{
+			rad[i] = angleDegX[begin + i] * (3.1415926f / 180.0f);
+			rad[n + i] = angleDegY[begin + i] * (3.1415926f / 180.0f);
+			rad[n * 2 + i] = angleDegZ[begin + i] * (3.1415926f / 180.0f);
+		}
+		sinCos(rad, s, c, n * 3);
+		for (size_t i = 0; i < n; i++)
+		{
+			float	cx = c[i], cy = c[n + i], cz = c[n * 2 + i];
+			float	sx = s[i], sy = s[n + i], sz = s[n * 2 + i];
+			float*	result = out + (begin + i) * 16;
+			storeIdentity(result);
+			result[0] = cz * cy;  result[4] = sx * sy * cz + cx * sz;  result[8] = -cz * sy * cx + sx * sz;
+			result[1] = -cy * sz; result[5] = -sx * sy * sz + cx * cz; result[9] = cx * sy * sz + sx * cz;
+			result[2] = sy;       result[6] = -sx * cy;                result[10] = cx * cy;
+		}
+	}
+}
+
+// 원근 투영 행렬
+Mat4	Mat4::perspective(float fov, float aspect, float nearZ, float farZ)
+{
+	float	f = 1.0f / tanf(fov * 0.5f * 3.1415926f / 180.0f);
+	Mat4	result;
+
+	std::memset(result.m, 0, sizeof(result.m));
+	result.m[0] = f / aspect;
+	result.m[5] = f;
+	result.m[10] = (farZ + nearZ) / (nearZ - farZ);
+	result.m[11] = -1.0f;
+	result.m[14] = (2.0f * farZ * nearZ) / (nearZ - farZ);
+	return result;
+}
+
+// 카메라 View 행렬 (LookAt)
+Mat4	Mat4::lookAt(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ,
+					float upX, float upY, float upZ)
+{
+	float	f[3] = { centerX - eyeX, centerY - eyeY, centerZ - eyeZ };
+	float	up[3] = { upX, upY, upZ };
+
+	// Normalize f
+	float	flen = sqrtf(f[0]*f[0] + f[1]*f[1] + f[2]*f[2]);
+	for (int i = 0; i < 3; ++i) f[i] /= flen;
+
+	// s = f x up
+	float	s[3] = {
+		f[1]*up[2] - f[2]*up[1],
+		f[2]*up[0] - f[0]*up[2],
+		f[0]*up[1] - f[1]*up[0]
+	};
+	// Normalize s
+	float	slen = sqrtf(s[0]*s[0] + s[1]*s[1] + s[2]*s[2]);
+	for (int i = 0; i < 3; ++i) s[i] /= slen;
+
+	// u = s x f
+	float	u[3] = {
+		s[1]*f[2] - s[2]*f[1],
+		s[2]*f[0] - s[0]*f[2],
+		s[0]*f[1] - s[1]*f[0]
+	};
+
+	Mat4	t;
+	t.m[0] = s[0]; t.m[4] = s[1]; t.m[8]  = s[2];
+	t.m[1] = u[0]; t.m[5] = u[1]; t.m[9]  = u[2];
+	t.m[2] = -f[0]; t.m[6] = -f[1]; t.m[10] = -f[2];
+
+	return t * translation(-eyeX, -eyeY, -eyeZ);
+}
+
+// 행렬 곱 (result = a * b), result 는 a 나 b 와 같아도 됩니다.
+void	multiplyMat4(float* result, const float* a, const float* b)
+{
+	alignas(16) float	temp[16];
+	transformColumns(a, b, temp, 4);
+	std::memcpy(result, temp, sizeof(temp));
+}
+
+void	transposeMat4(float* result, const float* a)
+{
+#if defined(__SSE2__)
+	__m128	c0 = _mm_loadu_ps(a), c1 = _mm_loadu_ps(a + 4), c2 = _mm_loadu_ps(a + 8), c3 = _mm_loadu_ps(a + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	_mm_storeu_ps(result, c0);
+	_mm_storeu_ps(result + 4, c1);
+	_mm_storeu_ps(result + 8, c2);
+	_mm_storeu_ps(result + 12, c3);
+#elif defined(__ARM_NEON)
+	// vld4q 는 4 개 간격으로 나눠 읽으므로 읽는 것만으로 전치가 됩니다.
+	float32x4x4_t	rows = vld4q_f32(a);
+	vst1q_f32(result, rows.val[0]);
+	vst1q_f32(result + 4, rows.val[1]);
+	vst1q_f32(result + 8, rows.val[2]);
+	vst1q_f32(result + 12, rows.val[3]);
+#else
+	transposeMat4Scalar(result, a);
+#endif
+}
+
+// 2x2 block 으로 나눠서 구합니다. (M^-1)^T = (M^T)^-1 이므로 column-major 도 같은 식입니다.
+bool	inverseMat4(float* result, const float* a)
+{
+#if defined(__SSE2__)
+	__m128	c0 = _mm_loadu_ps(a), c1 = _mm_loadu_ps(a + 4), c2 = _mm_loadu_ps(a + 8), c3 = _mm_loadu_ps(a + 12);
+
+	// 부분 행렬
+	__m128	A = _mm_movelh_ps(c0, c1);
+	__m128	B = _mm_movehl_ps(c1, c0);
+	__m128	C = _mm_movelh_ps(c2, c3);
+	__m128	D = _mm_movehl_ps(c3, c2);
+
+	// (|A|, |B|, |C|, |D|)
+	__m128	detSub = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(c0, c2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(c1, c3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(c0, c2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(c1, c3, _MM_SHUFFLE(2, 0, 2, 0))));
+	__m128	detA = swizzle(detSub, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128	detB = swizzle(detSub, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128	detC = swizzle(detSub, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128	detD = swizzle(detSub, _MM_SHUFFLE(3, 3, 3, 3));
+
+	__m128	D_C = mat2AdjMul(D, C);
+	__m128	A_B = mat2AdjMul(A, B);
+	__m128	X_ = _mm_sub_ps(_mm_mul_ps(detD, A), mat2Mul(B, D_C));
+	__m128	W_ = _mm_sub_ps(_mm_mul_ps(detA, D), mat2Mul(C, A_B));
+	__m128	Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdj(D, A_B));
+	__m128	Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdj(A, D_C));
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128	tr = _mm_mul_ps(A_B, swizzle(D_C, _MM_SHUFFLE(3, 1, 2, 0)));
+	tr = _mm_add_ps(tr, swizzle(tr, _MM_SHUFFLE(1, 0, 3, 2)));
+	tr = _mm_add_ps(tr, swizzle(tr, _MM_SHUFFLE(2, 3, 0, 1)));
+	__m128	detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+	if (_mm_cvtss_f32(detM) == 0.0f)
+		return false;
+
+	__m128	rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	X_ = _mm_mul_ps(X_, rDetM);
+	Y_ = _mm_mul_ps(Y_, rDetM);
+	Z_ = _mm_mul_ps(Z_, rDetM);
+	W_ = _mm_mul_ps(W_, rDetM);
+
+	_mm_storeu_ps(result, _mm_shuffle_ps(X_, Y_, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(result + 4, _mm_shuffle_ps(X_, Y_, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(result + 8, _mm_shuffle_ps(Z_, W_, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(result + 12, _mm_shuffle_ps(Z_, W_, _MM_SHUFFLE(0, 2, 0, 2)));
+	return true;
+#else
+	return inverseMat4Scalar(result, a);
+#endif
+}
+
+void	transformVec4(float* result, const float* m, const float* v)
+{
+	alignas(16) float	temp[4];
+	transformColumns(m, v, temp, 1);
+	std::memcpy(result, temp, sizeof(temp));
+}
+
+void	transformVec4Array(const float* m, const Vec4* in, Vec4* out, size_t count)
+{
+	if (count)
+		transformColumns(m, in[0].v, out[0].v, count);
+}
+
+void	sinCos(const float* radians, float* sines, float* cosines, size_t count)
+{
+	size_t	i = 0;
+#if defined(__AVX__)
+	for (; i + 8 <= count; i += 8)
+		sinCos8(radians + i, sines + i, cosines + i);
+#endif
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4)
+		sinCos4(radians + i, sines + i, cosines + i);
+#endif
+	if (i < count)
+		sinCosScalar(radians + i, sines + i, cosines + i, count - i);
+}
+
+Mat4	operator*(const Mat4& a, const Mat4& b)
+{
+	Mat4	result;
+	transformColumns(a.m, b.m, result.m, 4);
+	return result;
+}
+
+Vec4	operator*(const Mat4& m, const Vec4& v)
+{
+	Vec4	result;
+	transformColumns(m.m, v.v, result.v, 1);
+	return result;
+}
+
+Mat4	transpose(const Mat4& a)
+{
+	Mat4	result;
+	transposeMat4(result.m, a.m);
+	return result;
+}
+
+bool	inverse(const Mat4& a, Mat4& result)
+{
+	return inverseMat4(result.m, a.m);
+}
+
+void	multiplyMat4Scalar(float* result, const float* a, const float* b)
+{
+	float	temp[16];
+	for (int col = 0; col < 4; ++col)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			temp[col * 4 + row] = a[row] * b[col * 4];
+			for (int i = 1; i < 4; ++i)
+				temp[col * 4 + row] += a[i * 4 + row] * b[col * 4 + i];
+		}
+	}
+	std::memcpy(result, temp, sizeof(temp));
+}
+
+void	transposeMat4Scalar(float* result, const float* a)
+{
+	float	temp[16];
+	for (int col = 0; col < 4; ++col)
+		for (int row = 0; row < 4; ++row)
+			temp[row * 4 + col] = a[col * 4 + row];
+	std::memcpy(result, temp, sizeof(temp));
+}
+
+// 여인수 전개
+bool	inverseMat4Scalar(float* result, const float* m)
+{
+	float	inv[16];
+
+	inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15]
+		+ m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15]
+		- m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15]
+		+ m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14]
+		- m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15]
+		- m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15]
+		+ m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15]
+		- m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14]
+		+ m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15]
+		+ m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15]
+		- m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15]
+		+ m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14]
+		- m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11]
+		- m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11]
+		+ m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11]
+		- m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10]
+		+ m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	float	det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+	if (det == 0.0f)
+		return false;
+	det = 1.0f / det;
+	for (int i = 0; i < 16; i++)
+		result[i] = inv[i] * det;
+	return true;
+}
+
+void	transformVec4Scalar(float* result, const float* m, const float* v)
+{
+	float	temp[4];
+	for (int row = 0; row < 4; ++row)
+		temp[row] = m[row] * v[0] + m[4 + row] * v[1] + m[8 + row] * v[2] + m[12 + row] * v[3];
+	std::memcpy(result, temp, sizeof(temp));
+}
+
+// SIMD 판과 같은 연산을 같은 순서로 하므로 결과가 bit 단위로 같습니다.
+void	sinCosScalar(const float* radians, float* sines, float* cosines, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		float	x = radians[i];
+		float	j = nearbyintf(x * TWO_OVER_PI);
+		float	r = ((x - j * PIO2_1) - j * PIO2_2) - j * PIO2_3;
+		float	z = r * r;
+		float	sp = ((SIN_C3 * z + SIN_C2) * z + SIN_C1) * z * r + r;
+		float	cp = ((COS_C3 * z + COS_C2) * z + COS_C1) * z * z - z * 0.5f + 1.0f;
+		int		q = static_cast<int>(j) & 3;
+
+		float	sine = (q & 1) ? cp : sp;
+		float	cosine = (q & 1) ? sp : cp;
+		sines[i] = (q & 2) ? -sine : sine;
+		cosines[i] = (q == 1 || q == 2) ? -cosine : cosine;
+	}
+}
@@ -0,0 +1,79 @@
+#ifndef __MATRIX_HPP__
+# define __MATRIX_HPP__
+
+# include <cmath>
+# include <cstring>
+# include <cstddef>
+
+# if defined(__SSE2__)
+#  include <emmintrin.h>
+# endif
+# if defined(__AVX__)
+#  include <immintrin.h>
+# endif
+# if defined(__ARM_NEON)
+#  include <arm_neon.h>
+# endif
+
+// 4 성분 벡터 (x, y, z, w)
+struct	alignas(16) Vec4 {
+	float	v[4];
+
+	Vec4();
+	Vec4(float x, float y, float z, float w);
+};
+
+// 4x4 행렬, OpenGL 과 같은 column-major (m[col * 4 + row]) 입니다.
+// 16 byte 정렬이므로 column 하나를 SIMD 레지스터 하나로 그대로 읽습니다.
+struct	alignas(16) Mat4 {
+	float	m[16];
+
+	Mat4();		// 단위 행렬
+
+	static Mat4	load(const float* src);
+	void				store(float* dst) const;
+
+	static Mat4	translation(float x, float y, float z);
+	static Mat4	scale(float sx, float sy, float sz);
+	static Mat4	rotationX(float angleDeg);
+	static Mat4	rotationY(float angleDeg);
+	static Mat4	rotationZ(float angleDeg);
+	static Mat4	rotation(float angleDegX, float angleDegY, float angleDegZ);
+	// 여러 각도 (count 개) 를 한 번에, out 은 float[16 * count] 입니다. (Mat4 배열이면 mats[0].m)
+	// sin / cos 는 sinCos() 로 구하므로 libm 을 쓰는 한 개짜리와 ulp 몇 개 다를 수 있습니다.
+	static void	rotationX(const float* angleDeg, float* out, size_t count);
+	static void	rotationY(const float* angleDeg, float* out, size_t count);
+	static void	rotationZ(const float* angleDeg, float* out, size_t count);
+	static void	rotation(const float* angleDegX, const float* angleDegY, const float* angleDegZ, float* out, size_t count);
+	static Mat4	perspective(float fov, float aspect, float nearZ, float farZ);
+	static Mat4	lookAt(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ,
+								float upX, float upY, float upZ);
+};
+
+// SIMD 커널 : SSE2 (AVX 가 켜져 있으면 곱셈은 column 두 개씩), NEON, 그 외에는 scalar 입니다.
+// 모든 커널은 scalar 와 같은 순서로 더하고 FMA 를 쓰지 않아서 결과가 bit 까지 같습니다. (역행렬은 반올림 차이만)
+// 포인터 버전은 정렬되지 않은 float[16] 도 받습니다.
+void	multiplyMat4(float* result, const float* a, const float* b);
+void	transposeMat4(float* result, const float* a);
+bool	inverseMat4(float* result, const float* a);		// 역행렬이 없으면 false, result 는 그대로
+void	transformVec4(float* result, const float* m, const float* v);
+void	transformVec4Array(const float* m, const Vec4* in, Vec4* out, size_t count);
+
+// radians count 개의 sin / cos 를 AVX 는 8 개, SSE2 는 4 개씩 구합니다. (나머지는 scalar, 결과는 모두 같습니다)
+// pi / 2 를 세 부분으로 빼서 [-pi / 4, pi / 4] 로 옮긴 뒤 다항식으로 구합니다. 오차는 |x| <= 8192 에서 7.8e-8 이하이고, 그보다 큰 x 는 지원하지 않습니다.
+static const size_t	SINCOS_BATCH = 16;		// 배치 builder 가 sinCos() 한 번에 넘기는 각도 수
+void	sinCos(const float* radians, float* sines, float* cosines, size_t count);
+
+Mat4	operator*(const Mat4& a, const Mat4& b);
+Vec4	operator*(const Mat4& m, const Vec4& v);
+Mat4	transpose(const Mat4& a);
+bool	inverse(const Mat4& a, Mat4& result);
+
+// scalar 기준 구현 : SIMD 커널을 검증할 때 씁니다.
+void	multiplyMat4Scalar(float* result, const float* a, const float* b);
+void	transposeMat4Scalar(float* result, const float* a);
+bool	inverseMat4Scalar(float* result, const float* a);
+void	transformVec4Scalar(float* result, const float* m, const float* v);
+void	sinCosScalar(const float* radians, float* sines, float* cosines, size_t count);
+
+#endif
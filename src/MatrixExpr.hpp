@@ -0,0 +1,296 @@
+#ifndef __MATRIXEXPR_HPP__
+# define __MATRIXEXPR_HPP__
+
+# include "Matrix.hpp"
+
+// 컴파일 시간에 계산할 수 있는 (constexpr) 행렬 / 벡터와 expression template 입니다. (header only)
+// builder 는 Mat4 의 builder 와 같은 float 연산을 같은 순서로 해서 결과가 같습니다. (constPerspective 는 fov 에 따라 tan 이 1 ulp 다를 수 있음, make check)
+// 곱이 아닌 식 (덧셈, 상수배) 은 원소를 읽을 때 바로 계산되어 임시 행렬 없이 하나로 합쳐집니다.
+// 곱은 왼쪽 식을 한 번만 계산하고 multiplyMat4 와 같은 순서로 더하므로 a * b * c 는 Mat4 의 (a * b) * c 와 같습니다.
+
+// 각도 변환 : Mat4::rotationX / Z 와 같은 식 (degree * (pi / 180))
+static constexpr float	DEG_TO_RAD = 3.1415926f / 180.0f;
+
+constexpr float	radians(float degree)
+{
+	return degree * DEG_TO_RAD;
+}
+
+// 양수 float x 의 ulp (x 보다 크지 않은 가장 큰 2 의 거듭제곱 * 2^-23)
+constexpr double	floatUlp(float x)
+{
+	double	power = 1.0;
+	while (power > x)
+		power /= 2.0;
+	while (power * 2.0 <= x)
+		power *= 2.0;
+	return power / 8388608.0;
+}
+
+// 정확히 반올림된 sqrt (x >= 0), sqrtf 와 같습니다.
+// x 를 4 의 거듭제곱으로 [1, 4) 에 옮겨 double Newton 으로 구한 뒤, 위 / 아래 중간값의 제곱과
+// 비교해서 맞춥니다. (25 bit 수의 제곱은 double 에서 정확합니다)
+constexpr float	constSqrt(float x)
+{
+	if (x <= 0.0f)
+		return 0.0f;
+	double	scaled = x, factor = 1.0;
+	while (scaled >= 4.0)
+	{
+		scaled /= 4.0;
+		factor *= 2.0;
+	}
+	while (scaled < 1.0)
+	{
+		scaled *= 4.0;
+		factor /= 2.0;
+	}
+	double	r = 1.5;
+	for (int i = 0; i < 8; i++)
+		r = 0.5 * (r + scaled / r);
+	float	result = static_cast<float>(r * factor);
+	for (int i = 0; i < 2; i++)
+	{
+		double	up = floatUlp(result);
+		double	down = result == up * 8388608.0 ? up / 2.0 : up;		// 2 의 거듭제곱 아래는 간격이 절반
+		double	high = result + up / 2.0, low = result - down / 2.0;
+		if (high * high <= x)
+			result = static_cast<float>(result + up);
+		else if (low * low > x)
+			result = static_cast<float>(result - down);
+	}
+	return result;
+}
+
+// |x| <= pi / 2 의 tan : sin / cos 급수를 double 로 구해서 한 번만 반올림합니다.
+constexpr float	constTan(float x)
+{
+	double	value = x, sine = 0.0, cosine = 0.0, term = 1.0;
+	for (int n = 0; n < 40; n++)
+	{
+		cosine += term;
+		term *= value / (2 * n + 1);
+		sine += term;
+		term *= -value / (2 * n + 2);
+	}
+	return static_cast<float>(sine / cosine);
+}
+
+template <typename E, int R, int C>
+struct	MatExpr {
+	constexpr float	operator()(int row, int col) const
+	{
+		return static_cast<const E&>(*this)(row, col);
+	}
+};
+
+// R x C 행렬, column-major (m[col * R + row])
+template <int R, int C>
+struct	TMat : public MatExpr<TMat<R, C>, R, C> {
+	float	m[R * C];
+
+	constexpr TMat() : m()
+	{
+	}
+
+	template <typename E>
+	constexpr TMat(const MatExpr<E, R, C>& expr) : m()
+	{
+		for (int col = 0; col < C; col++)
+			for (int row = 0; row < R; row++)
+				m[col * R + row] = expr(row, col);
+	}
+
+	constexpr float	operator()(int row, int col) const
+	{
+		return m[col * R + row];
+	}
+
+	constexpr float&	at(int row, int col)
+	{
+		return m[col * R + row];
+	}
+
+	static constexpr TMat	identity()
+	{
+		TMat	result;
+		for (int i = 0; i < R && i < C; i++)
+			result.at(i, i) = 1.0f;
+		return result;
+	}
+
+	void	store(float* dst) const
+	{
+		for (int i = 0; i < R * C; i++)
+			dst[i] = m[i];
+	}
+};
+
+template <int N>
+using TVec = TMat<N, 1>;
+
+// 식 안에서 행렬은 참조로, 식은 값으로 들고 있습니다. 그래서 임시 행렬을 참조로 들게 되는 연산은 막아 둡니다. (아래 delete)
+template <typename E>
+struct	ExprStorage {
+	typedef E	type;
+};
+
+template <int R, int C>
+struct	ExprStorage<TMat<R, C> > {
+	typedef const TMat<R, C>&	type;
+};
+
+template <typename A, typename B, int R, int C>
+struct	MatSum : public MatExpr<MatSum<A, B, R, C>, R, C> {
+	typename ExprStorage<A>::type	a;
+	typename ExprStorage<B>::type	b;
+
+	constexpr MatSum(const A& left, const B& right) : a(left), b(right)
+	{
+	}
+
+	constexpr float	operator()(int row, int col) const
+	{
+		return a(row, col) + b(row, col);
+	}
+};
+
+template <typename A, int R, int C>
+struct	MatScale : public MatExpr<MatScale<A, R, C>, R, C> {
+	typename ExprStorage<A>::type	a;
+	float													s;
+
+	constexpr MatScale(const A& left, float scale) : a(left), s(scale)
+	{
+	}
+
+	constexpr float	operator()(int row, int col) const
+	{
+		return a(row, col) * s;
+	}
+};
+
+// 왼쪽이 식이면 한 번 계산해 둡니다. 오른쪽은 column 마다 한 번씩만 읽히므로 그대로 둡니다.
+template <typename A, typename B, int R, int K, int C>
+struct	MatProduct : public MatExpr<MatProduct<A, B, R, K, C>, R, C> {
+	TMat<R, K>										a;
+	typename ExprStorage<B>::type	b;
+
+	constexpr MatProduct(const A& left, const B& right) : a(left), b(right)
+	{
+	}
+
+	constexpr float	operator()(int row, int col) const
+	{
+		float	sum = a(row, 0) * b(0, col);
+		for (int k = 1; k < K; k++)
+			sum += a(row, k) * b(k, col);
+		return sum;
+	}
+};
+
+template <typename A, typename B, int R, int C>
+constexpr MatSum<A, B, R, C>	operator+(const MatExpr<A, R, C>& a, const MatExpr<B, R, C>& b)
+{
+	return MatSum<A, B, R, C>(static_cast<const A&>(a), static_cast<const B&>(b));
+}
+
+template <typename A, int R, int C>
+constexpr MatScale<A, R, C>	operator*(const MatExpr<A, R, C>& a, float s)
+{
+	return MatScale<A, R, C>(static_cast<const A&>(a), s);
+}
+
+template <typename A, typename B, int R, int K, int C>
+constexpr MatProduct<A, B, R, K, C>	operator*(const MatExpr<A, R, K>& a, const MatExpr<B, K, C>& b)
+{
+	return MatProduct<A, B, R, K, C>(static_cast<const A&>(a), static_cast<const B&>(b));
+}
+
+// 임시 행렬을 참조로 들면 auto e = ... 로 남긴 식이 사라진 행렬을 읽습니다. (곱의 왼쪽은 값으로 들고 있어서 괜찮습니다)
+template <typename B, int R, int C>
+MatSum<TMat<R, C>, B, R, C>	operator+(TMat<R, C>&& a, const MatExpr<B, R, C>& b) = delete;
+
+template <typename A, int R, int C>
+MatSum<A, TMat<R, C>, R, C>	operator+(const MatExpr<A, R, C>& a, TMat<R, C>&& b) = delete;
+
+template <int R, int C>
+MatScale<TMat<R, C>, R, C>	operator*(TMat<R, C>&& a, float s) = delete;
+
+template <typename A, int R, int K, int C>
+MatProduct<A, TMat<K, C>, R, K, C>	operator*(const MatExpr<A, R, K>& a, TMat<K, C>&& b) = delete;
+
+// 행렬 식을 Mat4 로 계산합니다. (SIMD 커널로 넘길 때)
+template <typename E>
+Mat4	toMat4(const MatExpr<E, 4, 4>& expr)
+{
+	Mat4	result;
+	TMat<4, 4>(expr).store(result.m);
+	return result;
+}
+
+// Mat4 builder 의 constexpr 판. 같은 float 연산을 같은 순서로 합니다.
+constexpr TMat<4, 4>	constTranslation(float x, float y, float z)
+{
+	TMat<4, 4>	result = TMat<4, 4>::identity();
+	result.at(0, 3) = x;
+	result.at(1, 3) = y;
+	result.at(2, 3) = z;
+	return result;
+}
+
+constexpr TMat<4, 4>	constScale(float sx, float sy, float sz)
+{
+	TMat<4, 4>	result = TMat<4, 4>::identity();
+	result.at(0, 0) = sx;
+	result.at(1, 1) = sy;
+	result.at(2, 2) = sz;
+	return result;
+}
+
+constexpr TMat<4, 4>	constPerspective(float fov, float aspect, float nearZ, float farZ)
+{
+	float				f = 1.0f / constTan(fov * 0.5f * 3.1415926f / 180.0f);
+	TMat<4, 4>	result;
+
+	result.at(0, 0) = f / aspect;
+	result.at(1, 1) = f;
+	result.at(2, 2) = (farZ + nearZ) / (nearZ - farZ);
+	result.at(3, 2) = -1.0f;
+	result.at(2, 3) = (2.0f * farZ * nearZ) / (nearZ - farZ);
+	return result;
+}
+
+constexpr TMat<4, 4>	constLookAt(float eyeX, float eyeY, float eyeZ, float centerX, float centerY, float centerZ,
+								float upX, float upY, float upZ)
+{
+	float	f[3] = { centerX - eyeX, centerY - eyeY, centerZ - eyeZ };
+	float	up[3] = { upX, upY, upZ };
+
+	float	flen = constSqrt(f[0]*f[0] + f[1]*f[1] + f[2]*f[2]);
+	for (int i = 0; i < 3; ++i) f[i] /= flen;
+
+	float	s[3] = {
+		f[1]*up[2] - f[2]*up[1],
+		f[2]*up[0] - f[0]*up[2],
+		f[0]*up[1] - f[1]*up[0]
+	};
+	float	slen = constSqrt(s[0]*s[0] + s[1]*s[1] + s[2]*s[2]);
+	for (int i = 0; i < 3; ++i) s[i] /= slen;
+
+	float	u[3] = {
+		s[1]*f[2] - s[2]*f[1],
+		s[2]*f[0] - s[0]*f[2],
+		s[0]*f[1] - s[1]*f[0]
+	};
+
+	TMat<4, 4>	t = TMat<4, 4>::identity();
+	t.at(0, 0) = s[0]; t.at(0, 1) = s[1]; t.at(0, 2) = s[2];
+	t.at(1, 0) = u[0]; t.at(1, 1) = u[1]; t.at(1, 2) = u[2];
+	t.at(2, 0) = -f[0]; t.at(2, 1) = -f[1]; t.at(2, 2) = -f[2];
+
+	TMat<4, 4>	translation = constTranslation(-eyeX, -eyeY, -eyeZ);
+	return t * translation;
+}
+
+#endif
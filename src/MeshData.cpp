@@ -0,0 +1,237 @@
+#include "MeshData.hpp"
+
+ObjData::ObjData() : vtFlag(0), vnFlag(0)
+{
+}
+
+bool	parseObjLine(const std::string& line, ObjData& data, std::string& mtlFile)
+{
+	std::istringstream iss(line);
+
+	std::string prefix;
+	iss >> prefix;
+	char	rest;
+
+	if (prefix == "v")
+	{
+		float x, y, z;
+		if (!(iss >> x >> y >> z) || iss >> rest)
+			throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nvertex data is in wrong format.");
+		data.vertices.push_back(x);
+		data.vertices.push_back(y);
+		data.vertices.push_back(z);
+	}
+	else if (prefix == "vn")
+	{
+		float x, y, z;
+		if (!(iss >> x >> y >> z) || iss >> rest)
+			throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal data is in wrong format.");
+		data.normals.push_back(x);
+		data.normals.push_back(y);
+		data.normals.push_back(z);
+	}
+	else if (prefix == "vt")
+	{
+		float x, y, z;
+		if (!(iss >> x >> y >> z) || iss >> rest)
+			throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\ntexture data is in wrong format.");
+		data.textures.push_back(x);
+		data.textures.push_back(y);
+	}
+	else if (prefix == "mtllib")
+	{
+		mtlFile.clear();
+		iss >> mtlFile;
+		return true;
+	}
+	else if (prefix == "f")
+	{
+		std::vector<FaceData> face_indices;
+		int					vIdx, vtIdx, vnIdx;
+		std::string	face;
+		char				delim;
+		char&				vt_flag = data.vtFlag;
+		char&				vn_flag = data.vnFlag;
+
+		// f 다음에 나오는 모든 정점 인덱스 읽기
+		while (std::getline(iss, face, ' '))
+		{
+			if (face.empty()) continue;
+
+			vIdx = 0; vtIdx = 0; vnIdx = 0;
+			std::stringstream	faceStream(face);
+
+			if (faceStream >> vIdx)
+			{
+				if (faceStream >> delim)
+				{
+					if (faceStream.peek() == '/')
+					{
+						faceStream.get(); // skip second '/'
+						if (vt_flag == 1)
+							throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\ntexture indeces are missing.");
+						else
+							vt_flag = 2;
+						if (!(faceStream >> vnIdx))
+						{
+							if (vn_flag == 1)
+								throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal indeces are missing.");
+							else
+								vn_flag = 2;
+							vnIdx = 0;
+						}
+						else if (vn_flag == 2)
+								throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal indeces are missing.");
+						else
+							vn_flag = 1;
+					}
+					else
+					{
+						if (!(faceStream >> vtIdx))
+						{
+							if (vt_flag == 1)
+							throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\ntexture indeces are missing.");
+							else
+								vt_flag = 2;
+							vtIdx = 0;
+						}
+						else if (vt_flag == 2)
+							throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\ntexture indeces are missing.");
+						else
+							vt_flag = 1;
+						if (faceStream >> delim && !(faceStream >> vnIdx))
+						{
+							if (vn_flag == 1)
+								throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal indeces are missing.");
+							else
+								vn_flag = 2;
+							vnIdx = 0;
+						}
+						else if (vn_flag == 2)
+								throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal indeces are missing.");
+						else
+							vn_flag = 1;
+					}
+				}
+				face_indices.push_back({vIdx - 1, vtIdx - 1, vnIdx - 1});
+			}
+			else
+				throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nvertex indeces are missing.");
+		}
+
+		// 팬 트라이앵글 방식으로 삼각형 분할
+		for (size_t i = 1; i + 1 < face_indices.size(); ++i)
+		{
+			data.faceData.push_back(face_indices[0]);
+			data.faceData.push_back(face_indices[i]);
+			data.faceData.push_back(face_indices[i + 1]);
+		}
+	}
+	return false;
+}
+
+void	generateFaceNormals(ObjData& data)
+{
+	if (data.vnFlag && data.normals.size())
+		return ;
+
+	data.normals.clear();
+	int	normalIndex = 0;
+	for (size_t i = 0; i + 2 < data.faceData.size(); i += 3)
+	{
+		float	A[3] = {
+			data.vertices[data.faceData[i].vertex * 3 + 0],
+			data.vertices[data.faceData[i].vertex * 3 + 1],
+			data.vertices[data.faceData[i].vertex * 3 + 2]
+		};
+		float	B[3] = {
+			data.vertices[data.faceData[i + 1].vertex * 3 + 0],
+			data.vertices[data.faceData[i + 1].vertex * 3 + 1],
+			data.vertices[data.faceData[i + 1].vertex * 3 + 2]
+		};
+		float	C[3] = {
+			data.vertices[data.faceData[i + 2].vertex * 3 + 0],
+			data.vertices[data.faceData[i + 2].vertex * 3 + 1],
+			data.vertices[data.faceData[i + 2].vertex * 3 + 2]
+		};
+		std::vector<float>	normal = findNormal(A, B, C);
+		data.normals.insert(data.normals.end(), normal.begin(), normal.end());
+		data.faceData[i].normal = normalIndex;
+		data.faceData[i + 1].normal = normalIndex;
+		data.faceData[i + 2].normal = normalIndex;
+		++normalIndex;
+	}
+}
+
+std::vector<float>	findNormal(const float *A, const float *B, const float *C)
+{
+	float	firstVector[3] = {
+		B[0] - A[0],
+		B[1] - A[1],
+		B[2] - A[2]
+	};
+	float	secondVector[3] = {
+		C[0] - A[0],
+		C[1] - A[1],
+		C[2] - A[2]
+	};
+	std::vector<float>	normal = {
+		firstVector[1] * secondVector[2] - firstVector[2] * secondVector[1],
+		firstVector[2] * secondVector[0] - firstVector[0] * secondVector[2],
+		firstVector[0] * secondVector[1] - firstVector[1] * secondVector[0]
+	};
+	return normal;
+}
+
+Bounds	shiftToCentre(std::vector<float>& vertices)
+{
+	// 모든 정점의 최소 / 최대 좌표 계산
+	// -------------------------
+	float	FLT_MAX = std::numeric_limits<float>::max();
+	float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+	float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+
+	for (size_t i = 0; i < vertices.size(); i += 3)
+	{
+		float x = vertices[i];
+		float y = vertices[i + 1];
+		float z = vertices[i + 2];
+
+		if (x < minX) minX = x;
+		if (y < minY) minY = y;
+		if (z < minZ) minZ = z;
+		if (x > maxX) maxX = x;
+		if (y > maxY) maxY = y;
+		if (z > maxZ) maxZ = z;
+	}
+	// 중심점(center) 계산
+	// ----------------
+	float centerX = (minX + maxX) / 2.0f;
+	float centerY = (minY + maxY) / 2.0f;
+	float centerZ = (minZ + maxZ) / 2.0f;
+	float	maxLength = (maxX - minX) > (maxY - minY) ? (maxX - minX) : (maxY - minY);
+	maxLength = ((maxZ - minZ) > maxLength ? (maxZ - minZ) : maxLength);
+
+	// 모든 정점을 중심 기준으로 이동
+	// ----------------------
+	float	radiusSquared = 0.0f;
+	for (size_t i = 0; i < vertices.size(); i += 3)
+	{
+		vertices[i]     = (vertices[i]     - centerX) / maxLength;  // x
+		vertices[i + 1] = (vertices[i + 1] - centerY) / maxLength;  // y
+		vertices[i + 2] = (vertices[i + 2] - centerZ) / maxLength;  // z
+		float	distance = vertices[i] * vertices[i] + vertices[i + 1] * vertices[i + 1] + vertices[i + 2] * vertices[i + 2];
+		if (distance > radiusSquared)
+			radiusSquared = distance;
+	}
+
+	// 같은 식으로 옮기므로 (반올림이 단조라서) 옮긴 min / max 가 그대로 옮긴 정점들의 경계입니다.
+	Bounds	bounds = {
+		{ (minX - centerX) / maxLength, (minY - centerY) / maxLength, (minZ - centerZ) / maxLength },
+		{ (maxX - centerX) / maxLength, (maxY - centerY) / maxLength, (maxZ - centerZ) / maxLength },
+		std::sqrt(radiusSquared)
+	};
+	if (vertices.empty())
+		bounds = Bounds();
+	return bounds;
+}
@@ -0,0 +1,47 @@
+#ifndef __MESHDATA_HPP__
+# define __MESHDATA_HPP__
+
+# include <vector>
+# include <string>
+# include <sstream>
+# include <limits>
+# include <cmath>
+# include <stdexcept>
+
+// OBJ 를 읽고 정점을 다듬는 부분입니다. GL 을 쓰지 않으므로 bench 에서도 그대로 씁니다.
+
+struct	FaceData {
+	int	vertex;
+	int	texture;
+	int	normal;
+};
+
+// 정점들을 감싸는 AABB 와 원점 (shiftToCentre 뒤에는 AABB 중심) 을 중심으로 하는 bounding sphere 의 반지름
+struct	Bounds {
+	float	min[3];
+	float	max[3];
+	float	radius;
+};
+
+// OBJ 파일 하나에서 모은 데이터. face 는 팬 방식으로 삼각형 단위로 나눠 둡니다.
+struct	ObjData {
+	std::vector<float>		vertices;
+	std::vector<float>		normals;
+	std::vector<float>		textures;
+	std::vector<FaceData>	faceData;
+	char									vtFlag, vnFlag;		// face 에 uv / 노멀 인덱스가 있는지 (0 모름, 1 있음, 2 없음)
+
+	ObjData();
+};
+
+// 한 줄을 읽어 data 에 더합니다. 형식이 틀리면 예외를 던집니다.
+// mtllib 줄이면 파일 이름을 mtlFile 에 넣고 true 를 돌려줍니다. (MTL 은 부르는 쪽이 읽습니다)
+bool								parseObjLine(const std::string& line, ObjData& data, std::string& mtlFile);
+// 노멀이 없으면 삼각형마다 면 노멀을 만들어 face 에 연결합니다.
+void								generateFaceNormals(ObjData& data);
+
+std::vector<float>	findNormal(const float *A, const float *B, const float *C);
+// 정점을 bounding box 중심으로 옮기고 가장 긴 변이 1 이 되게 줄입니다. 옮긴 뒤의 경계를 돌려줍니다.
+Bounds							shiftToCentre(std::vector<float>& vertices);
+
+#endif
@@ -0,0 +1,162 @@
+#include "NormalMap.hpp"
+#include "TextureCache.hpp"
+
+namespace
+{
+	struct	NormalCacheHeader {
+		char								magic[4];
+		unsigned int				version;
+		unsigned int				width;
+		unsigned int				height;
+		float								strength;
+		unsigned int				padding;
+		unsigned long long	hash;
+	};
+
+	const unsigned int	NORMAL_CACHE_VERSION = 1;
+	const int						HEIGHT_MAP_TOLERANCE = 4;	// 압축된 회색조 이미지의 채널 차이 허용치
+
+	unsigned char	encode(float value)
+	{
+		int	encoded = static_cast<int>(std::lround(value * 127.5f + 127.5f));
+		return static_cast<unsigned char>(std::min(255, std::max(0, encoded)));
+	}
+
+	// Sobel 로 한 행을 변환합니다. rows 는 (y - 1, y, y + 1) 의 높이 행입니다.
+	void	convertRow(const float* below, const float* row, const float* above, unsigned int width,
+					float strength, unsigned char* out)
+	{
+		unsigned int	x = 1;
+#if defined(__SSE2__)
+		const __m128	two = _mm_set1_ps(2.0f);
+		const __m128	scale = _mm_set1_ps(-strength);
+		const __m128	one = _mm_set1_ps(1.0f);
+		const __m128	half = _mm_set1_ps(127.5f);
+		const __m128i	alpha = _mm_set1_epi32(255);
+		for (; x + 4 < width; x += 4)
+		{
+			__m128	bl = _mm_loadu_ps(below + x - 1), bc = _mm_loadu_ps(below + x), br = _mm_loadu_ps(below + x + 1);
+			__m128	ml = _mm_loadu_ps(row + x - 1), mr = _mm_loadu_ps(row + x + 1);
+			__m128	al = _mm_loadu_ps(above + x - 1), ac = _mm_loadu_ps(above + x), ar = _mm_loadu_ps(above + x + 1);
+
+			__m128	dx = _mm_sub_ps(_mm_add_ps(_mm_add_ps(br, ar), _mm_mul_ps(two, mr)),
+								_mm_add_ps(_mm_add_ps(bl, al), _mm_mul_ps(two, ml)));
+			__m128	dy = _mm_sub_ps(_mm_add_ps(_mm_add_ps(al, ar), _mm_mul_ps(two, ac)),
+								_mm_add_ps(_mm_add_ps(bl, br), _mm_mul_ps(two, bc)));
+			__m128	nx = _mm_mul_ps(dx, scale);
+			__m128	ny = _mm_mul_ps(dy, scale);
+			__m128	length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), one));
+			__m128	inv = _mm_div_ps(half, length);
+
+			__m128i	r = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(nx, inv), half));
+			__m128i	g = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(ny, inv), half));
+			__m128i	b = _mm_cvtps_epi32(_mm_add_ps(inv, half));
+			// r0 r1 r2 r3 g0 .. / b0 .. a3 -> r0 g0 b0 a0 r1 ..
+			__m128i	rg = _mm_packs_epi32(r, g);
+			__m128i	ba = _mm_packs_epi32(b, alpha);
+			__m128i	rb = _mm_unpacklo_epi16(rg, ba);
+			__m128i	ga = _mm_unpackhi_epi16(rg, ba);
+			__m128i	pixels = _mm_packus_epi16(_mm_unpacklo_epi16(rb, ga), _mm_unpackhi_epi16(rb, ga));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), pixels);
+		}
+#endif
+		// 남은 픽셀과 양 끝 (좌우가 이어지는) 픽셀
+		for (unsigned int i = 0; i < width; i++)
+		{
+			if (i >= 1 && i < x)
+				continue ;
+			unsigned int	l = (i + width - 1) % width, r = (i + 1) % width;
+			float	dx = (below[r] + 2.0f * row[r] + above[r]) - (below[l] + 2.0f * row[l] + above[l]);
+			float	dy = (above[l] + 2.0f * above[i] + above[r]) - (below[l] + 2.0f * below[i] + below[r]);
+			float	nx = -dx * strength, ny = -dy * strength;
+			float	inv = 1.0f / std::sqrt(nx * nx + ny * ny + 1.0f);
+			out[i * 4 + 0] = encode(nx * inv);
+			out[i * 4 + 1] = encode(ny * inv);
+			out[i * 4 + 2] = encode(inv);
+			out[i * 4 + 3] = 255;
+		}
+	}
+}
+
+bool	isHeightMap(const std::vector<unsigned char>& rgba)
+{
+	for (size_t i = 0; i + 3 < rgba.size(); i += 4)
+	{
+		if (std::abs(rgba[i] - rgba[i + 1]) > HEIGHT_MAP_TOLERANCE || std::abs(rgba[i + 1] - rgba[i + 2]) > HEIGHT_MAP_TOLERANCE)
+			return false;
+	}
+	return true;
+}
+
+void	heightToNormalMap(const std::vector<unsigned char>& rgba, unsigned int width, unsigned int height,
+						std::vector<unsigned char>& normal, float strength, unsigned int threadCount)
+{
+	// 높이는 [0, 1] 의 밝기입니다.
+	std::vector<float>	heights(static_cast<size_t>(width) * height);
+	for (size_t i = 0; i < heights.size(); i++)
+		heights[i] = (rgba[i * 4] + rgba[i * 4 + 1] + rgba[i * 4 + 2]) * (1.0f / (3.0f * 255.0f));
+
+	normal.resize(static_cast<size_t>(width) * height * 4);
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	threadCount = std::min(threadCount, height);
+
+	// 행 묶음마다 스레드 하나
+	std::vector<std::thread>	workers;
+	for (unsigned int t = 0; t < threadCount; t++)
+	{
+		unsigned int	begin = height * t / threadCount, end = height * (t + 1) / threadCount;
+		workers.push_back(std::thread([&, begin, end]()
+		{
+			for (unsigned int y = begin; y < end; y++)
+			{
+				const float*	below = &heights[static_cast<size_t>((y + height - 1) % height) * width];
+				const float*	above = &heights[static_cast<size_t>((y + 1) % height) * width];
+				convertRow(below, &heights[static_cast<size_t>(y) * width], above, width, strength,
+					&normal[static_cast<size_t>(y) * width * 4]);
+			}
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+}
+
+void	loadNormalMap(const std::string& path, const std::vector<unsigned char>& file, unsigned long long hash,
+						std::vector<unsigned char>& rgba, unsigned int& width, unsigned int& height)
+{
+	std::string				cachePath = path + ".nrm";
+	NormalCacheHeader	header;
+
+	{
+		std::ifstream	cache(cachePath, std::ios::binary);
+		if (cache.is_open() && cache.read(reinterpret_cast<char*>(&header), sizeof(header))
+			&& !std::memcmp(header.magic, "NRML", 4) && header.version == NORMAL_CACHE_VERSION
+			&& header.hash == hash && header.strength == DEFAULT_BUMP_STRENGTH && header.width && header.height)
+		{
+			rgba.resize(static_cast<size_t>(header.width) * header.height * 4);
+			if (cache.read(reinterpret_cast<char*>(rgba.data()), rgba.size()))
+			{
+				width = header.width;
+				height = header.height;
+				return ;
+			}
+		}
+	}
+
+	std::vector<unsigned char>	image;
+	TextureCache::decodeImage(path, file, image, width, height);
+	if (!isHeightMap(image))
+	{
+		rgba.swap(image);
+		return ;
+	}
+	heightToNormalMap(image, width, height, rgba);
+
+	// 캐시를 쓰지 못해도 (읽기 전용 디렉토리 등) 로딩은 계속 진행합니다.
+	std::ofstream			cache(cachePath, std::ios::binary | std::ios::trunc);
+	NormalCacheHeader	out = {{'N', 'R', 'M', 'L'}, NORMAL_CACHE_VERSION, width, height, DEFAULT_BUMP_STRENGTH, 0, hash};
+	if (!cache.is_open())
+		return ;
+	cache.write(reinterpret_cast<const char*>(&out), sizeof(out));
+	cache.write(reinterpret_cast<const char*>(rgba.data()), rgba.size());
+}
@@ -0,0 +1,32 @@
+#ifndef __NORMALMAP_HPP__
+# define __NORMALMAP_HPP__
+
+# include <vector>
+# include <string>
+# include <fstream>
+# include <cstring>
+# include <cmath>
+# include <thread>
+# include <algorithm>
+
+# if defined(__SSE2__)
+#  include <emmintrin.h>
+# endif
+
+// 높이 맵 -> tangent space 노멀 맵 변환
+// MTL 의 bump map 은 높이 맵입니다. 회색조 이미지는 높이로 보고 3x3 Sobel 로 기울기를 구해
+// (-dh/du, -dh/dv, 1 / strength) 를 정규화한 노멀을 RGB = n * 0.5 + 0.5 로 저장합니다.
+// 가장자리는 GL_REPEAT 처럼 반대편으로 이어지고, 컬러 이미지는 이미 노멀 맵으로 보고 그대로 둡니다.
+
+static const float	DEFAULT_BUMP_STRENGTH = 2.0f;
+
+bool	isHeightMap(const std::vector<unsigned char>& rgba);
+void	heightToNormalMap(const std::vector<unsigned char>& rgba, unsigned int width, unsigned int height,
+						std::vector<unsigned char>& normal, float strength = DEFAULT_BUMP_STRENGTH,
+						unsigned int threadCount = 0);
+
+// 디코딩 + 변환, 결과는 <path>.nrm 에 캐시합니다. (원본 파일 hash 가 다르면 다시 만듭니다)
+void	loadNormalMap(const std::string& path, const std::vector<unsigned char>& file, unsigned long long hash,
+						std::vector<unsigned char>& rgba, unsigned int& width, unsigned int& height);
+
+#endif
@@ -1,15 +1,14 @@
 #include "Object.hpp"
 
 Object::Object(const char* path) : 
-_path(path), _VBO(0), _VAO(0), _EBO(0),
-_DiffTextureID(0), _BumpTextureID(0),
-_TextureRatio(0.0f), _TextureMode(false)
+_path(path), _bounds(), _VBO(0), _VAO(0), _EBO(0),
+_DiffTextureID(0), _BumpTextureID(0), _virtualTextureID(0),
+_transformID(0), _TextureRatio(0.0f), _TextureMode(false), _isTextureExist(false), _isTextureLoaded(false)
 {
-	for (int i = 0; i < 3; i++)
+	for (int i = 0; i < 2; i++)
 	{
-		_pos[i] = 0;
-		_rot[i] = 0;
-		_scale[i] = 1;
+		_uvOffset[i] = 0;
+		_uvScale[i] = 1;
 	}
 }
 
@@ -20,52 +19,53 @@ Object::~Object()
   glDeleteVertexArrays(1, &_VAO);
   glDeleteBuffers(1, &_VBO);
   glDeleteBuffers(1, &_EBO);
-	glDeleteTextures(1, &_BumpTextureID);
-	glDeleteTextures(1, &_DiffTextureID);
+	TextureCache::getInstance().release(_BumpTextureID);
+	TextureCache::getInstance().release(_DiffTextureID);
+	VirtualTextureSystem::getInstance().release(_virtualTextureID);
+	TransformStore::getInstance().release(_transformID);
 }
 
-void	checkMove(float& pos, float distance)
+void	checkMove(unsigned int transformID, TransformAxis axis, float distance)
 {
-	pos += distance;
+	TransformStore&	store = TransformStore::getInstance();
+	float						pos = store.position(transformID, axis) + distance;
+
 	if (pos > 4)
 		pos = 4;
 	else if (pos < -4)
 		pos = -4;
-}
-
-void	checkRotate(float& rot, float degree)
-{
-	rot += degree;
-	if (rot > 360)
-		rot = 0;
-	else if (rot < -360)
-		rot = 0;
+	// 끝에 닿아서 그대로면 store 가 dirty 로 표시하지 않습니다.
+	store.setPosition(transformID, axis, pos);
 }
 
 void	Object::move(MoveObject direction)
 {
+	TransformStore&	store = TransformStore::getInstance();
+
 	switch (direction)
 	{
 		case MOVE_RIGHT:
-			checkMove(_pos[0], 0.01f);
+			checkMove(_transformID, AXIS_X, 0.01f);
 			break;
 		case MOVE_LEFT:
-			checkMove(_pos[0], -0.01f);
+			checkMove(_transformID, AXIS_X, -0.01f);
 			break;
 		case MOVE_UP:
-			checkMove(_pos[1], 0.01f);
+			checkMove(_transformID, AXIS_Y, 0.01f);
 			break;
 		case MOVE_DOWN:
-			checkMove(_pos[1], -0.01f);
+			checkMove(_transformID, AXIS_Y, -0.01f);
 			break;
 		case MOVE_CLOSE:
-			checkMove(_pos[2], -0.05f);
+			checkMove(_transformID, AXIS_Z, -0.05f);
 			break;
 		case MOVE_FAR:
-			checkMove(_pos[2], 0.05f);
+			checkMove(_transformID, AXIS_Z, 0.05f);
 			break;
 		case MOVE_RESET:
-			_pos[0] = 0; _pos[1] = 0; _pos[2] = 0;
+			store.setPosition(_transformID, AXIS_X, 0);
+			store.setPosition(_transformID, AXIS_Y, 0);
+			store.setPosition(_transformID, AXIS_Z, 0);
 			break;
 		default:
 			break;
@@ -74,69 +74,116 @@ void	Object::move(MoveObject direction)
 
 void	Object::rotate(RotateObject	direction)
 {
+	TransformStore&	store = TransformStore::getInstance();
+
 	switch (direction)
 	{
+		// 한 번에 1 도씩, 예전 _rot 에 더하던 값과 같은 방향입니다.
 		case ROTATE_CLOCK_X:
-			checkRotate(_rot[0], 1.0f);
+			store.rotate(_transformID, AXIS_X, 1.0f);
 			break;
 		case ROTATE_ANTICLOCK_X:
-			checkRotate(_rot[0], -1.0f);
+			store.rotate(_transformID, AXIS_X, -1.0f);
 			break;
 		case ROTATE_CLOCK_Y:
-			checkRotate(_rot[1], -1.0f);
+			store.rotate(_transformID, AXIS_Y, -1.0f);
 			break;
 		case ROTATE_ANTICLOCK_Y:
-			checkRotate(_rot[1], 1.0f);
+			store.rotate(_transformID, AXIS_Y, 1.0f);
 			break;
 		case ROTATE_CLOCK_Z:
-			checkRotate(_rot[2], 1.0f);
+			store.rotate(_transformID, AXIS_Z, 1.0f);
 			break;
 		case ROTATE_ANTICLOCK_Z:
-			checkRotate(_rot[2], -1.0f);
+			store.rotate(_transformID, AXIS_Z, -1.0f);
 			break;
 		case ROTATE_RESET:
-			_rot[0] = 0; _rot[1] = 0; _rot[2] = 0;
+			store.resetRotation(_transformID);
 			break;
 		default:
 			break;
 	}
 }
 
-void Object::getModelMatrix(float* out) const 
+// TransformStore::update 가 바뀐 object 만 다시 구해 둔 행렬입니다.
+const Mat4&	Object::getModelMatrix() const
 {
-    float T[16], R[16], S[16], temp[16];
+	return TransformStore::getInstance().model(_transformID);
+}
+
+const Mat4&	Object::getMVPMatrix() const
+{
+	return TransformStore::getInstance().mvp(_transformID);
+}
 
-    makeTranslation(T, _pos[0], _pos[1], _pos[2]);
+const Mat4&	Object::getNormalMatrix() const
+{
+	return TransformStore::getInstance().normal(_transformID);
+}
 
-    makeScale(S, _scale[0], _scale[1], _scale[2]);
+// 화면 밖이면 uniform 도 올리지 않고 그리지도 않습니다.
+bool	Object::isVisible() const
+{
+	return TransformStore::getInstance().visible(_transformID);
+}
 
-    // R = Rz * Ry * Rx
-    makeRotation(R, _rot[0], _rot[1], _rot[2]);
+// object 공간 경계 (shiftToCentre 뒤)
+const Bounds&	Object::getBounds() const
+{
+	return _bounds;
+}
 
-    // RS = R * S
-    multiplyMatrix(temp, R, S);
+const std::vector<Vec4>&	Object::getOccluder() const
+{
+	return _occluder;
+}
 
-    // M = T * R * S
-    multiplyMatrix(out, T, temp);
+unsigned int	Object::getTransformID() const
+{
+	return _transformID;
 }
 
-void	Object::drawObject(unsigned int bumpSamplerLoc, unsigned int diffuseSamplerLoc) const
+// world 공간 광선 (origin + t * direction) 을 object 공간으로 옮겨 삼각형 BVH 에 묻습니다.
+// 모델 행렬이 affine 이라 t 는 두 공간에서 같으므로, 여러 object 의 distance 를 그대로 비교할 수 있습니다.
+bool	Object::intersectRay(const float* origin, const float* direction, float& distance) const
+{
+	Mat4	toLocal;
+	if (_triangles.empty() || !inverse(getModelMatrix(), toLocal))
+		return false;
+	Vec4	localOrigin = toLocal * Vec4(origin[0], origin[1], origin[2], 1.0f);
+	Vec4	localDirection = toLocal * Vec4(direction[0], direction[1], direction[2], 0.0f);
+	return _triangles.intersect(localOrigin.v, localDirection.v, distance);
+}
+
+// sampler uniform 은 main 에서 slot 번호로 한 번만 올립니다.
+void	Object::drawObject() const
+{
+	// atlas 를 공유하는 object 들은 이미 바인딩된 텍스처를 그대로 사용합니다.
+	TextureCache::getInstance().bind(TEXTURE_SLOT_BUMP, _BumpTextureID); // 유효한 텍스처 ID로 바인딩
+	TextureCache::getInstance().bind(TEXTURE_SLOT_DIFFUSE, _DiffTextureID);
+	TextureResidency::getInstance().touch(_BumpTextureID);
+	TextureResidency::getInstance().touch(_DiffTextureID);
+	drawGeometry();
+}
+
+// 텍스처 상태를 건드리지 않고 그립니다. (가상 텍스처 feedback pass)
+void	Object::drawGeometry() const
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, _BumpTextureID); // 유효한 텍스처 ID로 바인딩
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, _DiffTextureID);
-	glUniform1i(bumpSamplerLoc, 0);
-  glUniform1i(diffuseSamplerLoc, 1);
 	glBindVertexArray(_VAO);
 	glDrawElements(GL_TRIANGLES, _indices.size(), GL_UNSIGNED_INT, 0);
 }
 
+unsigned int	Object::getVirtualTexture() const
+{
+	return _virtualTextureID;
+}
+
 void Object::updateTextureBlendRatio()
 {
 	if (!_isTextureExist)
 		return ;
-	if (_TextureMode && _TextureRatio < 1.0f)
+	// 텍스처가 다 올라오기 전에는 placeholder 가 섞여 보이지 않게 기다립니다.
+	if (_TextureMode && _TextureRatio < 1.0f && isTextureResident())
 		_TextureRatio += 0.02f;
 	else if (!_TextureMode && _TextureRatio > 0.0f)
 		_TextureRatio -= 0.02f;
@@ -144,17 +191,66 @@ void Object::updateTextureBlendRatio()
 
 void	Object::setObject()
 {
+	_transformID = TransformStore::getInstance().create();
 	loadOBJ();
-	shiftToCentre();
+	_bounds = shiftToCentre(_vertices);
+	TransformStore::getInstance().setBounds(_transformID, _bounds);
 
 	std::vector<float>	vertexData;
+	buildVertexData(vertexData);
+	OcclusionBuffer::makeOccluder(_vertices, _faceData, _occluder);
+	_triangles.build(_vertices, _faceData);
+
+  glGenVertexArrays(1, &_VAO);
+  glGenBuffers(1, &_VBO);
+  glGenBuffers(1, &_EBO);
+
+	// bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
+	glBindVertexArray(_VAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, _VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indices.size() * sizeof(unsigned int), _indices.data(), GL_STATIC_DRAW);
+
+	//vertex attribute
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(3 * sizeof(float))); // 노멀
+	glEnableVertexAttribArray(1);
+
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(6 * sizeof(float))); // texture
+	glEnableVertexAttribArray(2);
+
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(8 * sizeof(float))); // tangent
+	glEnableVertexAttribArray(3);
+
+  // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
+  glBindBuffer(GL_ARRAY_BUFFER, 0); 
+
+  // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
+  // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
+  glBindVertexArray(0);
+}
+
+// 삼각형마다 (위치, 노멀, uv, tangent) 를 이어 붙입니다. uv 는 atlas 영역으로 옮겨서 넣습니다.
+void	Object::buildVertexData(std::vector<float>& vertexData)
+{
+	std::vector<float>	tangent;
 	unsigned int				idx = 0;
 	int									vertSize = _vertices.size();
 	int									normSize = _normals.size();
 	int									textSize = _textures.size();
 
+	_indices.clear();
+
 	for (std::vector<FaceData>::const_iterator it = _faceData.begin(); it != _faceData.end(); ++it)
 	{
+		// 삼각형마다 tangent 를 한 번 구해서 세 꼭짓점이 같이 씁니다.
+		if (idx % 3 == 0)
+			tangent = findTangent(&*it);
 		_indices.push_back(idx++);
 
 		// vertex coordinate
@@ -177,48 +273,21 @@ void	Object::setObject()
 		else
 			throw std::runtime_error("ERROR::SETTER::OBJ::DATA_ERROR\nnoraml index is out of data.");
 
-		// texture coordinate
+		// texture coordinate (atlas 영역으로 변환)
 		if (it->texture > -1 && it->texture * 2 + 1 < textSize)
 		{
-			vertexData.push_back(_textures[it->texture * 2 + 0]);
-			vertexData.push_back(_textures[it->texture * 2 + 1]);
+			vertexData.push_back(_textures[it->texture * 2 + 0] * _uvScale[0] + _uvOffset[0]);
+			vertexData.push_back(_textures[it->texture * 2 + 1] * _uvScale[1] + _uvOffset[1]);
 		}
 		else
 		{
-			vertexData.push_back(0);
-			vertexData.push_back(0);
+			vertexData.push_back(_uvOffset[0]);
+			vertexData.push_back(_uvOffset[1]);
 		}
-	}
-
-  glGenVertexArrays(1, &_VAO);
-  glGenBuffers(1, &_VBO);
-  glGenBuffers(1, &_EBO);
-
-	// bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-	glBindVertexArray(_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indices.size() * sizeof(unsigned int), _indices.data(), GL_STATIC_DRAW);
-
-	//vertex attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); // 노멀
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float))); // texture
-	glEnableVertexAttribArray(2);
-
-  // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
-  glBindBuffer(GL_ARRAY_BUFFER, 0); 
 
-  // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-  // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
-  glBindVertexArray(0);
+		// tangent (xyz) + bitangent 방향 (w)
+		vertexData.insert(vertexData.end(), tangent.begin(), tangent.end());
+	}
 }
 
 void Object::loadOBJ()
@@ -232,179 +301,22 @@ void Object::loadOBJ()
   if (!file.is_open())
 		throw std::runtime_error("ERROR::LOADER::OBJ::PATH_ERROR\nfailed to open OBJ file.");
 
-  std::vector<float>		temp_vertices;
-	std::vector<float>		temp_normals;
-	std::vector<float>		temp_textures;
-  std::vector<FaceData>	temp_faceData;
-	char									vt_flag = 0, vn_flag = 0, mtl_flag = 0;
-
-  std::string line;
-  while (std::getline(file, line)) 
-  {
-    std::istringstream iss(line);
-
-  	std::string prefix;
-  	iss >> prefix;
-		char	rest;
-
-    if (prefix == "v") 
-    {
-      float x, y, z;
-      if (!(iss >> x >> y >> z) || iss >> rest)
-				throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nvertex data is in wrong format.");
-      temp_vertices.push_back(x);
-      temp_vertices.push_back(y);
-      temp_vertices.push_back(z);
-    }
-		else if (prefix == "vn")
-		{
-			float x, y, z;
-      if (!(iss >> x >> y >> z) || iss >> rest)
-				throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal data is in wrong format.");
-      temp_normals.push_back(x);
-      temp_normals.push_back(y);
-      temp_normals.push_back(z);
-		}
-		else if (prefix == "vt")
-		{
-			float x, y, z;
-      if (!(iss >> x >> y >> z) || iss >> rest)
-				throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\ntexture data is in wrong format.");
-      temp_textures.push_back(x);
-      temp_textures.push_back(y);
-		}
-		else if (prefix == "mtllib")
-		{
-			std::string	path;
-			iss >> path;
-			loadMTL(path);
-			mtl_flag = 1;
-		}
-    else if (prefix == "f") 
-    {
-      std::vector<FaceData> face_indices;
-      int					vIdx, vtIdx, vnIdx;
-			std::string	face;
-			char				delim;
-
-      // f 다음에 나오는 모든 정점 인덱스 읽기
-      while (std::getline(iss, face, ' '))
-			{
-				if (face.empty()) continue;
-
-				vIdx = 0; vtIdx = 0; vnIdx = 0;
-				std::stringstream	faceStream(face);
-
-				if (faceStream >> vIdx) 
-				{
-					if (faceStream >> delim) 
-					{
-						if (faceStream.peek() == '/') 
-						{
-							faceStream.get(); // skip second '/'
-							if (vt_flag == 1)
-								throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\ntexture indeces are missing.");
-							else
-								vt_flag = 2;
-							if (!(faceStream >> vnIdx)) 
-							{
-								if (vn_flag == 1)
-									throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal indeces are missing.");
-								else
-									vn_flag = 2;
-								vnIdx = 0;
-							}
-							else if (vn_flag == 2)
-									throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal indeces are missing.");
-							else
-								vn_flag = 1;
-						} 
-						else 
-						{
-							if (!(faceStream >> vtIdx)) 
-							{
-								if (vt_flag == 1)
-								throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\ntexture indeces are missing.");
-								else
-									vt_flag = 2;
-								vtIdx = 0;
-							}
-							else if (vt_flag == 2)
-								throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\ntexture indeces are missing.");
-							else
-								vt_flag = 1;
-							if (faceStream >> delim && !(faceStream >> vnIdx)) 
-							{
-								if (vn_flag == 1)
-									throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal indeces are missing.");
-								else
-									vn_flag = 2;
-								vnIdx = 0;
-							}
-							else if (vn_flag == 2)
-									throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nnormal indeces are missing.");
-							else
-								vn_flag = 1;
-						}
-					}
-					face_indices.push_back({vIdx - 1, vtIdx - 1, vnIdx - 1});
-				}
-				else
-					throw std::runtime_error("ERROR::LOADER::OBJ::FORMAT_ERROR\nvertex indeces are missing.");
-			}
-
-     	// 팬 트라이앵글 방식으로 삼각형 분할
-     	for (size_t i = 1; i + 1 < face_indices.size(); ++i) 
-     	{
-     	  temp_faceData.push_back(face_indices[0]);
-     	  temp_faceData.push_back(face_indices[i]);
-     	  temp_faceData.push_back(face_indices[i + 1]);
-     	}
-    }
-  }
-
-	if (!vn_flag || !temp_normals.size())
+	ObjData			data;
+	std::string	line, mtlFile;
+	while (std::getline(file, line))
 	{
-		temp_normals.clear();
-		int	normalIndex = 0;
-		for (size_t i = 0; i + 2 < temp_faceData.size(); i += 3)
-		{
-			float	A[3] = {
-				temp_vertices[temp_faceData[i].vertex * 3 + 0],
-				temp_vertices[temp_faceData[i].vertex * 3 + 1],
-				temp_vertices[temp_faceData[i].vertex * 3 + 2]
-			};
-			float	B[3] = {
-				temp_vertices[temp_faceData[i + 1].vertex * 3 + 0],
-				temp_vertices[temp_faceData[i + 1].vertex * 3 + 1],
-				temp_vertices[temp_faceData[i + 1].vertex * 3 + 2]
-			};
-			float	C[3] = {
-				temp_vertices[temp_faceData[i + 2].vertex * 3 + 0],
-				temp_vertices[temp_faceData[i + 2].vertex * 3 + 1],
-				temp_vertices[temp_faceData[i + 2].vertex * 3 + 2]
-			};
-			std::vector<float>	normal = findNormal(A, B, C);
-			temp_normals.insert(temp_normals.end(), normal.begin(), normal.end());
-			temp_faceData[i].normal = normalIndex;
-			temp_faceData[i + 1].normal = normalIndex;
-			temp_faceData[i + 2].normal = normalIndex;
-			++normalIndex;
-		}
+		if (parseObjLine(line, data, mtlFile))
+			loadMTL(mtlFile);
 	}
+	generateFaceNormals(data);
 
-  _vertices = temp_vertices;
-	_normals  = temp_normals;
-	_textures = temp_textures;
-  _faceData = temp_faceData;
-
-	if (!mtl_flag)
-	{
-		_BumpTextureID = generateDummyTexture(0);
-		_DiffTextureID = generateDummyTexture(1);
-	}
+	_vertices.swap(data.vertices);
+	_normals.swap(data.normals);
+	_textures.swap(data.textures);
+	_faceData.swap(data.faceData);
 
 	checkFileData();
+	setTextures();
 }
 
 void	Object::loadMTL(std::string fileName)
@@ -418,9 +330,8 @@ void	Object::loadMTL(std::string fileName)
   if (!MtlFile.is_open()) 
 		throw std::runtime_error("ERROR::LOADER::MTL::PATH_ERROR\nfailed to open MTL file.");
 
-	bool	bump = false, diffuse = false;
-
   std::string line;
+  bool        hasDiffuseMap = false;
   while (std::getline(MtlFile, line)) 
   {
     std::istringstream iss(line);
@@ -428,119 +339,122 @@ void	Object::loadMTL(std::string fileName)
     std::string prefix;
     iss >> prefix;
 
-    if (prefix == "bump") 
+    // 옵션 (-bm 1.0 등) 이 붙을 수 있으므로 파일 이름은 마지막 토큰을 사용합니다.
+    std::string	fileName, token;
+    while (iss >> token)
+      fileName = token;
+
+    if (prefix == "bump" || prefix == "map_bump") 
     {
-			std::string	bumpFile;
-			iss >> bumpFile;
-			_BumpTextureID = setTextureData(base_dir, bumpFile, 0);
-			bump = true;
+			checkTextureFile(fileName);
+			_bumpFile = base_dir + fileName;
     }
 		else if (prefix == "map_Kd")
 		{
-			std::string diffFile;
-			iss >> diffFile;
-			_DiffTextureID = setTextureData(base_dir, diffFile, 1);
-			diffuse = true;
+			checkTextureFile(fileName);
+			_diffFile = base_dir + fileName;
+			hasDiffuseMap = true;
+		}
+		else if (prefix == "map_Ka" && !hasDiffuseMap)
+		{
+			// map_Kd 가 없을 때만 ambient map 을 diffuse 로 사용합니다.
+			checkTextureFile(fileName);
+			_diffFile = base_dir + fileName;
 		}
 	}
-	if (!bump)
-		_BumpTextureID = generateDummyTexture(0);
-	if (!diffuse)
-		_DiffTextureID = generateDummyTexture(1);
 }
 
-unsigned int	Object::setTextureData(std::string& base_dir, std::string fileName, unsigned int slot)
+void	Object::checkTextureFile(const std::string& fileName) const
 {
   std::string::size_type	extention = fileName.find_last_of(".");
-	if (extention == std::string::npos || fileName.substr(extention + 1) != "bmp")
+	if (extention == std::string::npos)
 		throw std::runtime_error("ERROR::LOADER::BMP::WRONG_EXTENSION\ninvalid file extension.");
+	std::string	ext = fileName.substr(extention + 1);
+	if (ext != "bmp" && ext != "jpg" && ext != "jpeg")
+		throw std::runtime_error("ERROR::LOADER::BMP::WRONG_EXTENSION\ninvalid file extension.");
+}
 
-	std::ifstream BmpFile(base_dir + fileName);
-  if (!BmpFile.is_open()) 
-		throw std::runtime_error("ERROR::LOADER::BMP::FILE_OPEN_FAIL\nfailed to open file.");
-
-	unsigned char	header[54];
-	unsigned int dataPos;     // Position in the file where the actual data begins
-	unsigned int width, height;
-	unsigned int imageSize;   // = width*height*3
-
-			
-	BmpFile.read(reinterpret_cast<char*>(header), 54);
-	if (header[0]!='B' || header[1]!='M')
-		throw std::runtime_error("ERROR::LOADER::BMP::WRONG_FORMAT\nwrong bmp file header format.");
-	// 바이트 배열에서 int 변수를 읽습니다. 
-	dataPos    = *(int*)&(header[0x0A]);
-	imageSize  = *(int*)&(header[0x22]);
-	width      = *(int*)&(header[0x12]);
-	height     = *(int*)&(header[0x16]);
-
-	// 몇몇 BMP 파일들은 포맷이 잘못되었습니다. 정보가 누락됬는지 확인해봅니다. 
-	// Some BMP files are misformatted, guess missing information
-	if (imageSize == 0)    imageSize = width*height * 3; // 3 : one byte for each Red, Green and Blue component
-	if (dataPos == 0)      dataPos = 54; // The BMP header is done that way
-
-	std::vector<unsigned char>	temp_Texture(imageSize);
-	BmpFile.seekg(dataPos);
-	if (!BmpFile.read(reinterpret_cast<char*>(temp_Texture.data()), imageSize))
-		throw std::runtime_error("ERROR::LOADER::BMP::WRONG_FORMAT\nimage data not found.");
-
-	// OpenGL Texture를 생성합니다.
-	unsigned int	textureID;
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glGenTextures(1, &textureID);
-
-	// 새 텍스처에 "Bind" 합니다 : 이제 모든 텍스처 함수들은 이 텍스처를 수정합니다. 
-	// "Bind" the newly created texture : all future texture functions will modify this texture
-	glBindTexture(GL_TEXTURE_2D, textureID);
-
-	// OpenGL에게 이미지를 넘겨줍니다. 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, temp_Texture.data());
+// 텍스처는 처음 텍스처 모드로 바꿀 때 (또는 prefetchTextures) 디코딩합니다. 그 전까지는 dummy 텍스처로 그립니다.
+// 텍스처가 없는 object 는 디코딩할 것이 없으므로 바로 단색 (1x1 dummy) 텍스처를 씁니다.
+void	Object::setTextures()
+{
+	_isTextureExist = !_bumpFile.empty() || !_diffFile.empty();
+	if (!_isTextureExist)
+	{
+		loadTextures();
+		return ;
+	}
+	_BumpTextureID = generateDummyTexture(TEXTURE_SLOT_BUMP);
+	_DiffTextureID = generateDummyTexture(TEXTURE_SLOT_DIFFUSE);
+}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+void	Object::prefetchTextures()
+{
+	if (!_isTextureLoaded)
+		loadTextures();
+}
 
-	_isTextureExist = true;
+// dummy 텍스처는 새 텍스처를 받은 뒤에 놓습니다. (같은 dummy 를 다시 만들지 않도록)
+void	Object::loadTextures()
+{
+	unsigned int	dummyBump = _BumpTextureID, dummyDiff = _DiffTextureID;
 
-	return textureID;
+	_isTextureLoaded = true;
+	acquireTextures();
+	TextureCache::getInstance().release(dummyBump);
+	TextureCache::getInstance().release(dummyDiff);
 }
 
-void	Object::shiftToCentre()
+// 작은 텍스처는 atlas 에 넣고 uv 를 atlas 영역으로 옮깁니다.
+// uv 가 [0, 1] 을 벗어나는 (반복되는) 텍스처는 atlas 에 넣을 수 없으므로 따로 로드합니다.
+void	Object::acquireTextures()
 {
-	// 모든 정점의 최소 / 최대 좌표 계산
-	// -------------------------
-	float	FLT_MAX = std::numeric_limits<float>::max();
-	float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
-	float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+	bool	uvInRange = true;
+	for (size_t i = 0; i < _textures.size(); i++)
+	{
+		if (_textures[i] < 0.0f || _textures[i] > 1.0f)
+			uvInRange = false;
+	}
 
-	for (size_t i = 0; i < _vertices.size(); i += 3) 
+	// VRAM 에 다 올릴 수 없는 diffuse 는 가상 텍스처로 page 단위로 올립니다.
+	unsigned int	width = 0, height = 0;
+	if (!_diffFile.empty() && TextureCache::readImageSize(_diffFile, width, height)
+		&& std::max(width, height) > VirtualTextureSystem::MIN_VIRTUAL_SIZE)
 	{
-			float x = _vertices[i];
-			float y = _vertices[i + 1];
-			float z = _vertices[i + 2];
-
-			if (x < minX) minX = x;
-			if (y < minY) minY = y;
-			if (z < minZ) minZ = z;
-			if (x > maxX) maxX = x;
-			if (y > maxY) maxY = y;
-			if (z > maxZ) maxZ = z;
+		_virtualTextureID = VirtualTextureSystem::getInstance().acquire(_diffFile);
+		_BumpTextureID = _bumpFile.empty() ? generateDummyTexture(TEXTURE_SLOT_BUMP) : setTextureData(_bumpFile, TEXTURE_SLOT_BUMP);
+		_DiffTextureID = generateDummyTexture(TEXTURE_SLOT_DIFFUSE);
+		return ;
 	}
-	// 중심점(center) 계산
-	// ----------------
-	float centerX = (minX + maxX) / 2.0f;
-	float centerY = (minY + maxY) / 2.0f;
-	float centerZ = (minZ + maxZ) / 2.0f;
-	float	maxLength = (maxX - minX) > (maxY - minY) ? (maxX - minX) : (maxY - minY);
-	maxLength = ((maxZ - minZ) > maxLength ? (maxZ - minZ) : maxLength);
-
-	// 모든 정점을 중심 기준으로 이동
-	// ----------------------
-	for (size_t i = 0; i < _vertices.size(); i += 3) 
+
+	AtlasRegion	region;
+	if ((uvInRange || !_isTextureExist) && TextureAtlas::getInstance().insert(_bumpFile, _diffFile, region))
 	{
-    _vertices[i] 		 = (_vertices[i]     - centerX) / maxLength;  // x
-    _vertices[i + 1] = (_vertices[i + 1] - centerY) / maxLength;  // y
-    _vertices[i + 2] = (_vertices[i + 2] - centerZ) / maxLength;  // z
+		_BumpTextureID = region.bumpTextureID;
+		_DiffTextureID = region.diffTextureID;
+		for (int i = 0; i < 2; i++)
+		{
+			_uvOffset[i] = region.uvOffset[i];
+			_uvScale[i] = region.uvScale[i];
+		}
+		// 이미 만든 vertex buffer 의 uv 를 atlas 영역으로 다시 씁니다.
+		if (_VBO)
+		{
+			std::vector<float>	vertexData;
+			buildVertexData(vertexData);
+			glBindBuffer(GL_ARRAY_BUFFER, _VBO);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, vertexData.size() * sizeof(float), vertexData.data());
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		return ;
 	}
+	_BumpTextureID = _bumpFile.empty() ? generateDummyTexture(TEXTURE_SLOT_BUMP) : setTextureData(_bumpFile, TEXTURE_SLOT_BUMP);
+	_DiffTextureID = _diffFile.empty() ? generateDummyTexture(TEXTURE_SLOT_DIFFUSE) : setTextureData(_diffFile, TEXTURE_SLOT_DIFFUSE);
+}
+
+unsigned int	Object::setTextureData(const std::string& path, unsigned int slot)
+{
+	return TextureCache::getInstance().acquire(path, slot);
 }
 
 void	Object::checkFileData() const
@@ -569,40 +483,76 @@ float	Object::getTextureRatio() const
 
 void	Object::toggleTexureMode()
 {
-	if (_isTextureExist)
-		_TextureMode = !_TextureMode;
+	if (!_isTextureExist)
+		return ;
+	_TextureMode = !_TextureMode;
+	if (_TextureMode && !_isTextureLoaded)
+		loadTextures();
 }
 
-std::vector<float>	Object::findNormal(const float *A, const float *B, const float *C) const
+bool	Object::isTextureResident() const
 {
-	float	firstVector[3] = {
-		B[0] - A[0],
-		B[1] - A[1],
-		B[2] - A[2]
-	};
-	float	secondVector[3] = {
-		C[0] - A[0],
-		C[1] - A[1],
-		C[2] - A[2]
-	};
-	std::vector<float>	normal = {
-		firstVector[1] * secondVector[2] - firstVector[2] * secondVector[1],
-		firstVector[2] * secondVector[0] - firstVector[0] * secondVector[2],
-		firstVector[0] * secondVector[1] - firstVector[1] * secondVector[0]
-	};
-	return normal;
+	if (!_isTextureLoaded)
+		return false;
+	if (_virtualTextureID && !VirtualTextureSystem::getInstance().isReady(_virtualTextureID))
+		return false;
+	return !TextureStreamer::getInstance().isStreaming(_BumpTextureID)
+		&& !TextureStreamer::getInstance().isStreaming(_DiffTextureID);
 }
 
-unsigned int	Object::generateDummyTexture(unsigned int slot) const
+// uv 의 u 방향 (tangent) 을 구합니다. w 는 bitangent 가 (normal x tangent) 와 같은 방향이면 1, 아니면 -1.
+// uv 가 없거나 겹친 삼각형은 면에 평행한 아무 방향이나 씁니다. (bump map 이 평평하게 보입니다)
+std::vector<float>	Object::findTangent(const FaceData* face) const
 {
-	unsigned int	dummyTextureID;
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glGenTextures(1, &dummyTextureID);
-	glBindTexture(GL_TEXTURE_2D, dummyTextureID);
-	unsigned char grayPixel[] = {178, 178, 178, 255};
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grayPixel);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	const float*	P[3];
+	for (int i = 0; i < 3; i++)
+		P[i] = &_vertices[face[i].vertex * 3];
+	float	edge1[3] = {P[1][0] - P[0][0], P[1][1] - P[0][1], P[1][2] - P[0][2]};
+	float	edge2[3] = {P[2][0] - P[0][0], P[2][1] - P[0][1], P[2][2] - P[0][2]};
+	std::vector<float>	normal = findNormal(P[0], P[1], P[2]);
+
+	int	textSize = _textures.size();
+	if (face[0].texture > -1 && face[1].texture > -1 && face[2].texture > -1
+		&& face[0].texture * 2 + 1 < textSize && face[1].texture * 2 + 1 < textSize && face[2].texture * 2 + 1 < textSize)
+	{
+		const float*	uv0 = &_textures[face[0].texture * 2];
+		const float*	uv1 = &_textures[face[1].texture * 2];
+		const float*	uv2 = &_textures[face[2].texture * 2];
+		float	du1 = uv1[0] - uv0[0], dv1 = uv1[1] - uv0[1];
+		float	du2 = uv2[0] - uv0[0], dv2 = uv2[1] - uv0[1];
+		float	det = du1 * dv2 - du2 * dv1;
+		if (std::fabs(det) > 1e-12f)
+		{
+			float	r = 1.0f / det;
+			float	T[3], B[3];
+			for (int i = 0; i < 3; i++)
+			{
+				T[i] = (edge1[i] * dv2 - edge2[i] * dv1) * r;
+				B[i] = (edge2[i] * du1 - edge1[i] * du2) * r;
+			}
+			float	cross[3] = {
+				normal[1] * T[2] - normal[2] * T[1],
+				normal[2] * T[0] - normal[0] * T[2],
+				normal[0] * T[1] - normal[1] * T[0]
+			};
+			float	handedness = cross[0] * B[0] + cross[1] * B[1] + cross[2] * B[2] < 0.0f ? -1.0f : 1.0f;
+			return std::vector<float>({T[0], T[1], T[2], handedness});
+		}
+	}
+
+	// 노멀과 가장 덜 평행한 축을 면 위로 투영합니다.
+	float	axis[3] = {1.0f, 0.0f, 0.0f};
+	if (std::fabs(normal[0]) > std::fabs(normal[1]) && std::fabs(normal[0]) > std::fabs(normal[2]))
+	{
+		axis[0] = 0.0f;
+		axis[1] = 1.0f;
+	}
+	float	lengthSq = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+	float	d = lengthSq > 0.0f ? (axis[0] * normal[0] + axis[1] * normal[1]) / lengthSq : 0.0f;
+	return std::vector<float>({axis[0] - d * normal[0], axis[1] - d * normal[1], -d * normal[2], 1.0f});
+}
 
-	return dummyTextureID;
+unsigned int	Object::generateDummyTexture(unsigned int slot) const
+{
+	return TextureCache::getInstance().acquireDummy(slot);
 }
@@ -18,6 +18,15 @@
 
 
 # include "utils.hpp"
+# include "TextureCache.hpp"
+# include "TextureAtlas.hpp"
+# include "TextureResidency.hpp"
+# include "VirtualTexture.hpp"
+# include "TextureStreamer.hpp"
+# include "TransformStore.hpp"
+# include "MeshData.hpp"
+# include "OcclusionBuffer.hpp"
+# include "TriangleBVH.hpp"
 
 enum	MoveObject {
 	MOVE_RIGHT,
@@ -39,32 +48,38 @@ enum	RotateObject {
 	ROTATE_RESET
 };
 
-struct	FaceData {
-	int	vertex;
-	int	texture;
-	int	normal;
-};
-
 class Object
 {
 	private:
 		std::string								_path;
+		std::string								_bumpFile, _diffFile;
 		std::vector<float>				_vertices;
 		std::vector<float>				_textures;
 		std::vector<float>				_normals;
 		std::vector<FaceData>			_faceData;
 		std::vector<unsigned int> _indices;
+		std::vector<Vec4>					_occluder;					// occlusion buffer 에 그릴 큰 삼각형들
+		Bounds										_bounds;
+		TriangleBVH								_triangles;					// 마우스 선택용 삼각형 BVH (object 공간)
 		unsigned int							_VBO, _VAO, _EBO, _DiffTextureID, _BumpTextureID;
-		float											_pos[3], _rot[3], _scale[3], _TextureRatio;
-		bool											_TextureMode, _isTextureExist;
+		unsigned int							_virtualTextureID;	// 0 이면 diffuse 가 가상 텍스처가 아님
+		unsigned int							_transformID;				// TransformStore 의 위치 / 회전 / 크기
+		float											_TextureRatio;
+		float											_uvOffset[2], _uvScale[2];
+		bool											_TextureMode, _isTextureExist, _isTextureLoaded;
 
 		void								loadOBJ();
 		void								loadMTL(std::string path);
 		void								checkFileData() const;
-		void								shiftToCentre();
-		unsigned int				setTextureData(std::string& base_dir, std::string fileName, unsigned int slot);
+		void								checkTextureFile(const std::string& fileName) const;
+		void								setTextures();
+		void								loadTextures();
+		void								acquireTextures();
+		bool								isTextureResident() const;
+		void								buildVertexData(std::vector<float>& vertexData);
+		unsigned int				setTextureData(const std::string& path, unsigned int slot);
 		unsigned int				generateDummyTexture(unsigned int slot) const;
-		std::vector<float>	findNormal(const float *A, const float *B, const float *C) const;
+		std::vector<float>	findTangent(const FaceData* face) const;
 
 	public:
 		Object(const char* path);
@@ -72,10 +87,20 @@ class Object
 		void	setObject();
 		void	move(MoveObject direction);
 		void	rotate(RotateObject direction);
-		void	getModelMatrix(float* out) const;
+		const Mat4&	getModelMatrix() const;
+		const Mat4&	getMVPMatrix() const;
+		const Mat4&	getNormalMatrix() const;
+		bool				isVisible() const;
+		const Bounds&	getBounds() const;
+		const std::vector<Vec4>&	getOccluder() const;
+		unsigned int	getTransformID() const;
+		bool	intersectRay(const float* origin, const float* direction, float& distance) const;
 		void	updateTextureBlendRatio();
-		void	drawObject(unsigned int bumpSamplerLoc, unsigned int diffuseSamplerLoc) const;
+		void	drawObject() const;
+		void	drawGeometry() const;
+		unsigned int	getVirtualTexture() const;
 		void	toggleTexureMode();
+		void	prefetchTextures();
 		float	getTextureRatio() const;
 };
 
@@ -0,0 +1,315 @@
+#include "OcclusionBuffer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+const float	OcclusionBuffer::OCCLUDER_MIN_COVERAGE = 1.0f / 64.0f;
+
+OcclusionBuffer::OcclusionBuffer() : _generation(0), _nextBand(0), _bandsLeft(0), _stop(false)
+{
+	for (int level = 0; level < LEVELS; level++)
+		_levels[level].assign((WIDTH >> level) * (HEIGHT >> level), std::numeric_limits<float>::max());
+}
+
+OcclusionBuffer::~OcclusionBuffer()
+{
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_stop = true;
+	}
+	_start.notify_all();
+	for (size_t i = 0; i < _workers.size(); i++)
+		_workers[i].join();
+}
+
+OcclusionBuffer&	OcclusionBuffer::getInstance()
+{
+	static OcclusionBuffer	instance;
+	return instance;
+}
+
+void	OcclusionBuffer::makeOccluder(const std::vector<float>& vertices, const std::vector<FaceData>& faces, std::vector<Vec4>& occluder)
+{
+	std::vector<std::pair<float, size_t> >	areas;
+	for (size_t i = 0; i + 2 < faces.size(); i += 3)
+	{
+		const float*	p[3];
+		bool					valid = true;
+		for (int k = 0; k < 3; k++)
+		{
+			int	index = faces[i + k].vertex;
+			valid = valid && index >= 0 && static_cast<size_t>(index) * 3 + 2 < vertices.size();
+			p[k] = valid ? &vertices[index * 3] : NULL;
+		}
+		if (!valid)
+			continue ;
+		std::vector<float>	normal = findNormal(p[0], p[1], p[2]);
+		areas.push_back(std::make_pair(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2], i));
+	}
+	if (areas.size() > OCCLUDER_TRIANGLES)
+	{
+		std::nth_element(areas.begin(), areas.begin() + OCCLUDER_TRIANGLES, areas.end(),
+			std::greater<std::pair<float, size_t> >());
+		areas.resize(OCCLUDER_TRIANGLES);
+	}
+
+	occluder.clear();
+	occluder.reserve(areas.size() * 3);
+	for (size_t i = 0; i < areas.size(); i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			const float*	p = &vertices[faces[areas[i].second + k].vertex * 3];
+			occluder.push_back(Vec4(p[0], p[1], p[2], 1.0f));
+		}
+	}
+}
+
+void	OcclusionBuffer::begin()
+{
+	_triangles.clear();
+}
+
+// 8 꼭짓점을 화면으로 옮겨서 덮는 pixel 범위 (rect : minX, maxX, minY, maxY) 와 가장 가까운 깊이를 구합니다.
+bool	OcclusionBuffer::projectBounds(const Mat4& mvp, const Bounds& bounds, int* rect, float& nearest) const
+{
+	Vec4	corners[8], clip[8];
+	for (int i = 0; i < 8; i++)
+		corners[i] = Vec4(i & 1 ? bounds.max[0] : bounds.min[0], i & 2 ? bounds.max[1] : bounds.min[1],
+			i & 4 ? bounds.max[2] : bounds.min[2], 1.0f);
+	transformVec4Array(mvp.m, corners, clip, 8);
+
+	float	minX = std::numeric_limits<float>::max(), maxX = -minX, minY = minX, maxY = -minX;
+	nearest = std::numeric_limits<float>::max();
+	for (int i = 0; i < 8; i++)
+	{
+		const float*	v = clip[i].v;
+		if (v[3] <= 0.0f || v[2] < -v[3])
+			return false;
+		float	x = (v[0] / v[3] * 0.5f + 0.5f) * WIDTH;
+		float	y = (v[1] / v[3] * 0.5f + 0.5f) * HEIGHT;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, v[2] / v[3]);
+	}
+	rect[0] = static_cast<int>(std::floor(std::max(minX, 0.0f)));
+	rect[1] = static_cast<int>(std::floor(std::min(maxX, WIDTH - 1.0f)));
+	rect[2] = static_cast<int>(std::floor(std::max(minY, 0.0f)));
+	rect[3] = static_cast<int>(std::floor(std::min(maxY, HEIGHT - 1.0f)));
+	return rect[0] <= rect[1] && rect[2] <= rect[3];
+}
+
+// 화면을 덮는 정도로 occluder 를 고르고, 삼각형마다 edge function 과 depth 평면을 준비합니다.
+bool	OcclusionBuffer::addOccluder(const Mat4& mvp, const Bounds& bounds, const std::vector<Vec4>& occluder)
+{
+	int		rect[4];
+	float	nearest;
+	if (occluder.empty() || !projectBounds(mvp, bounds, rect, nearest)
+		|| (rect[1] - rect[0] + 1) * (rect[3] - rect[2] + 1) < OCCLUDER_MIN_COVERAGE * WIDTH * HEIGHT)
+		return false;
+
+	_clip.resize(occluder.size());
+	transformVec4Array(mvp.m, occluder.data(), _clip.data(), occluder.size());
+	for (size_t i = 0; i + 2 < _clip.size(); i += 3)
+	{
+		float	x[3], y[3], z[3];
+		bool	valid = true;
+		for (int k = 0; k < 3 && valid; k++)
+		{
+			const float*	v = _clip[i + k].v;
+			valid = v[3] > 0.0f && v[2] >= -v[3];
+			x[k] = (v[0] / v[3] * 0.5f + 0.5f) * WIDTH;
+			y[k] = (v[1] / v[3] * 0.5f + 0.5f) * HEIGHT;
+			z[k] = v[2] / v[3];
+		}
+		float	area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		if (!valid || !(area != 0.0f))
+			continue ;
+		// 반시계 방향으로 맞추면 세 edge function 이 모두 0 이상인 곳이 안쪽입니다.
+		if (area < 0.0f)
+		{
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(z[1], z[2]);
+			area = -area;
+		}
+
+		ScreenTriangle	triangle;
+		for (int k = 0; k < 3; k++)
+		{
+			int	next = (k + 1) % 3;
+			triangle.edge[k][0] = y[k] - y[next];
+			triangle.edge[k][1] = x[next] - x[k];
+			triangle.edge[k][2] = -(triangle.edge[k][0] * x[k] + triangle.edge[k][1] * y[k]);
+		}
+		triangle.depth[1] = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+		triangle.depth[2] = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+		triangle.depth[0] = z[0] - triangle.depth[1] * x[0] - triangle.depth[2] * y[0];
+
+		float	minX = std::max(std::min(x[0], std::min(x[1], x[2])), 0.0f);
+		float	maxX = std::min(std::max(x[0], std::max(x[1], x[2])), WIDTH - 1.0f);
+		float	minY = std::max(std::min(y[0], std::min(y[1], y[2])), 0.0f);
+		float	maxY = std::min(std::max(y[0], std::max(y[1], y[2])), HEIGHT - 1.0f);
+		if (minX > maxX || minY > maxY)
+			continue ;
+		triangle.minX = static_cast<int>(minX) & ~3;
+		triangle.maxX = static_cast<int>(maxX);
+		triangle.minY = static_cast<int>(minY);
+		triangle.maxY = static_cast<int>(maxY);
+		_triangles.push_back(triangle);
+	}
+	return true;
+}
+
+bool	OcclusionBuffer::takeBand(size_t& band)
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+	if (_nextBand >= BANDS)
+		return false;
+	band = _nextBand++;
+	return true;
+}
+
+void	OcclusionBuffer::finishBand()
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
+	if (--_bandsLeft == 0)
+		_done.notify_all();
+}
+
+void	OcclusionBuffer::workerLoop()
+{
+	unsigned int	seen;
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		seen = _generation;
+	}
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex>	lock(_mutex);
+			_start.wait(lock, [&] { return _stop || _generation != seen; });
+			if (_stop)
+				return ;
+			seen = _generation;
+		}
+		size_t	band;
+		while (takeBand(band))
+		{
+			renderBand(band);
+			finishBand();
+		}
+	}
+}
+
+// band 를 지우고, 걸치는 삼각형을 pixel 중심에서 검사해서 더 가까운 깊이를 쓰고, pyramid 의 그 band 부분을 만듭니다.
+void	OcclusionBuffer::renderBand(size_t band)
+{
+	int		y0 = static_cast<int>(band * HEIGHT / BANDS), y1 = static_cast<int>((band + 1) * HEIGHT / BANDS);
+	float*	buffer = _levels[0].data();
+	std::fill(buffer + y0 * WIDTH, buffer + y1 * WIDTH, std::numeric_limits<float>::max());
+
+	for (size_t i = 0; i < _triangles.size(); i++)
+	{
+		const ScreenTriangle&	t = _triangles[i];
+		int	rowBegin = std::max(t.minY, y0), rowEnd = std::min(t.maxY + 1, y1);
+		for (int y = rowBegin; y < rowEnd; y++)
+		{
+			float		py = y + 0.5f;
+			float		row0 = t.edge[0][1] * py + t.edge[0][2];
+			float		row1 = t.edge[1][1] * py + t.edge[1][2];
+			float		row2 = t.edge[2][1] * py + t.edge[2][2];
+			float		rowZ = t.depth[2] * py + t.depth[0];
+			float*	line = buffer + y * WIDTH;
+#if defined(__SSE2__)
+			__m128	a0 = _mm_set1_ps(t.edge[0][0]), a1 = _mm_set1_ps(t.edge[1][0]), a2 = _mm_set1_ps(t.edge[2][0]);
+			__m128	r0 = _mm_set1_ps(row0), r1 = _mm_set1_ps(row1), r2 = _mm_set1_ps(row2);
+			__m128	dz = _mm_set1_ps(t.depth[1]), rz = _mm_set1_ps(rowZ), zero = _mm_setzero_ps();
+			for (int x = t.minX; x <= t.maxX; x += 4)
+			{
+				__m128	px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+				__m128	inside = _mm_and_ps(_mm_and_ps(
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), r0), zero),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), r1), zero)),
+					_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), r2), zero));
+				__m128	old = _mm_loadu_ps(line + x);
+				__m128	nearer = _mm_min_ps(old, _mm_add_ps(_mm_mul_ps(dz, px), rz));
+				_mm_storeu_ps(line + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+			}
+#else
+			for (int x = t.minX; x <= t.maxX && x < WIDTH; x++)
+			{
+				float	px = static_cast<float>(x) + 0.5f;
+				if (t.edge[0][0] * px + row0 >= 0.0f && t.edge[1][0] * px + row1 >= 0.0f && t.edge[2][0] * px + row2 >= 0.0f)
+					line[x] = std::min(line[x], t.depth[1] * px + rowZ);
+			}
+#endif
+		}
+	}
+
+	// max pyramid : 2x2 중 가장 먼 깊이
+	for (int level = 1; level < LEVELS; level++)
+	{
+		const float*	below = _levels[level - 1].data();
+		float*				above = _levels[level].data();
+		int						width = WIDTH >> level, belowWidth = WIDTH >> (level - 1);
+		for (int y = y0 >> level; y < y1 >> level; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				const float*	quad = below + y * 2 * belowWidth + x * 2;
+				above[y * width + x] = std::max(std::max(quad[0], quad[1]), std::max(quad[belowWidth], quad[belowWidth + 1]));
+			}
+		}
+	}
+}
+
+void	OcclusionBuffer::render()
+{
+	if (_workers.empty())
+	{
+		size_t	threads = std::max(1u, std::thread::hardware_concurrency());
+		if (threads > BANDS)
+			threads = BANDS;
+		for (size_t i = 1; i < threads; i++)
+			_workers.push_back(std::thread(&OcclusionBuffer::workerLoop, this));
+	}
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_nextBand = 0;
+		_bandsLeft = BANDS;
+		_generation++;
+	}
+	_start.notify_all();
+
+	size_t	band;
+	while (takeBand(band))
+	{
+		renderBand(band);
+		finishBand();
+	}
+	std::unique_lock<std::mutex>	lock(_mutex);
+	_done.wait(lock, [this] { return _bandsLeft == 0; });
+}
+
+// 상자가 4x4 texel 안에 들어가는 가장 낮은 level 에서 덮는 texel 의 가장 먼 깊이보다 상자가 더 멀면 숨은 것입니다.
+bool	OcclusionBuffer::isOccluded(const Mat4& mvp, const Bounds& bounds) const
+{
+	int		rect[4];
+	float	nearest;
+	if (!projectBounds(mvp, bounds, rect, nearest))
+		return false;
+
+	int	level = 0;
+	while (level < LEVELS - 1 && ((rect[1] >> level) - (rect[0] >> level) >= 4 || (rect[3] >> level) - (rect[2] >> level) >= 4))
+		level++;
+	const float*	texels = _levels[level].data();
+	int						width = WIDTH >> level;
+	for (int y = rect[2] >> level; y <= rect[3] >> level; y++)
+		for (int x = rect[0] >> level; x <= rect[1] >> level; x++)
+			if (!(nearest > texels[y * width + x]))
+				return false;
+	return true;
+}
@@ -0,0 +1,73 @@
+#ifndef __OCCLUSIONBUFFER_HPP__
+# define __OCCLUSIONBUFFER_HPP__
+
+# include <vector>
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+
+# include "Matrix.hpp"
+# include "MeshData.hpp"
+
+// software occlusion culling : 화면을 가리는 큰 object (occluder) 의 삼각형 일부를 CPU 에서 작은 depth buffer 에 그리고,
+// 다른 object 의 화면 상자가 그 뒤에 완전히 숨는지 hierarchical-Z 로 봅니다. 숨으면 drawObject 를 부르지 않습니다.
+// occluder 는 mesh 의 가장 큰 삼각형 OCCLUDER_TRIANGLES 개라 실제보다 덜 가릴 뿐, 보이는 object 를 자르지 않습니다.
+// buffer 는 BANDS 개의 가로 띠로 나누어 띠마다 한 스레드가 그리므로 스레드끼리 pixel 을 나누어 쓰지 않습니다.
+// 깊이는 NDC z (가까울수록 작음) 이고, pyramid 는 2x2 의 가장 먼 값을 올립니다.
+class OcclusionBuffer
+{
+	private:
+		// 화면 공간 삼각형 : 세 변의 edge function (A x + B y + C >= 0 이면 안쪽) 과 depth 평면
+		struct	ScreenTriangle {
+			float	edge[3][3];
+			float	depth[3];		// z = depth[0] + depth[1] x + depth[2] y
+			int		minX, maxX, minY, maxY;
+		};
+
+		std::vector<float>					_levels[6];		// LEVELS 개, 0 이 depth buffer
+		std::vector<ScreenTriangle>	_triangles;
+		std::vector<Vec4>						_clip;
+
+		std::vector<std::thread>		_workers;
+		std::mutex									_mutex;
+		std::condition_variable			_start;
+		std::condition_variable			_done;
+		unsigned int								_generation;
+		size_t											_nextBand;
+		size_t											_bandsLeft;
+		bool												_stop;
+
+		OcclusionBuffer();
+		~OcclusionBuffer();
+		OcclusionBuffer(const OcclusionBuffer&);
+		OcclusionBuffer&	operator=(const OcclusionBuffer&);
+
+		void	workerLoop();
+		bool	takeBand(size_t& band);
+		void	finishBand();
+		void	renderBand(size_t band);
+		// 상자를 화면 공간으로 : near 평면을 넘으면 false
+		bool	projectBounds(const Mat4& mvp, const Bounds& bounds, int* rect, float& nearest) const;
+
+	public:
+		static const int		WIDTH = 256;
+		static const int		HEIGHT = 128;
+		static const int		LEVELS = 6;				// HEIGHT / BANDS 가 2^(LEVELS - 1) 의 배수여야 합니다.
+		static const size_t	BANDS = 4;
+		static const size_t	OCCLUDER_TRIANGLES = 1024;
+		static const float	OCCLUDER_MIN_COVERAGE;	// 화면 상자가 buffer 의 이만큼은 덮어야 occluder 로 씁니다.
+
+		static OcclusionBuffer&	getInstance();
+
+		// 넓이가 큰 삼각형부터 OCCLUDER_TRIANGLES 개를 정점 3 개씩 (w = 1) occluder 에 담습니다.
+		static void	makeOccluder(const std::vector<float>& vertices, const std::vector<FaceData>& faces, std::vector<Vec4>& occluder);
+
+		// 한 프레임 : begin() -> addOccluder() ... -> render() -> isOccluded() ...
+		void	begin();
+		// 화면 상자가 충분히 크면 삼각형을 화면 공간으로 옮겨 둡니다. 썼으면 true
+		bool	addOccluder(const Mat4& mvp, const Bounds& bounds, const std::vector<Vec4>& occluder);
+		void	render();
+		bool	isOccluded(const Mat4& mvp, const Bounds& bounds) const;
+};
+
+#endif
@@ -0,0 +1,310 @@
+#include "PageTiler.hpp"
+#include "TextureCache.hpp"
+
+namespace
+{
+	const unsigned int	PAGE_FILE_VERSION = 1;
+	const size_t				SOURCE_KEY_BYTES = 64 * 1024;
+
+	// 한 행씩 읽을 수 있는 이미지. 원본 전체를 메모리에 올리지 않고 page 를 만들기 위해 사용합니다.
+	class RowSource
+	{
+		public:
+			unsigned int	width;
+			unsigned int	height;
+
+			virtual	~RowSource() {}
+			virtual void	readRow(unsigned int y, unsigned char* rgba) = 0;
+	};
+
+	// 무압축 BMP 를 파일에서 한 행씩 바로 읽습니다.
+	class BMPRowSource : public RowSource
+	{
+		private:
+			std::ifstream								_file;
+			BMPInfo											_info;
+			std::vector<unsigned char>	_row;
+
+		public:
+			BMPRowSource(const std::string& path, const BMPInfo& info) : _file(path, std::ios::binary), _info(info)
+			{
+				if (!_file.is_open())
+					throw std::runtime_error("ERROR::LOADER::BMP::FILE_OPEN_FAIL\nfailed to open file.");
+				width = info.width;
+				height = info.height;
+				_row.resize(info.rowSize);
+			}
+
+			void	readRow(unsigned int y, unsigned char* rgba)
+			{
+				unsigned int	fileRow = _info.topDown ? height - 1 - y : y;
+				_file.seekg(static_cast<std::streamoff>(_info.dataOffset) + static_cast<std::streamoff>(fileRow) * _info.rowSize);
+				// 마지막 행은 padding 이 빠져 있을 수 있습니다.
+				_file.read(reinterpret_cast<char*>(_row.data()), _row.size());
+				if (static_cast<size_t>(_file.gcount()) < (static_cast<size_t>(width) * _info.bitCount + 7) / 8)
+					throw std::runtime_error("ERROR::LOADER::BMP::WRONG_FORMAT\nimage data not found.");
+				_file.clear();
+				decodeBMPRow(_info, _row.data(), rgba);
+			}
+	};
+
+	// 행 단위로 읽을 수 없는 형식 (JPEG, RLE BMP) 은 전체를 디코딩해 둡니다.
+	class MemoryRowSource : public RowSource
+	{
+		private:
+			std::vector<unsigned char>	_rgba;
+
+		public:
+			explicit MemoryRowSource(const std::string& path)
+			{
+				std::vector<unsigned char>	file;
+				TextureCache::readFile(path, file);
+				TextureCache::decodeImage(path, file, _rgba, width, height);
+			}
+
+			void	readRow(unsigned int y, unsigned char* rgba)
+			{
+				std::memcpy(rgba, &_rgba[static_cast<size_t>(y) * width * 4], static_cast<size_t>(width) * 4);
+			}
+	};
+
+	// 다음 level 을 만들 때 쓰는 임시 RGBA 파일
+	class RawRowSource : public RowSource
+	{
+		private:
+			std::ifstream	_file;
+
+		public:
+			RawRowSource(const std::string& path, unsigned int w, unsigned int h) : _file(path, std::ios::binary)
+			{
+				width = w;
+				height = h;
+				if (!_file.is_open())
+					throw std::runtime_error("ERROR::LOADER::VT::FILE_OPEN_FAIL\nfailed to open temporary level file.");
+			}
+
+			void	readRow(unsigned int y, unsigned char* rgba)
+			{
+				_file.seekg(static_cast<std::streamoff>(y) * width * 4);
+				if (!_file.read(reinterpret_cast<char*>(rgba), static_cast<std::streamsize>(width) * 4))
+					throw std::runtime_error("ERROR::LOADER::VT::WRONG_FORMAT\ntemporary level file is truncated.");
+			}
+	};
+
+	unsigned int	wrap(long long value, unsigned int size)
+	{
+		long long	result = value % static_cast<long long>(size);
+		return static_cast<unsigned int>(result < 0 ? result + size : result);
+	}
+
+	unsigned int	pageCount(unsigned int size)
+	{
+		return (size + VT_PAGE_SIZE - 1) / VT_PAGE_SIZE;
+	}
+
+	// 한 level 의 page 들을 page 한 줄 (테두리 포함 VT_SLOT_SIZE 행) 씩 만들어 씁니다.
+	void	writeLevel(RowSource& source, std::ofstream& out)
+	{
+		unsigned int								width = source.width, height = source.height;
+		std::vector<unsigned char>	strip(static_cast<size_t>(VT_SLOT_SIZE) * width * 4);
+		std::vector<unsigned char>	page(VT_PAGE_BYTES);
+
+		for (unsigned int py = 0; py < pageCount(height); py++)
+		{
+			for (unsigned int r = 0; r < VT_SLOT_SIZE; r++)
+			{
+				long long	y = static_cast<long long>(py) * VT_PAGE_SIZE + r - VT_PAGE_BORDER;
+				source.readRow(wrap(y, height), &strip[static_cast<size_t>(r) * width * 4]);
+			}
+			for (unsigned int px = 0; px < pageCount(width); px++)
+			{
+				for (unsigned int r = 0; r < VT_SLOT_SIZE; r++)
+				{
+					const unsigned char*	row = &strip[static_cast<size_t>(r) * width * 4];
+					for (unsigned int c = 0; c < VT_SLOT_SIZE; c++)
+					{
+						long long	x = static_cast<long long>(px) * VT_PAGE_SIZE + c - VT_PAGE_BORDER;
+						std::memcpy(&page[(r * VT_SLOT_SIZE + c) * 4], row + static_cast<size_t>(wrap(x, width)) * 4, 4);
+					}
+				}
+				out.write(reinterpret_cast<const char*>(page.data()), page.size());
+			}
+		}
+	}
+
+	// 2x2 box filter 로 다음 level 을 임시 파일에 씁니다. (크기는 내림, 최소 1)
+	void	writeNextLevel(RowSource& source, const std::string& path, unsigned int nextWidth, unsigned int nextHeight)
+	{
+		std::ofstream								out(path, std::ios::binary | std::ios::trunc);
+		unsigned int								width = source.width, height = source.height;
+		std::vector<unsigned char>	row0(static_cast<size_t>(width) * 4), row1(row0.size()), next(static_cast<size_t>(nextWidth) * 4);
+
+		if (!out.is_open())
+			throw std::runtime_error("ERROR::LOADER::VT::FILE_OPEN_FAIL\nfailed to create temporary level file.");
+		for (unsigned int y = 0; y < nextHeight; y++)
+		{
+			source.readRow(std::min(y * 2, height - 1), row0.data());
+			source.readRow(std::min(y * 2 + 1, height - 1), row1.data());
+			for (unsigned int x = 0; x < nextWidth; x++)
+			{
+				unsigned int	x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					unsigned int	sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+					next[x * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+			out.write(reinterpret_cast<const char*>(next.data()), next.size());
+		}
+		if (!out)
+			throw std::runtime_error("ERROR::LOADER::VT::WRITE_FAIL\nfailed to write temporary level file.");
+	}
+}
+
+unsigned long long	pageSourceKey(const std::string& sourcePath)
+{
+	std::ifstream	file(sourcePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return 0;
+
+	unsigned long long					size = static_cast<unsigned long long>(file.tellg());
+	size_t											chunk = static_cast<size_t>(std::min<unsigned long long>(size, SOURCE_KEY_BYTES));
+	std::vector<unsigned char>	data(chunk * 2);
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(data.data()), chunk);
+	file.seekg(static_cast<std::streamoff>(size - chunk));
+	file.read(reinterpret_cast<char*>(data.data() + chunk), chunk);
+	return TextureCache::hashContent(data) ^ (size * 0x9E3779B97F4A7C15ULL);
+}
+
+void	tilePageFile(const std::string& sourcePath, const std::string& pagePath)
+{
+	RowSource*	source = 0;
+	if (!TextureCache::isJPEG(sourcePath))
+	{
+		std::ifstream								file(sourcePath, std::ios::binary);
+		std::vector<unsigned char>	header(BMP_HEADER_BYTES);
+		BMPInfo											info;
+		if (!file.is_open())
+			throw std::runtime_error("ERROR::LOADER::BMP::FILE_OPEN_FAIL\nfailed to open file.");
+		file.read(reinterpret_cast<char*>(header.data()), header.size());
+		readBMPInfo(header.data(), file.gcount(), info);
+		if (isBMPRowSeekable(info))
+			source = new BMPRowSource(sourcePath, info);
+	}
+	if (!source)
+		source = new MemoryRowSource(sourcePath);
+
+	PageFileHeader	header = {{'V', 'T', 'E', 'X'}, PAGE_FILE_VERSION, source->width, source->height,
+										VT_PAGE_SIZE, VT_PAGE_BORDER, 1, 0, pageSourceKey(sourcePath)};
+	for (unsigned int w = header.width, h = header.height; w > VT_PAGE_SIZE || h > VT_PAGE_SIZE; header.levelCount++)
+	{
+		w = std::max(1u, w / 2);
+		h = std::max(1u, h / 2);
+	}
+
+	// 끝까지 쓴 뒤에 이름을 바꿔서, 중간에 멈춰도 반쯤 쓴 page 파일이 남지 않게 합니다.
+	std::string		tmpPath = pagePath + ".tmp";
+	std::ofstream	out(tmpPath, std::ios::binary | std::ios::trunc);
+	std::string		levelPath[2] = {pagePath + ".level0.tmp", pagePath + ".level1.tmp"};
+	try
+	{
+		if (!out.is_open())
+			throw std::runtime_error("ERROR::LOADER::VT::FILE_OPEN_FAIL\nfailed to create page file.");
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (unsigned int level = 0; level < header.levelCount; level++)
+		{
+			writeLevel(*source, out);
+			if (level + 1 == header.levelCount)
+				break ;
+			unsigned int	nextWidth = std::max(1u, source->width / 2), nextHeight = std::max(1u, source->height / 2);
+			const std::string&	nextPath = levelPath[level % 2];
+			writeNextLevel(*source, nextPath, nextWidth, nextHeight);
+			delete source;
+			source = 0;	// 아래 생성자가 던지면 catch 에서 두 번 지우지 않게
+			source = new RawRowSource(nextPath, nextWidth, nextHeight);
+		}
+		if (!out)
+			throw std::runtime_error("ERROR::LOADER::VT::WRITE_FAIL\nfailed to write page file.");
+	}
+	catch (...)
+	{
+		delete source;
+		out.close();
+		std::remove(tmpPath.c_str());
+		std::remove(levelPath[0].c_str());
+		std::remove(levelPath[1].c_str());
+		throw ;
+	}
+	delete source;
+	out.close();
+	std::remove(levelPath[0].c_str());
+	std::remove(levelPath[1].c_str());
+	std::remove(pagePath.c_str());
+	if (std::rename(tmpPath.c_str(), pagePath.c_str()) != 0)
+		throw std::runtime_error("ERROR::LOADER::VT::WRITE_FAIL\nfailed to rename page file.");
+}
+
+bool	PageFile::open(const std::string& path, unsigned long long sourceKey)
+{
+	_file.close();
+	_file.clear();
+	_file.open(path, std::ios::binary);
+	if (!_file.is_open() || !_file.read(reinterpret_cast<char*>(&_header), sizeof(_header)))
+		return false;
+	if (std::memcmp(_header.magic, "VTEX", 4) || _header.version != PAGE_FILE_VERSION || _header.sourceKey != sourceKey
+		|| _header.pageSize != VT_PAGE_SIZE || _header.border != VT_PAGE_BORDER || _header.levelCount == 0
+		|| _header.width == 0 || _header.height == 0)
+		return false;
+
+	_levelOffset.assign(_header.levelCount, 0);
+	for (unsigned int level = 1; level < _header.levelCount; level++)
+		_levelOffset[level] = _levelOffset[level - 1] + static_cast<unsigned long long>(pagesX(level - 1)) * pagesY(level - 1);
+	return true;
+}
+
+unsigned int	PageFile::width() const
+{
+	return _header.width;
+}
+
+unsigned int	PageFile::height() const
+{
+	return _header.height;
+}
+
+unsigned int	PageFile::levelCount() const
+{
+	return _header.levelCount;
+}
+
+unsigned int	PageFile::levelWidth(unsigned int level) const
+{
+	return std::max(1u, _header.width >> level);
+}
+
+unsigned int	PageFile::levelHeight(unsigned int level) const
+{
+	return std::max(1u, _header.height >> level);
+}
+
+unsigned int	PageFile::pagesX(unsigned int level) const
+{
+	return pageCount(levelWidth(level));
+}
+
+unsigned int	PageFile::pagesY(unsigned int level) const
+{
+	return pageCount(levelHeight(level));
+}
+
+void	PageFile::readPage(unsigned int level, unsigned int x, unsigned int y, std::vector<unsigned char>& rgba)
+{
+	unsigned long long	index = _levelOffset[level] + static_cast<unsigned long long>(y) * pagesX(level) + x;
+
+	rgba.resize(VT_PAGE_BYTES);
+	_file.clear();
+	_file.seekg(static_cast<std::streamoff>(sizeof(_header) + index * VT_PAGE_BYTES));
+	if (!_file.read(reinterpret_cast<char*>(rgba.data()), rgba.size()))
+		throw std::runtime_error("ERROR::LOADER::VT::WRONG_FORMAT\npage file is truncated.");
+}
@@ -0,0 +1,57 @@
+#ifndef __PAGETILER_HPP__
+# define __PAGETILER_HPP__
+
+# include <vector>
+# include <string>
+# include <fstream>
+# include <cstdio>
+# include <cstring>
+# include <stdexcept>
+# include <algorithm>
+
+// 가상 텍스처 page 파일 (<file>.vt)
+// 원본을 mip level 마다 VT_PAGE_SIZE 크기의 page 로 나누고, 각 page 에 이웃 texel 로 채운
+// VT_PAGE_BORDER 만큼의 테두리를 붙여 저장합니다. (physical cache 에서 bilinear 가 번지지 않게)
+// page 크기가 고정이라 위치는 계산으로 찾습니다. (level 0 부터, level 안에서는 아래 줄부터) 가장자리는 GL_REPEAT 처럼 이어집니다.
+
+static const unsigned int	VT_PAGE_SIZE = 128;
+static const unsigned int	VT_PAGE_BORDER = 4;
+static const unsigned int	VT_SLOT_SIZE = VT_PAGE_SIZE + 2 * VT_PAGE_BORDER;
+static const size_t				VT_PAGE_BYTES = VT_SLOT_SIZE * VT_SLOT_SIZE * 4;
+
+struct	PageFileHeader {
+	char								magic[4];
+	unsigned int				version;
+	unsigned int				width;
+	unsigned int				height;
+	unsigned int				pageSize;
+	unsigned int				border;
+	unsigned int				levelCount;
+	unsigned int				padding;
+	unsigned long long	sourceKey;
+};
+
+class PageFile
+{
+	private:
+		std::ifstream								_file;
+		PageFileHeader							_header;
+		std::vector<unsigned long long>	_levelOffset;	// level 의 첫 page 번호
+
+	public:
+		bool					open(const std::string& path, unsigned long long sourceKey);
+		unsigned int	width() const;
+		unsigned int	height() const;
+		unsigned int	levelCount() const;
+		unsigned int	levelWidth(unsigned int level) const;
+		unsigned int	levelHeight(unsigned int level) const;
+		unsigned int	pagesX(unsigned int level) const;
+		unsigned int	pagesY(unsigned int level) const;
+		void					readPage(unsigned int level, unsigned int x, unsigned int y, std::vector<unsigned char>& rgba);
+};
+
+// 원본 파일 크기 + 앞 / 뒤 64KiB 의 hash. 수 GB 짜리 원본 전체를 읽지 않고 page 파일이 최신인지 확인합니다.
+unsigned long long	pageSourceKey(const std::string& sourcePath);
+void								tilePageFile(const std::string& sourcePath, const std::string& pagePath);
+
+#endif
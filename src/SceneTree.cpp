@@ -0,0 +1,453 @@
+#include "SceneTree.hpp"
+#include "BinnedSAH.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	inline float	unionArea(const float* minA, const float* maxA, const float* minB, const float* maxB)
+	{
+		float	min[3], max[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			min[axis] = std::min(minA[axis], minB[axis]);
+			max[axis] = std::max(maxA[axis], maxB[axis]);
+		}
+		return boxArea(min, max);
+	}
+}
+
+const float	SceneTree::FAT_RATIO = 0.1f;
+const float	SceneTree::REBUILD_RATIO = 1.5f;
+
+SceneTree::SceneTree() : _root(-1), _leafCount(0), _builtCost(0.0f), _changed(false)
+{
+}
+
+int	SceneTree::allocate()
+{
+	if (!_freeNodes.empty())
+	{
+		int	index = _freeNodes.back();
+		_freeNodes.pop_back();
+		return index;
+	}
+	_nodes.push_back(Node());
+	return static_cast<int>(_nodes.size() - 1);
+}
+
+void	SceneTree::release(int index)
+{
+	_freeNodes.push_back(index);
+}
+
+// 두 child 를 감싸도록 상자를 다시 구하고 회전해 보면서 root 까지 올라갑니다.
+void	SceneTree::refit(int index)
+{
+	while (index >= 0)
+	{
+		Node&				node = _nodes[index];
+		const Node&	left = _nodes[node.child[0]];
+		const Node&	right = _nodes[node.child[1]];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			node.min[axis] = std::min(left.min[axis], right.min[axis]);
+			node.max[axis] = std::max(left.max[axis], right.max[axis]);
+		}
+		rotate(index);
+		index = _nodes[index].parent;
+	}
+}
+
+// A 의 child B, C 중 하나를 다른 쪽의 child 와 바꿔 봅니다. A 의 상자는 그대로이고 바뀐 child 의 상자만 달라지므로,
+// 그 상자가 가장 많이 작아지는 교환을 합니다. (작아지는 것이 없으면 그대로)
+void	SceneTree::rotate(int index)
+{
+	int	b = _nodes[index].child[0], c = _nodes[index].child[1];
+	int	bestSide = -1, bestChild = -1;
+	float	bestDelta = 0.0f;
+
+	for (int side = 0; side < 2; side++)
+	{
+		// side 0 : B 를 C 의 child 와 바꿈, side 1 : C 를 B 의 child 와 바꿈
+		const Node&	moving = _nodes[side ? c : b];
+		const Node&	parent = _nodes[side ? b : c];
+		if (parent.child[0] < 0)
+			continue ;
+		float	parentArea = boxArea(parent.min, parent.max);
+		for (int child = 0; child < 2; child++)
+		{
+			// parent 의 child 를 꺼내면 parent 에는 moving 과 남은 child 가 들어갑니다.
+			const Node&	kept = _nodes[parent.child[1 - child]];
+			float				delta = unionArea(moving.min, moving.max, kept.min, kept.max) - parentArea;
+			if (delta < bestDelta)
+			{
+				bestDelta = delta;
+				bestSide = side;
+				bestChild = child;
+			}
+		}
+	}
+	if (bestSide < 0)
+		return ;
+
+	int	moving = bestSide ? c : b;
+	int	parent = bestSide ? b : c;
+	int	grandChild = _nodes[parent].child[bestChild];
+	_nodes[index].child[bestSide] = grandChild;
+	_nodes[parent].child[bestChild] = moving;
+	_nodes[grandChild].parent = index;
+	_nodes[moving].parent = parent;
+
+	Node&				node = _nodes[parent];
+	const Node&	left = _nodes[node.child[0]];
+	const Node&	right = _nodes[node.child[1]];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		node.min[axis] = std::min(left.min[axis], right.min[axis]);
+		node.max[axis] = std::max(left.max[axis], right.max[axis]);
+	}
+}
+
+// 새 leaf 를 어느 node 옆에 붙일지 : 그 node 까지 가는 길의 상자들이 커지는 만큼 (inherited) 과
+// 새 부모의 겉넓이를 더한 cost 가 가장 작은 곳입니다. 아래로 내려가도 더 좋아질 수 없는 가지는 자릅니다.
+int	SceneTree::findSibling(const Node& leaf) const
+{
+	float	leafArea = boxArea(leaf.min, leaf.max);
+	int		best = _root;
+	float	bestCost = unionArea(_nodes[_root].min, _nodes[_root].max, leaf.min, leaf.max);
+
+	std::vector<std::pair<int, float> >	stack(1, std::make_pair(_root, 0.0f));
+	while (!stack.empty())
+	{
+		int		index = stack.back().first;
+		float	inherited = stack.back().second;
+		stack.pop_back();
+
+		const Node&	node = _nodes[index];
+		float				direct = unionArea(node.min, node.max, leaf.min, leaf.max);
+		if (direct + inherited < bestCost)
+		{
+			bestCost = direct + inherited;
+			best = index;
+		}
+		inherited += direct - boxArea(node.min, node.max);
+		if (node.child[0] >= 0 && leafArea + inherited < bestCost)
+		{
+			stack.push_back(std::make_pair(node.child[0], inherited));
+			stack.push_back(std::make_pair(node.child[1], inherited));
+		}
+	}
+	return best;
+}
+
+int	SceneTree::insert(unsigned int id, const float* min, const float* max)
+{
+	int		leaf = allocate();
+	Node&	node = _nodes[leaf];
+	float	margin = FAT_RATIO * std::max(max[0] - min[0], std::max(max[1] - min[1], max[2] - min[2]));
+	for (int axis = 0; axis < 3; axis++)
+	{
+		node.min[axis] = min[axis] - margin;
+		node.max[axis] = max[axis] + margin;
+	}
+	node.parent = -1;
+	node.child[0] = node.child[1] = -1;
+	node.id = id;
+	_leafCount++;
+	_changed = true;
+
+	if (_root < 0)
+	{
+		_root = leaf;
+		return leaf;
+	}
+
+	int	sibling = findSibling(_nodes[leaf]);
+	int	parent = allocate();
+	int	grandParent = _nodes[sibling].parent;
+	_nodes[parent].parent = grandParent;
+	_nodes[parent].child[0] = sibling;
+	_nodes[parent].child[1] = leaf;
+	_nodes[sibling].parent = parent;
+	_nodes[leaf].parent = parent;
+	if (grandParent < 0)
+		_root = parent;
+	else
+		_nodes[grandParent].child[_nodes[grandParent].child[0] == sibling ? 0 : 1] = parent;
+	refit(parent);
+	return leaf;
+}
+
+// leaf 의 부모 자리를 형제가 대신합니다.
+void	SceneTree::remove(int proxy)
+{
+	_leafCount--;
+	_changed = true;
+	if (proxy == _root)
+	{
+		_root = -1;
+		release(proxy);
+		return ;
+	}
+
+	int	parent = _nodes[proxy].parent;
+	int	sibling = _nodes[parent].child[_nodes[parent].child[0] == proxy ? 1 : 0];
+	int	grandParent = _nodes[parent].parent;
+	_nodes[sibling].parent = grandParent;
+	if (grandParent < 0)
+		_root = sibling;
+	else
+	{
+		_nodes[grandParent].child[_nodes[grandParent].child[0] == parent ? 0 : 1] = sibling;
+		refit(grandParent);
+	}
+	release(parent);
+	release(proxy);
+}
+
+bool	SceneTree::move(int proxy, const float* min, const float* max)
+{
+	Node&	node = _nodes[proxy];
+	if (node.min[0] <= min[0] && node.min[1] <= min[1] && node.min[2] <= min[2]
+		&& max[0] <= node.max[0] && max[1] <= node.max[1] && max[2] <= node.max[2])
+		return false;
+
+	float	margin = FAT_RATIO * std::max(max[0] - min[0], std::max(max[1] - min[1], max[2] - min[2]));
+	for (int axis = 0; axis < 3; axis++)
+	{
+		node.min[axis] = min[axis] - margin;
+		node.max[axis] = max[axis] + margin;
+	}
+	_changed = true;
+	refit(node.parent);
+	return true;
+}
+
+// 내부 node 겉넓이의 합을 root 겉넓이로 나눈 값 : 광선 하나가 평균적으로 지나는 내부 node 수에 비례합니다.
+float	SceneTree::cost() const
+{
+	if (_root < 0 || _nodes[_root].child[0] < 0)
+		return 0.0f;
+	float	rootArea = boxArea(_nodes[_root].min, _nodes[_root].max);
+	if (rootArea <= 0.0f)
+		return 0.0f;
+
+	float							sum = 0.0f;
+	std::vector<int>	stack(1, _root);
+	while (!stack.empty())
+	{
+		const Node&	node = _nodes[stack.back()];
+		stack.pop_back();
+		if (node.child[0] < 0)
+			continue ;
+		sum += boxArea(node.min, node.max);
+		stack.push_back(node.child[0]);
+		stack.push_back(node.child[1]);
+	}
+	return sum / rootArea;
+}
+
+void	SceneTree::optimize()
+{
+	if (!_changed)
+		return ;
+	_changed = false;
+	if (_leafCount > 2 && cost() > REBUILD_RATIO * _builtCost)
+		rebuild();
+}
+
+// leaf 는 그대로 두고 내부 node 를 모두 버린 뒤 위에서부터 binned SAH 로 나눕니다.
+void	SceneTree::rebuild()
+{
+	if (_root < 0)
+		return ;
+	std::vector<int>	leaves, stack(1, _root);
+	leaves.reserve(_leafCount);
+	while (!stack.empty())
+	{
+		int	index = stack.back();
+		stack.pop_back();
+		if (_nodes[index].child[0] < 0)
+			leaves.push_back(index);
+		else
+		{
+			stack.push_back(_nodes[index].child[0]);
+			stack.push_back(_nodes[index].child[1]);
+			release(index);
+		}
+	}
+	_root = buildRange(leaves.data(), leaves.size());
+	_nodes[_root].parent = -1;
+	_builtCost = cost();
+	_changed = false;
+}
+
+// leaf 중심을 BUILD_BINS 개 칸에 나눠 담고, 세 축의 칸 경계마다 SAH cost (왼쪽 겉넓이 * 개수 + 오른쪽 ...) 를 구해
+// 가장 작은 곳에서 나눕니다. 중심이 모두 같으면 반으로 나눕니다.
+int	SceneTree::buildRange(int* leaves, size_t count)
+{
+	if (count == 1)
+		return leaves[0];
+
+	float	centreMin[3] = { 1e30f, 1e30f, 1e30f }, centreMax[3] = { -1e30f, -1e30f, -1e30f };
+	for (size_t i = 0; i < count; i++)
+	{
+		const Node&	leaf = _nodes[leaves[i]];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float	centre = (leaf.min[axis] + leaf.max[axis]) * 0.5f;
+			centreMin[axis] = std::min(centreMin[axis], centre);
+			centreMax[axis] = std::max(centreMax[axis], centre);
+		}
+	}
+
+	int		bestAxis = -1;
+	size_t	bestSplit = 0;
+	float	bestCost = 0.0f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float	extent = centreMax[axis] - centreMin[axis];
+		if (extent <= 0.0f)
+			continue ;
+		float	scale = BUILD_BINS / extent;
+		SAHBin	bins[BUILD_BINS];
+		for (size_t b = 0; b < BUILD_BINS; b++)
+			bins[b].reset();
+		for (size_t i = 0; i < count; i++)
+		{
+			const Node&	leaf = _nodes[leaves[i]];
+			size_t			b = std::min(BUILD_BINS - 1, static_cast<size_t>(((leaf.min[axis] + leaf.max[axis]) * 0.5f - centreMin[axis]) * scale));
+			bins[b].grow(leaf.min, leaf.max);
+			bins[b].count++;
+		}
+
+		float		cost = 0.0f;
+		size_t	split = findSAHSplit(bins, count, cost);
+		if (split && (bestAxis < 0 || cost < bestCost))
+		{
+			bestAxis = axis;
+			bestSplit = split;
+			bestCost = cost;
+		}
+	}
+
+	size_t	middle = count / 2;
+	if (bestAxis >= 0)
+	{
+		float	scale = BUILD_BINS / (centreMax[bestAxis] - centreMin[bestAxis]);
+		int*	boundary = std::partition(leaves, leaves + count, [&](int index) {
+			const Node&	leaf = _nodes[index];
+			return std::min(BUILD_BINS - 1, static_cast<size_t>(((leaf.min[bestAxis] + leaf.max[bestAxis]) * 0.5f
+				- centreMin[bestAxis]) * scale)) < bestSplit;
+		});
+		middle = boundary - leaves;
+	}
+
+	int	left = buildRange(leaves, middle);
+	int	right = buildRange(leaves + middle, count - middle);
+	int	index = allocate();
+	Node&	node = _nodes[index];
+	node.child[0] = left;
+	node.child[1] = right;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		node.min[axis] = std::min(_nodes[left].min[axis], _nodes[right].min[axis]);
+		node.max[axis] = std::max(_nodes[left].max[axis], _nodes[right].max[axis]);
+	}
+	_nodes[left].parent = index;
+	_nodes[right].parent = index;
+	return index;
+}
+
+size_t	SceneTree::size() const
+{
+	return _leafCount;
+}
+
+void	SceneTree::collectLeaves(int index, std::vector<unsigned int>& result) const
+{
+	std::vector<int>	stack(1, index);
+	while (!stack.empty())
+	{
+		const Node&	node = _nodes[stack.back()];
+		stack.pop_back();
+		if (node.child[0] < 0)
+			result.push_back(node.id);
+		else
+		{
+			stack.push_back(node.child[0]);
+			stack.push_back(node.child[1]);
+		}
+	}
+}
+
+// 평면은 viewProjection 의 row 로 만듭니다. (world 공간)
+// node 가 어떤 평면 안쪽에 완전히 들어가면 그 아래에서는 그 평면을 다시 검사하지 않고,
+// 모든 평면 안쪽이면 아래 leaf 를 검사 없이 모두 넣습니다.
+void	SceneTree::queryFrustum(const Mat4& viewProjection, std::vector<unsigned int>& result) const
+{
+	if (_root < 0)
+		return ;
+	float	planes[6][4];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int col = 0; col < 4; col++)
+		{
+			planes[axis * 2][col] = viewProjection.m[col * 4 + 3] + viewProjection.m[col * 4 + axis];
+			planes[axis * 2 + 1][col] = viewProjection.m[col * 4 + 3] - viewProjection.m[col * 4 + axis];
+		}
+	}
+
+	std::vector<std::pair<int, int> >	stack(1, std::make_pair(_root, 0x3f));
+	while (!stack.empty())
+	{
+		int	index = stack.back().first;
+		int	mask = stack.back().second;
+		stack.pop_back();
+
+		const Node&	node = _nodes[index];
+		bool				outside = false;
+		for (int p = 0; p < 6 && !outside; p++)
+		{
+			if (!(mask & (1 << p)))
+				continue ;
+			float	distance = planes[p][3], reach = 0.0f;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				distance += planes[p][axis] * (node.min[axis] + node.max[axis]) * 0.5f;
+				reach += std::fabs(planes[p][axis]) * (node.max[axis] - node.min[axis]) * 0.5f;
+			}
+			if (distance + reach < 0.0f)
+				outside = true;
+			else if (distance - reach >= 0.0f)
+				mask &= ~(1 << p);
+		}
+		if (outside)
+			continue ;
+		if (mask == 0 || node.child[0] < 0)
+			collectLeaves(index, result);
+		else
+		{
+			stack.push_back(std::make_pair(node.child[0], mask));
+			stack.push_back(std::make_pair(node.child[1], mask));
+		}
+	}
+}
+
+// slab 검사 : 세 축의 [들어가는 t, 나가는 t] 를 겹쳐서 [0, maxDistance] 안에 남는 구간이 있는지 봅니다.
+bool	SceneTree::intersectRay(const Node& node, const float* origin, const float* inverse, float maxDistance, float& entry)
+{
+	float	near = 0.0f, far = maxDistance;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float	t0 = (node.min[axis] - origin[axis]) * inverse[axis];
+		float	t1 = (node.max[axis] - origin[axis]) * inverse[axis];
+		if (t0 > t1)
+			std::swap(t0, t1);
+		near = t0 > near ? t0 : near;
+		far = t1 < far ? t1 : far;
+	}
+	entry = near;
+	return near <= far;
+}
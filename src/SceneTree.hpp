@@ -0,0 +1,106 @@
+#ifndef __SCENETREE_HPP__
+# define __SCENETREE_HPP__
+
+# include <vector>
+
+# include "Matrix.hpp"
+
+// object 들의 world AABB 위에 만든 동적 BVH 입니다. TransformStore 가 갖고 있고 update() 때 맞춥니다.
+// leaf 는 실제 상자보다 FAT_RATIO 만큼 큰 상자를 들고 있어서, 조금 움직인 object 는 tree 를 건드리지 않습니다.
+// 벗어나면 조상을 아래에서부터 다시 맞추면서 겉넓이가 줄어드는 회전을 하고, cost 가 REBUILD_RATIO 배를 넘으면 binned SAH 로 다시 만듭니다.
+// query 는 fat 상자로 고르므로 결과는 넉넉합니다. (정확한 검사는 부르는 쪽이 합니다)
+class SceneTree
+{
+	private:
+		struct	Node {
+			float					min[3];
+			float					max[3];
+			int						parent;
+			int						child[2];		// leaf 면 -1
+			unsigned int	id;					// leaf 의 transform id
+		};
+
+		std::vector<Node>	_nodes;
+		std::vector<int>	_freeNodes;
+		int								_root;
+		size_t						_leafCount;
+		float							_builtCost;		// 마지막 build 직후의 cost (0 이면 아직 build 하지 않음)
+		bool							_changed;			// 마지막 optimize() 뒤로 구조가 바뀌었는지
+
+		SceneTree(const SceneTree&);
+		SceneTree&	operator=(const SceneTree&);
+
+		int			allocate();
+		void		release(int index);
+		void		refit(int index);
+		void		rotate(int index);
+		int			findSibling(const Node& leaf) const;
+		int			buildRange(int* leaves, size_t count);
+		float		cost() const;
+		void		collectLeaves(int index, std::vector<unsigned int>& result) const;
+		static bool	intersectRay(const Node& node, const float* origin, const float* inverse, float maxDistance, float& entry);
+
+	public:
+		static const float	FAT_RATIO;				// fat 상자 여유 : 가장 긴 변에 대한 비율
+		static const float	REBUILD_RATIO;
+		static const size_t	BUILD_BINS = 12;
+
+		SceneTree();
+
+		// proxy 번호를 돌려줍니다. remove() / move() 에 씁니다.
+		int			insert(unsigned int id, const float* min, const float* max);
+		void		remove(int proxy);
+		// 새 상자가 fat 상자 안이면 아무것도 하지 않고 false 를 돌려줍니다.
+		bool		move(int proxy, const float* min, const float* max);
+		// 마지막 optimize() 뒤로 구조가 바뀌었고 cost 가 너무 커졌으면 다시 build 합니다.
+		void		optimize();
+		void		rebuild();
+		size_t	size() const;
+
+		// 상자가 view frustum 과 겹칠 수도 있는 object
+		void		queryFrustum(const Mat4& viewProjection, std::vector<unsigned int>& result) const;
+		// 가까운 상자부터 hit(id, maxDistance) 를 부릅니다. hit 는 그 object 를 맞았으면 그 거리를,
+		// 아니면 maxDistance 를 그대로 돌려주고, 더 먼 상자는 건너뜁니다. direction 은 정규화하지 않아도 됩니다.
+		template <typename F>
+		void		raycast(const float* origin, const float* direction, float maxDistance, F hit) const;
+};
+
+template <typename F>
+void	SceneTree::raycast(const float* origin, const float* direction, float maxDistance, F hit) const
+{
+	if (_root < 0)
+		return ;
+	float	inverse[3];
+	for (int axis = 0; axis < 3; axis++)
+		inverse[axis] = 1.0f / direction[axis];
+
+	std::vector<int>	stack(1, _root);
+	float							entry;
+	while (!stack.empty())
+	{
+		const Node&	node = _nodes[stack.back()];
+		stack.pop_back();
+		if (!intersectRay(node, origin, inverse, maxDistance, entry))
+			continue ;
+		if (node.child[0] < 0)
+		{
+			maxDistance = hit(node.id, maxDistance);
+			continue ;
+		}
+		// 가까운 child 를 나중에 넣어서 먼저 꺼냅니다.
+		float	entry0, entry1;
+		bool	hit0 = intersectRay(_nodes[node.child[0]], origin, inverse, maxDistance, entry0);
+		bool	hit1 = intersectRay(_nodes[node.child[1]], origin, inverse, maxDistance, entry1);
+		if (hit0 && hit1)
+		{
+			stack.push_back(entry0 < entry1 ? node.child[1] : node.child[0]);
+			stack.push_back(entry0 < entry1 ? node.child[0] : node.child[1]);
+		}
+		else if (hit0)
+			stack.push_back(node.child[0]);
+		else if (hit1)
+			stack.push_back(node.child[1]);
+	}
+}
+
+#endif
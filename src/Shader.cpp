@@ -1,5 +1,35 @@
 #include "Shader.hpp"
 
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	// glUniform1i 로 올리는 uniform : int 말고도 bool 과 sampler 가 있습니다.
+	bool	acceptsInt(GLenum type)
+	{
+		switch (type)
+		{
+			case GL_INT:
+			case GL_BOOL:
+			case GL_SAMPLER_1D:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_3D:
+			case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_2D_SHADOW:
+			case GL_SAMPLER_2D_RECT:
+			case GL_SAMPLER_2D_MULTISAMPLE:
+			case GL_SAMPLER_BUFFER:
+			case GL_INT_SAMPLER_2D:
+			case GL_UNSIGNED_INT_SAMPLER_2D:
+				return true;
+			default:
+				return false;
+		}
+	}
+}
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
 {
 	// 1. retrieve the vertex/fragment source code from filePath
@@ -76,6 +106,8 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
 	// delete shaders; they’re linked into our program and no longer necessary
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
+	if (success)
+		reflectUniforms();
 }
 
 Shader::~Shader()
@@ -88,17 +120,111 @@ void	Shader::use()
 	glUseProgram(ID);
 }
 
-void	Shader::setBool(const std::string &name, bool value) const
+// 배열 uniform 은 "name[0]" 으로 나오므로 "name" 으로도 찾을 수 있게 합니다. uniform block 안의 것 (location -1) 은 뺍니다.
+void	Shader::reflectUniforms()
+{
+	int	count = 0, maxLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<char>	name(maxLength + 1);
+	for (int i = 0; i < count; i++)
+	{
+		GLsizei	length = 0;
+		GLint		size = 0;
+		GLenum	type = 0;
+		glGetActiveUniform(ID, i, static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+		std::string	uniformName(name.data(), length);
+		Uniform			uniform;
+		uniform.location = glGetUniformLocation(ID, uniformName.c_str());
+		if (uniform.location < 0)
+			continue ;
+		uniform.type = type;
+		uniform.known = false;
+		std::memset(uniform.value, 0, sizeof(uniform.value));
+		_uniformIndex[uniformName] = static_cast<int>(_uniforms.size());
+		if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+			_uniformIndex[uniformName.substr(0, uniformName.size() - 3)] = static_cast<int>(_uniforms.size());
+		_uniforms.push_back(uniform);
+	}
+}
+
+int	Shader::uniform(const std::string &name) const
+{
+	std::unordered_map<std::string, int>::const_iterator	it = _uniformIndex.find(name);
+	return it == _uniformIndex.end() ? -1 : it->second;
+}
+
+int	Shader::changed(int handle, GLenum type, const void* value, size_t size)
+{
+	if (handle < 0 || static_cast<size_t>(handle) >= _uniforms.size())
+		return -1;
+	Uniform&	uniform = _uniforms[handle];
+#ifndef NDEBUG
+	if (type == GL_INT ? !acceptsInt(uniform.type) : uniform.type != type)
+		throw std::runtime_error("ERROR::SHADER::UNIFORM_TYPE\nsetter does not match the uniform type.");
+#endif
+	if (uniform.known && std::memcmp(uniform.value, value, size) == 0)
+		return -1;
+	std::memcpy(uniform.value, value, size);
+	uniform.known = true;
+	return uniform.location;
+}
+
+void	Shader::setBool(const std::string &name, bool value)
+{
+	setInt(uniform(name), (int)value);
+}
+
+void	Shader::setInt(const std::string &name, int value)
+{
+	setInt(uniform(name), value);
+}
+
+void	Shader::setFloat(const std::string &name, float value)
+{
+	setFloat(uniform(name), value);
+}
+
+void	Shader::setInt(int handle, int value)
+{
+	int	location = changed(handle, GL_INT, &value, sizeof(value));
+	if (location >= 0)
+		glUniform1i(location, value);
+}
+
+void	Shader::setFloat(int handle, float value)
+{
+	int	location = changed(handle, GL_FLOAT, &value, sizeof(value));
+	if (location >= 0)
+		glUniform1f(location, value);
+}
+
+void	Shader::setVec3(int handle, float x, float y, float z)
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	float	value[3] = { x, y, z };
+	int		location = changed(handle, GL_FLOAT_VEC3, value, sizeof(value));
+	if (location >= 0)
+		glUniform3fv(location, 1, value);
 }
 
-void	Shader::setInt(const std::string &name, int value) const
+void	Shader::setVec4(int handle, float x, float y, float z, float w)
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	float	value[4] = { x, y, z, w };
+	int		location = changed(handle, GL_FLOAT_VEC4, value, sizeof(value));
+	if (location >= 0)
+		glUniform4fv(location, 1, value);
 }
 
-void	Shader::setFloat(const std::string &name, float value) const
+void	Shader::setMat3(int handle, const float* value)
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
-}
\ No newline at end of file
+	int	location = changed(handle, GL_FLOAT_MAT3, value, sizeof(float) * 9);
+	if (location >= 0)
+		glUniformMatrix3fv(location, 1, GL_FALSE, value);
+}
+
+void	Shader::setMat4(int handle, const float* value)
+{
+	int	location = changed(handle, GL_FLOAT_MAT4, value, sizeof(float) * 16);
+	if (location >= 0)
+		glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
@@ -9,9 +9,29 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <unordered_map>
 
+// link 한 뒤 active uniform 을 모두 읽어 이름 -> handle 표를 만들어 둡니다.
+// handle 로 부르는 setter 는 glGetUniformLocation 을 부르지 않고, 마지막으로 올린 값과 같으면 glUniform 도 부르지 않습니다.
+// 값은 program 마다의 상태이므로, setter 는 (예전처럼) 이 shader 를 use() 한 상태에서 불러야 합니다.
 class Shader
 {
+	private:
+		struct	Uniform {
+			int			location;
+			GLenum	type;				// glGetActiveUniform 의 type (setter 가 맞는지 봅니다)
+			bool		known;			// 한 번이라도 올렸는지
+			float		value[16];	// 마지막으로 올린 값 (int 는 bit 그대로)
+		};
+
+		std::vector<Uniform>									_uniforms;
+		std::unordered_map<std::string, int>	_uniformIndex;
+
+		void	reflectUniforms();
+		// 올려야 하면 값을 기억하고 location 을, 같은 값이거나 handle 이 없으면 -1 을 돌려줍니다.
+		// NDEBUG 가 아니면 setter 의 type 이 uniform 의 type 과 맞지 않을 때 예외를 던집니다.
+		int		changed(int handle, GLenum type, const void* value, size_t size);
+
 	public:
 		// the program ID
 		unsigned int ID;
@@ -21,10 +41,19 @@ class Shader
 		~Shader();
 		// use/activate the shader
 		void use();
+		// active uniform 의 handle, 없으면 -1 (setter 는 -1 을 무시합니다)
+		int		uniform(const std::string &name) const;
 		// utility uniform functions
-		void setBool(const std::string &name, bool value) const;
-		void setInt(const std::string &name, int value) const;
-		void setFloat(const std::string &name, float value) const;
+		void setBool(const std::string &name, bool value);
+		void setInt(const std::string &name, int value);
+		void setFloat(const std::string &name, float value);
+		// handle 로 올리는 setter, mat 은 column-major float[9] / float[16]
+		void	setInt(int handle, int value);
+		void	setFloat(int handle, float value);
+		void	setVec3(int handle, float x, float y, float z);
+		void	setVec4(int handle, float x, float y, float z, float w);
+		void	setMat3(int handle, const float* value);
+		void	setMat4(int handle, const float* value);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "TextureAtlas.hpp"
+#include "TextureResidency.hpp"
+#include "NormalMap.hpp"
+
+TextureAtlas::TextureAtlas()
+{
+}
+
+TextureAtlas&	TextureAtlas::getInstance()
+{
+	static TextureAtlas	instance;
+	return instance;
+}
+
+bool	TextureAtlas::insert(const std::string& bumpPath, const std::string& diffPath, AtlasRegion& region)
+{
+	// 단색 텍스처 : page 를 새로 만들지 않고 1x1 dummy 를 같이 씁니다. uv 는 어디든 그 texel 을 가리킵니다.
+	if (bumpPath.empty() && diffPath.empty())
+	{
+		region.bumpTextureID = TextureCache::getInstance().acquireDummy(TEXTURE_SLOT_BUMP);
+		region.diffTextureID = TextureCache::getInstance().acquireDummy(TEXTURE_SLOT_DIFFUSE);
+		for (int i = 0; i < 2; i++)
+		{
+			region.uvOffset[i] = 0.5f;
+			region.uvScale[i] = 0.0f;
+		}
+		return true;
+	}
+
+	std::pair<std::string, std::string>	key(bumpPath, diffPath);
+	std::map<std::pair<std::string, std::string>, AtlasRegion>::iterator	it = _regions.find(key);
+	if (it != _regions.end())
+	{
+		region = it->second;
+		TextureCache::getInstance().retain(region.bumpTextureID);
+		TextureCache::getInstance().retain(region.diffTextureID);
+		return true;
+	}
+
+	// 헤더만 읽어서 크기를 먼저 확인합니다. 큰 텍스처는 TextureCache 가 따로 처리합니다.
+	unsigned int	bumpWidth = 1, bumpHeight = 1, diffWidth = 1, diffHeight = 1;
+	if (!bumpPath.empty() && !TextureCache::readImageSize(bumpPath, bumpWidth, bumpHeight))
+		return false;
+	if (!diffPath.empty() && !TextureCache::readImageSize(diffPath, diffWidth, diffHeight))
+		return false;
+	int	width = std::max(bumpWidth, diffWidth);
+	int	height = std::max(bumpHeight, diffHeight);
+	if (width > MAX_TEXTURE_SIZE || height > MAX_TEXTURE_SIZE || width <= 0 || height <= 0)
+		return false;
+
+	unsigned int	page;
+	int						x, y;
+	if (!allocate(width + 2 * PADDING, height + 2 * PADDING, page, x, y))
+		return false;
+
+	std::vector<unsigned char>	bump(4), diff(4);
+	TextureCache::placeholderPixel(TEXTURE_SLOT_BUMP, bump.data());
+	TextureCache::placeholderPixel(TEXTURE_SLOT_DIFFUSE, diff.data());
+	if (!bumpPath.empty())
+		loadImage(bumpPath, TEXTURE_SLOT_BUMP, bump, bumpWidth, bumpHeight);
+	if (!diffPath.empty())
+		loadImage(diffPath, TEXTURE_SLOT_DIFFUSE, diff, diffWidth, diffHeight);
+
+	// bump / diffuse 크기가 다르면 nearest 로 같은 크기에 맞춥니다. (두 map 이 같은 uv 를 사용하므로)
+	std::vector<unsigned char>	bumpResized(width * height * 4), diffResized(width * height * 4);
+	for (int py = 0; py < height; py++)
+	{
+		for (int px = 0; px < width; px++)
+		{
+			size_t	bumpSrc = (static_cast<size_t>(py) * bumpHeight / height * bumpWidth + px * bumpWidth / width) * 4;
+			size_t	diffSrc = (static_cast<size_t>(py) * diffHeight / height * diffWidth + px * diffWidth / width) * 4;
+			std::memcpy(&bumpResized[(py * width + px) * 4], &bump[bumpSrc], 4);
+			std::memcpy(&diffResized[(py * width + px) * 4], &diff[diffSrc], 4);
+		}
+	}
+	uploadPadded(_pages[page].bumpTextureID, TEXTURE_SLOT_BUMP, x, y, bumpResized, width, height);
+	uploadPadded(_pages[page].diffTextureID, TEXTURE_SLOT_DIFFUSE, x, y, diffResized, width, height);
+
+	region.bumpTextureID = _pages[page].bumpTextureID;
+	region.diffTextureID = _pages[page].diffTextureID;
+	region.uvOffset[0] = static_cast<float>(x + PADDING) / PAGE_SIZE;
+	region.uvOffset[1] = static_cast<float>(y + PADDING) / PAGE_SIZE;
+	region.uvScale[0] = static_cast<float>(width) / PAGE_SIZE;
+	region.uvScale[1] = static_cast<float>(height) / PAGE_SIZE;
+	_regions[key] = region;
+	TextureCache::getInstance().retain(region.bumpTextureID);
+	TextureCache::getInstance().retain(region.diffTextureID);
+	return true;
+}
+
+bool	TextureAtlas::allocate(int width, int height, unsigned int& page, int& x, int& y)
+{
+	size_t	node;
+
+	for (page = 0; page < _pages.size(); page++)
+	{
+		if (findPosition(_pages[page], width, height, node, x, y))
+		{
+			addSkylineLevel(_pages[page], node, x, y, width, height);
+			return true;
+		}
+	}
+	addPage();
+	page = _pages.size() - 1;
+	if (!findPosition(_pages[page], width, height, node, x, y))
+		return false;
+	addSkylineLevel(_pages[page], node, x, y, width, height);
+	return true;
+}
+
+// skyline bottom-left : 사각형의 윗변이 가장 낮아지는 위치를 고릅니다.
+bool	TextureAtlas::findPosition(const Page& page, int width, int height, size_t& node, int& x, int& y) const
+{
+	int		bestTop = PAGE_SIZE + 1, bestWidth = PAGE_SIZE + 1;
+	bool	found = false;
+
+	for (size_t i = 0; i < page.skyline.size(); i++)
+	{
+		int	left = page.skyline[i].x;
+		if (left + width > PAGE_SIZE)
+			break ;
+
+		int			top = 0, remaining = width;
+		size_t	j = i;
+		while (remaining > 0 && j < page.skyline.size())
+		{
+			top = std::max(top, page.skyline[j].y);
+			remaining -= page.skyline[j].width;
+			j++;
+		}
+		if (top + height > PAGE_SIZE)
+			continue ;
+		if (top + height < bestTop || (top + height == bestTop && page.skyline[i].width < bestWidth))
+		{
+			bestTop = top + height;
+			bestWidth = page.skyline[i].width;
+			node = i;
+			x = left;
+			y = top;
+			found = true;
+		}
+	}
+	return found;
+}
+
+void	TextureAtlas::addSkylineLevel(Page& page, size_t node, int x, int y, int width, int height)
+{
+	SkylineNode	level = {x, y + height, width};
+	page.skyline.insert(page.skyline.begin() + node, level);
+
+	// 새 level 에 가려지는 node 들을 줄이거나 지웁니다.
+	for (size_t i = node + 1; i < page.skyline.size();)
+	{
+		const SkylineNode&	prev = page.skyline[i - 1];
+		int									overlap = prev.x + prev.width - page.skyline[i].x;
+		if (overlap <= 0)
+			break ;
+		page.skyline[i].x += overlap;
+		page.skyline[i].width -= overlap;
+		if (page.skyline[i].width > 0)
+			break ;
+		page.skyline.erase(page.skyline.begin() + i);
+	}
+
+	// 같은 높이의 이웃 node 를 합칩니다.
+	for (size_t i = 0; i + 1 < page.skyline.size();)
+	{
+		if (page.skyline[i].y == page.skyline[i + 1].y)
+		{
+			page.skyline[i].width += page.skyline[i + 1].width;
+			page.skyline.erase(page.skyline.begin() + i + 1);
+		}
+		else
+			i++;
+	}
+}
+
+void	TextureAtlas::addPage()
+{
+	Page					page;
+	SkylineNode		root = {0, 0, PAGE_SIZE};
+	TextureCache&	cache = TextureCache::getInstance();
+
+	page.skyline.push_back(root);
+	glGenTextures(1, &page.bumpTextureID);
+	glGenTextures(1, &page.diffTextureID);
+
+	unsigned int	ids[2] = {page.bumpTextureID, page.diffTextureID};
+	for (unsigned int slot = 0; slot < 2; slot++)
+	{
+		cache.bind(slot, ids[slot]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PAGE_SIZE, PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		// atlas 가 page 의 참조 하나를 계속 가지고 있습니다. page 는 예산에서 내리지 않습니다.
+		cache.adopt(ids[slot]);
+		TextureResidency::getInstance().pin(ids[slot], PAGE_SIZE * PAGE_SIZE * 4);
+	}
+	_pages.push_back(page);
+}
+
+// 가장자리 texel 을 PADDING 만큼 복제해서 이웃 영역이 번지지 않게 합니다.
+void	TextureAtlas::uploadPadded(unsigned int textureID, unsigned int slot, int x, int y,
+									const std::vector<unsigned char>& rgba, int width, int height) const
+{
+	int													paddedWidth = width + 2 * PADDING;
+	int													paddedHeight = height + 2 * PADDING;
+	std::vector<unsigned char>	padded(paddedWidth * paddedHeight * 4);
+
+	for (int py = 0; py < paddedHeight; py++)
+	{
+		int	sy = std::min(std::max(py - PADDING, 0), height - 1);
+		for (int px = 0; px < paddedWidth; px++)
+		{
+			int	sx = std::min(std::max(px - PADDING, 0), width - 1);
+			std::memcpy(&padded[(py * paddedWidth + px) * 4], &rgba[(sy * width + sx) * 4], 4);
+		}
+	}
+	TextureCache::getInstance().bind(slot, textureID);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+}
+
+void	TextureAtlas::loadImage(const std::string& path, unsigned int slot, std::vector<unsigned char>& rgba,
+								unsigned int& width, unsigned int& height)
+{
+	std::vector<unsigned char>	file;
+	TextureCache::readFile(path, file);
+	if (slot == TEXTURE_SLOT_BUMP)
+		loadNormalMap(path, file, TextureCache::hashContent(file), rgba, width, height);
+	else
+		TextureCache::decodeImage(path, file, rgba, width, height);
+}
@@ -0,0 +1,65 @@
+#ifndef __TEXTUREATLAS_HPP__
+# define __TEXTUREATLAS_HPP__
+
+#include <glad/glad.h> // include glad to get the required OpenGL headers
+
+# include <vector>
+# include <string>
+# include <map>
+# include <fstream>
+
+# include "TextureCache.hpp"
+
+// atlas 안에서 한 object 가 차지하는 영역. uv' = uv * scale + offset
+struct	AtlasRegion {
+	unsigned int	bumpTextureID;
+	unsigned int	diffTextureID;
+	float					uvOffset[2];
+	float					uvScale[2];
+};
+
+// 작은 텍스처들을 공유 atlas page 에 모아서 object 마다 텍스처를 다시 바인딩하지 않게 합니다.
+// page 는 배치가 같은 (bump, diffuse) 텍스처 쌍이고, 사각형은 skyline 으로 놓고 둘레를 가장자리 texel 로 채웁니다.
+class TextureAtlas
+{
+	private:
+		struct	SkylineNode {
+			int	x;
+			int	y;
+			int	width;
+		};
+
+		struct	Page {
+			unsigned int							bumpTextureID;
+			unsigned int							diffTextureID;
+			std::vector<SkylineNode>	skyline;
+		};
+
+		std::vector<Page>															_pages;
+		std::map<std::pair<std::string, std::string>, AtlasRegion>	_regions;
+
+		TextureAtlas();
+		TextureAtlas(const TextureAtlas&);
+		TextureAtlas&	operator=(const TextureAtlas&);
+
+		bool				allocate(int width, int height, unsigned int& page, int& x, int& y);
+		bool				findPosition(const Page& page, int width, int height, size_t& node, int& x, int& y) const;
+		void				addSkylineLevel(Page& page, size_t node, int x, int y, int width, int height);
+		void				addPage();
+		void				uploadPadded(unsigned int textureID, unsigned int slot, int x, int y,
+										const std::vector<unsigned char>& rgba, int width, int height) const;
+		static void	loadImage(const std::string& path, unsigned int slot, std::vector<unsigned char>& rgba,
+										unsigned int& width, unsigned int& height);
+
+	public:
+		static const int	PAGE_SIZE = 1024;
+		static const int	PADDING = 2;
+		static const int	MAX_TEXTURE_SIZE = 256;
+
+		static TextureAtlas&	getInstance();
+
+		// 빈 경로는 기본 회색 텍스처를 뜻하고, 둘 다 비면 page 대신 1x1 dummy 를 줍니다. 텍스처가 너무 크면 false.
+		bool	insert(const std::string& bumpPath, const std::string& diffPath, AtlasRegion& region);
+};
+
+#endif
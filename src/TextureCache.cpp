@@ -0,0 +1,274 @@
+#include "TextureCache.hpp"
+#include "TextureStreamer.hpp"
+#include "TextureResidency.hpp"
+
+TextureCache::TextureCache() : _compress(true), _quality(BC_QUALITY_NORMAL), _s3tcSupported(-1),
+_activeUnit(0)
+{
+	for (int i = 0; i < TEXTURE_SLOT_COUNT; i++)
+	{
+		_bound[i] = 0;
+		_dummyID[i] = 0;
+	}
+}
+
+TextureCache&	TextureCache::getInstance()
+{
+	static TextureCache	instance;
+	return instance;
+}
+
+void	TextureCache::setCompression(bool enabled, BCQuality quality)
+{
+	_compress = enabled;
+	_quality = quality;
+}
+
+// FNV-1a 64bit
+unsigned long long	TextureCache::hashContent(const std::vector<unsigned char>& data)
+{
+	unsigned long long	hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+bool	TextureCache::useCompression(BCFormat format)
+{
+	if (!_compress)
+		return false;
+	// BC5 (RGTC) 는 3.0 core, BC1 / BC3 (S3TC) 는 확장입니다.
+	if (format == BC_FORMAT_BC5)
+		return true;
+	if (_s3tcSupported < 0)
+	{
+		GLint	count = 0;
+		_s3tcSupported = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++)
+		{
+			const char*	name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (name && !std::strcmp(name, "GL_EXT_texture_compression_s3tc"))
+				_s3tcSupported = 1;
+		}
+	}
+	return _s3tcSupported == 1;
+}
+
+unsigned int	TextureCache::acquire(const std::string& path, unsigned int slot)
+{
+	// 1. 같은 경로로 이미 로드된 텍스처
+	std::map<PathKey, unsigned int>::iterator	pathIt = _byPath.find(PathKey(path, slot));
+	if (pathIt != _byPath.end())
+	{
+		_entries[pathIt->second].refCount++;
+		return pathIt->second;
+	}
+
+	std::vector<unsigned char>	file;
+	readFile(path, file);
+
+	// 2. 경로는 다르지만 내용이 같은 텍스처
+	unsigned long long	hash = hashContent(file);
+	std::map<HashKey, unsigned int>::iterator	hashIt = _byHash.find(HashKey(hash, slot));
+	if (hashIt != _byHash.end())
+	{
+		_entries[hashIt->second].refCount++;
+		_byPath[PathKey(path, slot)] = hashIt->second;
+		return hashIt->second;
+	}
+
+	// 3. 새 텍스처 : placeholder 로 만들고 디코딩 / 업로드는 TextureStreamer 에 맡깁니다.
+	unsigned int	textureID;
+	glGenTextures(1, &textureID);
+	bind(slot, textureID);
+	uploadPlaceholder(slot);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+	BCFormat				format = slot == TEXTURE_SLOT_BUMP ? BC_FORMAT_BC5 : BC_FORMAT_BC1;
+	TextureRequest	request;
+	request.textureID = textureID;
+	request.slot = slot;
+	request.path = path;
+	request.file.swap(file);
+	request.hash = hash;
+	request.format = format;
+	request.quality = _quality;
+	request.compress = useCompression(format);
+	request.firstLevel = 0;
+	request.lastLevel = -1;
+	TextureResidency::getInstance().track(request);
+	TextureStreamer::getInstance().request(request);
+
+	Entry					entry = {1, PathKey(path, slot), HashKey(hash, slot)};
+	_entries[textureID] = entry;
+	_byPath[entry.path] = textureID;
+	_byHash[entry.hash] = textureID;
+	return textureID;
+}
+
+unsigned int	TextureCache::acquireDummy(unsigned int slot)
+{
+	// bump 와 diffuse 의 dummy 는 내용이 다르므로 slot 마다 하나씩 둡니다.
+	unsigned int&	dummyID = _dummyID[slot];
+	if (dummyID)
+	{
+		_entries[dummyID].refCount++;
+		return dummyID;
+	}
+
+	glGenTextures(1, &dummyID);
+	bind(slot, dummyID);
+	uploadPlaceholder(slot);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	Entry	entry = {1, PathKey("", slot), HashKey(0, slot)};
+	_entries[dummyID] = entry;
+	return dummyID;
+}
+
+// 캐시 밖에서 만든 텍스처 (atlas page 등) 를 참조 카운트 관리 대상으로 등록합니다.
+void	TextureCache::adopt(unsigned int textureID)
+{
+	Entry	entry = {1, PathKey("", 0), HashKey(0, 0)};
+	_entries[textureID] = entry;
+}
+
+void	TextureCache::retain(unsigned int textureID)
+{
+	std::map<unsigned int, Entry>::iterator	it = _entries.find(textureID);
+	if (it != _entries.end())
+		it->second.refCount++;
+}
+
+void	TextureCache::release(unsigned int textureID)
+{
+	std::map<unsigned int, Entry>::iterator	it = _entries.find(textureID);
+	if (textureID == 0 || it == _entries.end())
+		return ;
+	if (--it->second.refCount > 0)
+		return ;
+
+	if (_dummyID[it->second.path.second % TEXTURE_SLOT_COUNT] == textureID)
+		_dummyID[it->second.path.second % TEXTURE_SLOT_COUNT] = 0;
+	else if (!it->second.path.first.empty())
+	{
+		for (std::map<PathKey, unsigned int>::iterator pathIt = _byPath.begin(); pathIt != _byPath.end();)
+		{
+			if (pathIt->second == textureID)
+				_byPath.erase(pathIt++);
+			else
+				++pathIt;
+		}
+		_byHash.erase(it->second.hash);
+	}
+	_entries.erase(it);
+	TextureStreamer::getInstance().cancel(textureID);
+	TextureResidency::getInstance().forget(textureID);
+	for (int i = 0; i < TEXTURE_SLOT_COUNT; i++)
+		if (_bound[i] == textureID)
+			_bound[i] = 0;
+	glDeleteTextures(1, &textureID);
+}
+
+// 이미 같은 텍스처가 바인딩되어 있으면 상태 변경을 건너뜁니다.
+void	TextureCache::bind(unsigned int slot, unsigned int textureID)
+{
+	if (slot < TEXTURE_SLOT_COUNT && _bound[slot] == textureID)
+		return ;
+	if (_activeUnit != slot)
+	{
+		glActiveTexture(GL_TEXTURE0 + slot);
+		_activeUnit = slot;
+	}
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	if (slot < TEXTURE_SLOT_COUNT)
+		_bound[slot] = textureID;
+}
+
+// diffuse 는 회색, bump 는 평평한 노멀 (0, 0, 1) 입니다.
+void	TextureCache::placeholderPixel(unsigned int slot, unsigned char pixel[4])
+{
+	unsigned char	grayPixel[] = {178, 178, 178, 255};
+	unsigned char	flatNormal[] = {128, 128, 255, 255};
+	std::memcpy(pixel, slot == TEXTURE_SLOT_BUMP ? flatNormal : grayPixel, 4);
+}
+
+// 현재 바인딩된 텍스처의 level 0 을 1x1 placeholder 로 채웁니다.
+void	TextureCache::uploadPlaceholder(unsigned int slot)
+{
+	unsigned char	pixel[4];
+	placeholderPixel(slot, pixel);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+}
+
+void	TextureCache::readFile(const std::string& path, std::vector<unsigned char>& file)
+{
+	std::ifstream	ImageFile(path, std::ios::binary);
+	if (!ImageFile.is_open())
+		throw std::runtime_error(isJPEG(path) ? "ERROR::LOADER::JPEG::FILE_OPEN_FAIL\nfailed to open file."
+			: "ERROR::LOADER::BMP::FILE_OPEN_FAIL\nfailed to open file.");
+	file.assign(std::istreambuf_iterator<char>(ImageFile), std::istreambuf_iterator<char>());
+}
+
+bool	TextureCache::isJPEG(const std::string& path)
+{
+	std::string::size_type	extention = path.find_last_of(".");
+	if (extention == std::string::npos)
+		return false;
+	std::string	ext = path.substr(extention + 1);
+	return ext == "jpg" || ext == "jpeg";
+}
+
+// 확장자에 따라 BMP / JPEG 디코더를 고릅니다. 결과는 둘 다 아래쪽 행부터 저장된 RGBA 입니다.
+void	TextureCache::decodeImage(const std::string& path, const std::vector<unsigned char>& file,
+									std::vector<unsigned char>& rgba, unsigned int& width, unsigned int& height)
+{
+	if (isJPEG(path))
+		decodeJPEG(file, rgba, width, height);
+	else
+		decodeBMP(file, rgba, width, height);
+}
+
+// 헤더만 읽어서 크기를 알아냅니다. 큰 텍스처를 디코딩하지 않고 atlas / 가상 텍스처 여부를 정할 때 씁니다.
+bool	TextureCache::readImageSize(const std::string& path, unsigned int& width, unsigned int& height)
+{
+	if (isJPEG(path))
+	{
+		// SOF 는 보통 파일 앞쪽에 있으므로 앞부분만 읽어서 찾습니다.
+		std::ifstream								jpeg(path, std::ios::binary);
+		std::vector<unsigned char>	head(JPEG_PEEK_BYTES);
+		if (!jpeg.is_open())
+			return false;
+		jpeg.read(reinterpret_cast<char*>(head.data()), head.size());
+		head.resize(jpeg.gcount());
+		return readJPEGSize(head, width, height);
+	}
+
+	std::ifstream								file(path, std::ios::binary);
+	std::vector<unsigned char>	header(BMP_HEADER_BYTES);
+	BMPInfo											info;
+
+	if (!file.is_open())
+		return false;
+	file.read(reinterpret_cast<char*>(header.data()), header.size());
+	try
+	{
+		readBMPInfo(header.data(), file.gcount(), info);
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+	width = info.width;
+	height = info.height;
+	return true;
+}
@@ -0,0 +1,88 @@
+#ifndef __TEXTURECACHE_HPP__
+# define __TEXTURECACHE_HPP__
+
+#include <glad/glad.h> // include glad to get the required OpenGL headers
+
+# include <vector>
+# include <string>
+# include <map>
+# include <fstream>
+# include <iterator>
+# include <stdexcept>
+# include <cstring>
+
+# include "BCEncoder.hpp"
+# include "JpegDecoder.hpp"
+# include "BmpDecoder.hpp"
+
+// glad 는 core 3.3 만 생성했으므로 S3TC 확장 상수는 직접 정의합니다.
+# ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#  define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+# endif
+# ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#  define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+# endif
+
+// Object 가 사용하는 texture unit
+enum	TextureSlot {
+	TEXTURE_SLOT_BUMP = 0,
+	TEXTURE_SLOT_DIFFUSE = 1,
+	TEXTURE_SLOT_VIRTUAL_PAGES = 2,
+	TEXTURE_SLOT_VIRTUAL_INDIRECTION = 3,
+	TEXTURE_SLOT_COUNT
+};
+
+// 텍스처 캐시 : 같은 파일(경로 또는 내용이 같은 파일)은 한 번만 디코딩 / 업로드하고 참조 수로 공유합니다. (1x1 dummy 도)
+// 새 텍스처는 placeholder (회색, bump map 은 평평한 노멀) 로 시작하고 TextureStreamer 가 채웁니다. (압축하면 BC1 / BC5)
+class TextureCache
+{
+	private:
+		typedef std::pair<std::string, unsigned int>				PathKey;
+		typedef std::pair<unsigned long long, unsigned int>	HashKey;
+
+		struct	Entry {
+			unsigned int				refCount;
+			PathKey							path;
+			HashKey							hash;
+		};
+
+		std::map<PathKey, unsigned int>	_byPath;
+		std::map<HashKey, unsigned int>	_byHash;
+		std::map<unsigned int, Entry>		_entries;
+		unsigned int										_dummyID[TEXTURE_SLOT_COUNT];
+		bool														_compress;
+		BCQuality												_quality;
+		int															_s3tcSupported;
+		unsigned int										_activeUnit;
+		unsigned int										_bound[TEXTURE_SLOT_COUNT];
+
+		TextureCache();
+		TextureCache(const TextureCache&);
+		TextureCache&	operator=(const TextureCache&);
+
+		bool								useCompression(BCFormat format);
+
+	public:
+		static const int	JPEG_PEEK_BYTES = 64 * 1024;
+
+		static TextureCache&	getInstance();
+
+		void					setCompression(bool enabled, BCQuality quality);
+		unsigned int	acquire(const std::string& path, unsigned int slot);
+		unsigned int	acquireDummy(unsigned int slot);
+		void					adopt(unsigned int textureID);
+		void					retain(unsigned int textureID);
+		void					release(unsigned int textureID);
+		void					bind(unsigned int slot, unsigned int textureID);
+
+		static void		uploadPlaceholder(unsigned int slot);
+		static void		placeholderPixel(unsigned int slot, unsigned char pixel[4]);
+		static unsigned long long	hashContent(const std::vector<unsigned char>& data);
+		static void		readFile(const std::string& path, std::vector<unsigned char>& file);
+		static bool		isJPEG(const std::string& path);
+		static bool		readImageSize(const std::string& path, unsigned int& width, unsigned int& height);
+		static void		decodeImage(const std::string& path, const std::vector<unsigned char>& file,
+										std::vector<unsigned char>& rgba, unsigned int& width, unsigned int& height);
+};
+
+#endif
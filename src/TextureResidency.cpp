@@ -0,0 +1,194 @@
+#include "TextureResidency.hpp"
+
+TextureResidency::TextureResidency() : _frame(0), _budget(DEFAULT_BUDGET), _residentBytes(0), _pinnedBytes(0),
+_evictedLevels(0), _restreamCount(0)
+{
+}
+
+TextureResidency&	TextureResidency::getInstance()
+{
+	static TextureResidency	instance;
+	return instance;
+}
+
+void	TextureResidency::setBudget(size_t bytes)
+{
+	_budget = bytes;
+}
+
+// TextureCache 가 스트리밍을 요청할 때 등록합니다.
+void	TextureResidency::track(const TextureRequest& request)
+{
+	Resident	texture;
+	texture.source.textureID = request.textureID;
+	texture.source.slot = request.slot;
+	texture.source.path = request.path;
+	texture.source.hash = request.hash;
+	texture.source.format = request.format;
+	texture.source.quality = request.quality;
+	texture.source.compress = request.compress;
+	texture.source.firstLevel = 0;
+	texture.source.lastLevel = -1;
+	texture.baseLevel = 0;
+	texture.lastUsed = _frame;
+	_textures[request.textureID] = texture;
+}
+
+void	TextureResidency::pin(unsigned int textureID, size_t bytes)
+{
+	_pinnedBytes += bytes - _pinned[textureID];
+	_residentBytes += bytes - _pinned[textureID];
+	_pinned[textureID] = bytes;
+}
+
+void	TextureResidency::forget(unsigned int textureID)
+{
+	std::map<unsigned int, size_t>::iterator	pinned = _pinned.find(textureID);
+	if (pinned != _pinned.end())
+	{
+		_pinnedBytes -= pinned->second;
+		_residentBytes -= pinned->second;
+		_pinned.erase(pinned);
+		return ;
+	}
+
+	std::map<unsigned int, Resident>::iterator	it = _textures.find(textureID);
+	if (it == _textures.end())
+		return ;
+	for (size_t level = it->second.baseLevel; level < it->second.levelBytes.size(); level++)
+		_residentBytes -= it->second.levelBytes[level];
+	_textures.erase(it);
+}
+
+void	TextureResidency::touch(unsigned int textureID)
+{
+	std::map<unsigned int, Resident>::iterator	it = _textures.find(textureID);
+	if (it != _textures.end())
+		it->second.lastUsed = _frame;
+}
+
+// TextureStreamer 가 level 하나를 올릴 때마다 호출합니다. level 은 작은 것부터 올라옵니다.
+void	TextureResidency::onLevelUploaded(unsigned int textureID, int level, int levelCount, size_t bytes)
+{
+	std::map<unsigned int, Resident>::iterator	it = _textures.find(textureID);
+	if (it == _textures.end())
+		return ;
+
+	Resident&	texture = it->second;
+	if (texture.levelBytes.empty())
+	{
+		texture.levelBytes.assign(levelCount, 0);
+		texture.baseLevel = levelCount;
+	}
+	_residentBytes += bytes - texture.levelBytes[level] * (level >= texture.baseLevel);
+	texture.levelBytes[level] = bytes;
+	texture.baseLevel = std::min(texture.baseLevel, level);
+}
+
+size_t	TextureResidency::missingBytes(const Resident& texture, int level) const
+{
+	size_t	bytes = 0;
+	for (int i = level; i < texture.baseLevel; i++)
+		bytes += texture.levelBytes[i];
+	return bytes;
+}
+
+// 조건에 맞는 텍스처 중 가장 오래 쓰이지 않은 (같으면 가장 큰 level 을 가진) 텍스처의 level 하나를 내립니다.
+bool	TextureResidency::evictOne(unsigned long long usedBefore, unsigned int keep)
+{
+	TextureStreamer&														streamer = TextureStreamer::getInstance();
+	std::map<unsigned int, Resident>::iterator	victim = _textures.end();
+
+	for (std::map<unsigned int, Resident>::iterator it = _textures.begin(); it != _textures.end(); ++it)
+	{
+		const Resident&	texture = it->second;
+		if (it->first == keep || texture.lastUsed >= usedBefore || streamer.isStreaming(it->first)
+			|| texture.levelBytes.empty() || texture.baseLevel + 1 >= static_cast<int>(texture.levelBytes.size()))
+			continue ;
+		if (victim == _textures.end() || texture.lastUsed < victim->second.lastUsed
+			|| (texture.lastUsed == victim->second.lastUsed
+				&& texture.levelBytes[texture.baseLevel] > victim->second.levelBytes[victim->second.baseLevel]))
+			victim = it;
+	}
+	if (victim == _textures.end())
+		return false;
+
+	Resident&	texture = victim->second;
+	int				level = texture.baseLevel;
+	TextureCache::getInstance().bind(texture.source.slot, victim->first);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+	// 0x0 으로 다시 지정해서 driver 가 메모리를 돌려받게 합니다. (BASE_LEVEL 밖이라 완전성에 영향 없음)
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	_residentBytes -= texture.levelBytes[level];
+	texture.baseLevel++;
+	_evictedLevels++;
+	return true;
+}
+
+void	TextureResidency::restream(unsigned int textureID, Resident& texture)
+{
+	// 직전 프레임에 그려지지 않은 텍스처에서 돌려받을 수 있는 양 (각자 가장 작은 level 은 남깁니다)
+	TextureStreamer&	streamer = TextureStreamer::getInstance();
+	size_t						reclaimable = 0;
+	for (std::map<unsigned int, Resident>::const_iterator it = _textures.begin(); it != _textures.end(); ++it)
+	{
+		const Resident&	other = it->second;
+		if (it->first == textureID || other.lastUsed >= _frame || other.levelBytes.empty() || streamer.isStreaming(it->first))
+			continue ;
+		for (size_t level = other.baseLevel; level + 1 < other.levelBytes.size(); level++)
+			reclaimable += other.levelBytes[level];
+	}
+
+	// 예산 안에 들어오는 가장 큰 level 까지만 다시 올립니다.
+	int	level = 0;
+	while (level < texture.baseLevel && _residentBytes - reclaimable + missingBytes(texture, level) > _budget)
+		level++;
+	if (level >= texture.baseLevel)
+		return ;
+	while (_residentBytes + missingBytes(texture, level) > _budget && evictOne(_frame, textureID))
+		;
+
+	TextureRequest	request = texture.source;
+	request.firstLevel = level;
+	request.lastLevel = texture.baseLevel - 1;
+	streamer.request(request);
+	_restreamCount++;
+}
+
+// GL 스레드에서 프레임마다, 그리기 전에 호출합니다.
+// 직전 프레임에 그려진 텍스처 중 줄어든 것은 다시 올리고, 예산을 넘으면 오래된 것부터 내립니다.
+void	TextureResidency::update()
+{
+	TextureStreamer&	streamer = TextureStreamer::getInstance();
+
+	for (std::map<unsigned int, Resident>::iterator it = _textures.begin(); it != _textures.end(); ++it)
+	{
+		if (it->second.lastUsed == _frame && it->second.baseLevel > 0 && !it->second.levelBytes.empty()
+			&& !streamer.isStreaming(it->first))
+			restream(it->first, it->second);
+	}
+	while (_residentBytes > _budget && evictOne(_frame + 1, 0))
+		;
+	_frame++;
+}
+
+ResidencyStats	TextureResidency::getStats() const
+{
+	ResidencyStats	stats = {_budget, _residentBytes, _pinnedBytes,
+								static_cast<unsigned int>(_textures.size() + _pinned.size()), 0, _evictedLevels, _restreamCount};
+
+	for (std::map<unsigned int, Resident>::const_iterator it = _textures.begin(); it != _textures.end(); ++it)
+		if (it->second.baseLevel > 0)
+			stats.reducedCount++;
+	return stats;
+}
+
+void	TextureResidency::printStats(std::ostream& out) const
+{
+	ResidencyStats	stats = getStats();
+
+	out << "texture memory : " << stats.residentBytes / 1024 << " / " << stats.budget / 1024 << " KiB"
+		<< " (pinned " << stats.pinnedBytes / 1024 << " KiB), "
+		<< stats.textureCount << " textures, " << stats.reducedCount << " reduced, "
+		<< stats.evictedLevels << " levels evicted, " << stats.restreamCount << " restreamed" << std::endl;
+}
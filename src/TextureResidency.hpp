@@ -0,0 +1,70 @@
+#ifndef __TEXTURERESIDENCY_HPP__
+# define __TEXTURERESIDENCY_HPP__
+
+#include <glad/glad.h> // include glad to get the required OpenGL headers
+
+# include <vector>
+# include <map>
+# include <string>
+# include <iostream>
+
+# include "TextureStreamer.hpp"
+
+// 텍스처 상주 통계
+struct	ResidencyStats {
+	size_t				budget;
+	size_t				residentBytes;	// 스트리밍된 텍스처 + pinned
+	size_t				pinnedBytes;		// atlas page 등 내릴 수 없는 텍스처
+	unsigned int	textureCount;
+	unsigned int	reducedCount;		// 가장 큰 level 이 내려가 있는 텍스처 수
+	unsigned int	evictedLevels;		// 지금까지 내린 level 수
+	unsigned int	restreamCount;	// 지금까지 다시 요청한 횟수
+};
+
+// GPU 텍스처 메모리 예산 : 마지막으로 그려진 프레임을 텍스처마다 기록하고,
+// 예산을 넘으면 가장 오래 쓰이지 않은 텍스처의 가장 큰 mip 부터 내립니다.
+// 가장 작은 level 은 남기므로 흐려질 뿐 사라지지 않고, 다시 그려지면 빠진 level 을 TextureStreamer 에 다시 요청합니다.
+class TextureResidency
+{
+	private:
+		struct	Resident {
+			TextureRequest			source;				// 다시 스트리밍할 때 사용 (file 은 비워 둡니다)
+			std::vector<size_t>	levelBytes;
+			int									baseLevel;		// 올라와 있는 가장 큰 level, levelBytes.size() 면 placeholder 뿐
+			unsigned long long	lastUsed;
+		};
+
+		std::map<unsigned int, Resident>	_textures;
+		std::map<unsigned int, size_t>		_pinned;
+		unsigned long long								_frame;
+		size_t														_budget;
+		size_t														_residentBytes;
+		size_t														_pinnedBytes;
+		unsigned int											_evictedLevels;
+		unsigned int											_restreamCount;
+
+		TextureResidency();
+		TextureResidency(const TextureResidency&);
+		TextureResidency&	operator=(const TextureResidency&);
+
+		bool		evictOne(unsigned long long usedBefore, unsigned int keep);
+		void		restream(unsigned int textureID, Resident& texture);
+		size_t	missingBytes(const Resident& texture, int level) const;
+
+	public:
+		static const size_t	DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+		static TextureResidency&	getInstance();
+
+		void						setBudget(size_t bytes);
+		void						track(const TextureRequest& request);
+		void						pin(unsigned int textureID, size_t bytes);
+		void						forget(unsigned int textureID);
+		void						touch(unsigned int textureID);
+		void						onLevelUploaded(unsigned int textureID, int level, int levelCount, size_t bytes);
+		void						update();
+		ResidencyStats	getStats() const;
+		void						printStats(std::ostream& out) const;
+};
+
+#endif
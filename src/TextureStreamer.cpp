@@ -0,0 +1,534 @@
+#include "TextureStreamer.hpp"
+#include "TextureResidency.hpp"
+#include "NormalMap.hpp"
+
+namespace
+{
+	// 디스크 캐시 (KTX2) 의 형식과 파일 이름 : <file>.bc1.ktx2 / .bc3.ktx2 / .bc5.ktx2, 압축하지 않으면 .rgba.ktx2
+	const unsigned int	KTX2_CACHE_VERSION = 1;
+
+	unsigned int	cacheFormat(const TextureRequest& request)
+	{
+		if (!request.compress)
+			return VK_FORMAT_R8G8B8A8_UNORM;
+		switch (request.format)
+		{
+			case BC_FORMAT_BC1:
+				return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+			case BC_FORMAT_BC3:
+				return VK_FORMAT_BC3_UNORM_BLOCK;
+			default:
+				return VK_FORMAT_BC5_UNORM_BLOCK;
+		}
+	}
+
+	std::string	cachePath(const TextureRequest& request)
+	{
+		if (!request.compress)
+			return request.path + (request.slot == TEXTURE_SLOT_BUMP ? ".normal.ktx2" : ".rgba.ktx2");
+		switch (request.format)
+		{
+			case BC_FORMAT_BC1:
+				return request.path + ".bc1.ktx2";
+			case BC_FORMAT_BC3:
+				return request.path + ".bc3.ktx2";
+			default:
+				return request.path + ".bc5.ktx2";
+		}
+	}
+
+	// 원본 hash 와 인코더 설정 : 하나라도 다르면 캐시를 다시 만듭니다.
+	std::string	cacheSource(const TextureRequest& request)
+	{
+		char	source[96];
+		std::snprintf(source, sizeof(source), "hash=%016llx quality=%u version=%u", request.hash,
+			request.compress ? static_cast<unsigned int>(request.quality) : 0u, KTX2_CACHE_VERSION);
+		return source;
+	}
+
+	GLenum	compressedFormat(BCFormat format)
+	{
+		switch (format)
+		{
+			case BC_FORMAT_BC1:
+				return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			case BC_FORMAT_BC3:
+				return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			default:
+				return GL_COMPRESSED_RG_RGTC2;
+		}
+	}
+
+	unsigned int	mipLevelCount(unsigned int width, unsigned int height)
+	{
+		unsigned int	count = 1;
+		while (width > 1 || height > 1)
+		{
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+			count++;
+		}
+		return count;
+	}
+
+	// 2x2 box filter, 홀수 크기는 마지막 행 / 열을 복제합니다.
+	void	downsample(const std::vector<unsigned char>& src, unsigned int width, unsigned int height,
+					std::vector<unsigned char>& dst, unsigned int dstWidth, unsigned int dstHeight)
+	{
+		dst.resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+		for (unsigned int y = 0; y < dstHeight; y++)
+		{
+			unsigned int	y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				unsigned int	x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					unsigned int	sum = src[(static_cast<size_t>(y0) * width + x0) * 4 + c] + src[(static_cast<size_t>(y0) * width + x1) * 4 + c]
+										+ src[(static_cast<size_t>(y1) * width + x0) * 4 + c] + src[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+					dst[(static_cast<size_t>(y) * dstWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+TextureStreamer::TextureStreamer() : _activeTicket(0), _stop(false), _stagingWanted(0), _nextTicket(1),
+_budget(DEFAULT_UPLOAD_BUDGET)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+	if (_worker.joinable())
+		_worker.join();
+}
+
+TextureStreamer&	TextureStreamer::getInstance()
+{
+	static TextureStreamer	instance;
+	return instance;
+}
+
+void	TextureStreamer::setUploadBudget(size_t bytes)
+{
+	_budget = bytes;
+}
+
+bool	TextureStreamer::isStreaming(unsigned int textureID) const
+{
+	return _tickets.count(textureID) != 0;
+}
+
+void	TextureStreamer::request(TextureRequest& request)
+{
+	unsigned int	ticket = _nextTicket++;
+
+	if (_staging.empty())
+		createStaging();
+	_tickets[request.textureID] = ticket;
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_pending.push_back(std::make_pair(ticket, TextureRequest()));
+		std::swap(_pending.back().second, request);
+		if (!_worker.joinable())
+			_worker = std::thread(&TextureStreamer::workerLoop, this);
+	}
+	_condition.notify_one();
+}
+
+// 텍스처가 스트리밍 도중에 삭제되면 남은 작업을 버립니다.
+// GL 이 같은 이름을 다시 쓸 수 있으므로 textureID 대신 ticket 으로 구분합니다.
+// 이미 staging 된 level 은 ticket 이 _tickets 에 없으므로 update() 가 올리지 않고 버립니다.
+void	TextureStreamer::cancel(unsigned int textureID)
+{
+	std::map<unsigned int, unsigned int>::iterator	it = _tickets.find(textureID);
+	if (it == _tickets.end())
+		return ;
+
+	unsigned int	ticket = it->second;
+	_tickets.erase(it);
+
+	std::lock_guard<std::mutex>	lock(_mutex);
+	for (std::deque<std::pair<unsigned int, TextureRequest> >::iterator pend = _pending.begin(); pend != _pending.end(); ++pend)
+	{
+		if (pend->first == ticket)
+		{
+			_pending.erase(pend);
+			return ;
+		}
+	}
+	if (_activeTicket == ticket)
+		_cancelled.insert(ticket);
+}
+
+void	TextureStreamer::workerLoop()
+{
+	while (true)
+	{
+		std::pair<unsigned int, TextureRequest>	job;
+		{
+			std::unique_lock<std::mutex>	lock(_mutex);
+			_condition.wait(lock, [this] { return _stop || !_pending.empty(); });
+			if (_stop)
+				return ;
+			std::swap(job, _pending.front());
+			_pending.pop_front();
+			_activeTicket = job.first;
+		}
+
+		StreamedTexture	texture;
+		texture.ticket = job.first;
+		texture.textureID = job.second.textureID;
+		texture.slot = job.second.slot;
+		texture.compress = job.second.compress;
+		texture.format = job.second.format;
+		std::string	error;
+		try
+		{
+			decode(job.second, texture);
+		}
+		catch (const std::exception& e)
+		{
+			error = e.what();
+		}
+
+		if (error.empty())
+			stage(job.first, job.second, texture);
+		else
+		{
+			StagedLevel	failed = {job.first, texture.textureID, texture.slot, texture.compress, texture.format,
+										0, 0, 0, 0, 0, -1, true, error};
+			std::lock_guard<std::mutex>	lock(_mutex);
+			_staged.push_back(failed);
+		}
+
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_cancelled.erase(job.first);
+		_activeTicket = 0;
+		if (_stop)
+			return ;
+	}
+}
+
+// 작은 level 부터 staging 버퍼에 씁니다. 다시 스트리밍할 때는 이미 올라와 있는 level 을 건너뜁니다.
+void	TextureStreamer::stage(unsigned int ticket, const TextureRequest& request, StreamedTexture& texture)
+{
+	int	lastLevel = static_cast<int>(texture.levels.size()) - 1;
+	if (request.lastLevel >= 0 && request.lastLevel < lastLevel)
+		lastLevel = request.lastLevel;
+
+	StagedLevel	staged = {ticket, texture.textureID, texture.slot, texture.compress, texture.format,
+								0, static_cast<unsigned int>(texture.levels.size()), 0, 0, 0, -1, true, ""};
+	for (int level = lastLevel; level >= request.firstLevel; level--)
+	{
+		MipLevel&	mip = texture.levels[level];
+		{
+			std::lock_guard<std::mutex>	lock(_mutex);
+			if (_cancelled.count(ticket))
+				return ;
+		}
+		int	index = acquireStaging(mip.size);
+		if (index < 0)
+			return ;
+		std::memcpy(_staging[index].memory, mip.pixels, mip.size);
+
+		staged.level = level;
+		staged.width = mip.width;
+		staged.height = mip.height;
+		staged.size = mip.size;
+		staged.staging = index;
+		staged.last = level == request.firstLevel;
+		std::vector<unsigned char>().swap(mip.data);
+
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_staged.push_back(staged);
+	}
+	// 올릴 level 이 없어도 GL 스레드가 스트리밍이 끝났다는 것을 알 수 있게 합니다.
+	if (staged.staging < 0)
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_staged.push_back(staged);
+	}
+}
+
+// 크기가 충분한 빈 staging 버퍼를 기다립니다. 종료 중이면 -1.
+int	TextureStreamer::acquireStaging(size_t size)
+{
+	std::unique_lock<std::mutex>	lock(_mutex);
+	while (!_stop)
+	{
+		for (std::deque<int>::iterator it = _freeStaging.begin(); it != _freeStaging.end(); ++it)
+		{
+			if (_staging[*it].capacity >= size)
+			{
+				int	index = *it;
+				_freeStaging.erase(it);
+				_stagingWanted = 0;
+				return index;
+			}
+		}
+		_stagingWanted = std::max(_stagingWanted, size);
+		_condition.wait(lock);
+	}
+	return -1;
+}
+
+void	TextureStreamer::decode(const TextureRequest& request, StreamedTexture& texture)
+{
+	std::string		path = cachePath(request), source = cacheSource(request);
+	unsigned int	vkFormat = cacheFormat(request);
+
+	// 디스크 캐시가 있으면 이미지 디코딩, mip 생성, 인코딩을 모두 건너뛰고 map 된 파일에서 바로 올립니다.
+	if (texture.cache.open(path, vkFormat, source))
+	{
+		const std::vector<Ktx2Level>&	cached = texture.cache.levels();
+		if (cached.size() == mipLevelCount(cached[0].width, cached[0].height))
+		{
+			texture.levels.resize(cached.size());
+			for (size_t i = 0; i < cached.size(); i++)
+			{
+				texture.levels[i].width = cached[i].width;
+				texture.levels[i].height = cached[i].height;
+				texture.levels[i].pixels = cached[i].data;
+				texture.levels[i].size = cached[i].size;
+			}
+			return ;
+		}
+		texture.cache.close();
+	}
+
+	// 다시 스트리밍하는 요청은 파일 내용을 들고 있지 않으므로 여기서 읽습니다.
+	std::vector<unsigned char>	reread;
+	if (request.file.empty())
+		TextureCache::readFile(request.path, reread);
+	const std::vector<unsigned char>&	file = request.file.empty() ? reread : request.file;
+
+	// bump map 은 높이 맵이면 노멀 맵으로 바꿔서 올립니다.
+	std::vector<unsigned char>	rgba;
+	unsigned int								width, height;
+	if (request.slot == TEXTURE_SLOT_BUMP)
+		loadNormalMap(request.path, file, request.hash, rgba, width, height);
+	else
+		TextureCache::decodeImage(request.path, file, rgba, width, height);
+
+	texture.levels.resize(mipLevelCount(width, height));
+	for (size_t i = 0; i < texture.levels.size(); i++)
+	{
+		MipLevel&	level = texture.levels[i];
+		level.width = width;
+		level.height = height;
+		if (request.compress)
+		{
+			level.data.resize(bcEncodedSize(width, height, request.format));
+			encodeBC(rgba.data(), width, height, request.format, request.quality, level.data.data());
+		}
+		else
+			level.data = rgba;
+		level.pixels = level.data.data();
+		level.size = level.data.size();
+
+		if (i + 1 < texture.levels.size())
+		{
+			std::vector<unsigned char>	next;
+			unsigned int								nextWidth = std::max(1u, width / 2);
+			unsigned int								nextHeight = std::max(1u, height / 2);
+			downsample(rgba, width, height, next, nextWidth, nextHeight);
+			rgba.swap(next);
+			width = nextWidth;
+			height = nextHeight;
+		}
+	}
+
+	std::vector<Ktx2Level>	levels(texture.levels.size());
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		const MipLevel&	level = texture.levels[i];
+		Ktx2Level				out = {level.width, level.height, level.pixels, level.size};
+		levels[i] = out;
+	}
+	Ktx2File::write(path, vkFormat, source, levels);
+}
+
+// ring 은 GL 스레드에서 한 번 만들고 크기가 바뀌지 않습니다. (worker 가 원소를 가리키므로)
+void	TextureStreamer::createStaging()
+{
+	StagingBuffer	empty = {0, 0, 0, std::vector<unsigned char>(), 0};
+	_staging.assign(STAGING_COUNT, empty);
+	for (int i = 0; i < STAGING_COUNT; i++)
+	{
+		glGenBuffers(1, &_staging[i].pbo);
+		mapStaging(i, STAGING_SIZE);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	std::lock_guard<std::mutex>	lock(_mutex);
+	for (int i = 0; i < STAGING_COUNT; i++)
+		_freeStaging.push_back(i);
+}
+
+// GPU 가 다 읽은 버퍼를 다시 map 합니다. 크기가 같으면 저장소를 다시 만들지 않고 invalidate 만 합니다.
+void	TextureStreamer::mapStaging(int index, size_t capacity)
+{
+	StagingBuffer&	staging = _staging[index];
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.pbo);
+	if (staging.memory && staging.fallback.empty())
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	if (capacity != staging.capacity)
+	{
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+		staging.capacity = capacity;
+	}
+	staging.memory = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, capacity,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (staging.memory)
+		std::vector<unsigned char>().swap(staging.fallback);
+	else
+	{
+		// map 이 안 되는 환경에서는 client 메모리에서 바로 올립니다.
+		staging.fallback.resize(capacity);
+		staging.memory = staging.fallback.data();
+	}
+}
+
+void	TextureStreamer::releaseStaging(int index)
+{
+	if (index < 0)
+		return ;
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_freeStaging.push_back(index);
+	}
+	_condition.notify_all();
+}
+
+// 업로드가 끝난 버퍼를 ring 에 돌려주고, worker 가 기다리는 level 이 모든 버퍼보다 크면 빈 버퍼 하나를 키웁니다.
+void	TextureStreamer::recycleStaging()
+{
+	size_t	wanted;
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		wanted = _stagingWanted;
+	}
+
+	for (size_t i = 0; i < _inFlight.size();)
+	{
+		StagingBuffer&	staging = _staging[_inFlight[i]];
+		GLenum					status = glClientWaitSync(staging.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			i++;
+			continue ;
+		}
+		glDeleteSync(staging.fence);
+		staging.fence = 0;
+		// 커진 버퍼는 worker 가 지금 기다리는 level 에 필요하지 않으면 원래 크기로 돌아갑니다.
+		mapStaging(_inFlight[i], wanted > STAGING_SIZE && staging.capacity >= wanted ? staging.capacity : STAGING_SIZE);
+		releaseStaging(_inFlight[i]);
+		_inFlight.erase(_inFlight.begin() + i);
+	}
+
+	int	grow = -1;
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		bool	fits = false;
+		wanted = _stagingWanted;
+		for (size_t i = 0; i < _staging.size(); i++)
+			fits = fits || _staging[i].capacity >= _stagingWanted;
+		if (!fits && !_freeStaging.empty())
+		{
+			grow = _freeStaging.front();
+			_freeStaging.pop_front();
+		}
+	}
+	if (grow >= 0)
+	{
+		mapStaging(grow, wanted);
+		releaseStaging(grow);
+	}
+}
+
+// GL 스레드에서 프레임마다 호출합니다.
+// level 은 worker 가 staging 한 순서대로 (텍스처마다 작은 level 부터) 올립니다.
+// 한 level 이 예산보다 커도 프레임마다 최소 한 level 은 올립니다.
+void	TextureStreamer::update()
+{
+	if (_staging.empty())
+		return ;
+	recycleStaging();
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		while (!_staged.empty())
+		{
+			_uploading.push_back(StagedLevel());
+			std::swap(_uploading.back(), _staged.front());
+			_staged.pop_front();
+		}
+	}
+
+	size_t	spent = 0;
+	while (!_uploading.empty())
+	{
+		StagedLevel&																		level = _uploading.front();
+		std::map<unsigned int, unsigned int>::iterator	ticket = _tickets.find(level.textureID);
+		bool																						current = ticket != _tickets.end() && ticket->second == level.ticket;
+
+		if (current && level.staging >= 0)
+		{
+			if (spent > 0 && spent + level.size > _budget)
+				break ;
+			uploadLevel(level);
+			spent += level.size;
+		}
+		else
+			releaseStaging(level.staging);	// 취소된 텍스처
+		if (current && !level.error.empty())
+			std::cerr << level.error << std::endl;
+		if (current && level.last)
+			_tickets.erase(ticket);
+		_uploading.pop_front();
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void	TextureStreamer::uploadLevel(const StagedLevel& level)
+{
+	StagingBuffer&	staging = _staging[level.staging];
+	const void*			pixels = 0; // PBO 안의 offset
+	bool						mapped = staging.fallback.empty();
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mapped ? staging.pbo : 0);
+	if (mapped)
+	{
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		staging.memory = 0;
+	}
+	else
+		pixels = staging.memory;
+
+	TextureCache::getInstance().bind(level.slot, level.textureID);
+	if (level.compress)
+		glCompressedTexImage2D(GL_TEXTURE_2D, level.level, compressedFormat(level.format), level.width, level.height, 0, level.size, pixels);
+	else
+		glTexImage2D(GL_TEXTURE_2D, level.level, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	// base level 아래 (더 큰 level) 는 아직 placeholder 이므로 샘플링 범위를 올라온 level 로 제한합니다.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level.level);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level.levelCount - 1);
+	TextureResidency::getInstance().onLevelUploaded(level.textureID, level.level, level.levelCount, level.size);
+
+	// client 메모리에서 올린 경우 GL 이 이미 복사했으므로 바로 돌려줍니다.
+	if (!mapped)
+	{
+		releaseStaging(level.staging);
+		return ;
+	}
+	staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_inFlight.push_back(level.staging);
+}
@@ -0,0 +1,141 @@
+#ifndef __TEXTURESTREAMER_HPP__
+# define __TEXTURESTREAMER_HPP__
+
+#include <glad/glad.h> // include glad to get the required OpenGL headers
+
+# include <vector>
+# include <deque>
+# include <map>
+# include <set>
+# include <string>
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+# include <iostream>
+
+# include "TextureCache.hpp"
+# include "BCEncoder.hpp"
+# include "Ktx2File.hpp"
+
+// 스트리밍 요청 : textureID 는 이미 placeholder 로 만들어진 텍스처입니다.
+struct	TextureRequest {
+	unsigned int								textureID;
+	unsigned int								slot;
+	std::string									path;
+	std::vector<unsigned char>	file;
+	unsigned long long					hash;
+	BCFormat										format;
+	BCQuality										quality;
+	bool												compress;
+	int													firstLevel;	// 올릴 가장 큰 level (보통 0)
+	int													lastLevel;	// 올릴 가장 작은 level, -1 이면 mip chain 끝까지
+};
+
+// 텍스처 스트리밍 : 디코딩 / mip 생성 / 블록 압축은 worker 스레드에서,
+// 업로드는 GL 스레드에서 프레임당 byte 예산만큼만 합니다.
+// 작은 level 부터 올리고 GL_TEXTURE_BASE_LEVEL 을 따라 옮기므로, 텍스처는 1x1 placeholder 에서 점점 선명해집니다.
+//
+// 업로드 버퍼 : GL 스레드가 미리 map 해 둔 PBO ring 에 worker 가 level 을 직접 씁니다.
+// GL 스레드는 unmap 하고 PBO 에서 텍스처를 지정하기만 하므로 픽셀 복사는 driver 가 비동기로 합니다.
+// 버퍼는 업로드 뒤에 넣은 fence 가 끝나야 ring 으로 돌아가므로, GPU 가 읽는 동안 다시 쓰이지 않습니다.
+//
+// 디스크 캐시 : 완성된 mip chain (압축했으면 BC 블록) 을 원본 옆의 KTX2 파일로 저장합니다.
+// 다음 실행부터는 파일을 map 해서 level 을 업로드 버퍼로 바로 복사합니다.
+class TextureStreamer
+{
+	private:
+		// pixels 는 data 또는 map 된 캐시 파일을 가리킵니다.
+		struct	MipLevel {
+			unsigned int								width;
+			unsigned int								height;
+			std::vector<unsigned char>	data;
+			const unsigned char*				pixels;
+			size_t											size;
+		};
+
+		struct	StreamedTexture {
+			unsigned int					ticket;
+			unsigned int					textureID;
+			unsigned int					slot;
+			bool									compress;
+			BCFormat							format;
+			std::vector<MipLevel>	levels;
+			Ktx2File							cache;
+		};
+
+		// worker 가 staging 버퍼에 써 둔 level 하나
+		struct	StagedLevel {
+			unsigned int	ticket;
+			unsigned int	textureID;
+			unsigned int	slot;
+			bool					compress;
+			BCFormat			format;
+			int						level;
+			unsigned int	levelCount;
+			unsigned int	width;
+			unsigned int	height;
+			size_t				size;
+			int						staging;	// -1 이면 올릴 데이터가 없음 (오류, 또는 올릴 level 없음)
+			bool					last;			// 이 텍스처의 마지막 level
+			std::string		error;
+		};
+
+		struct	StagingBuffer {
+			unsigned int								pbo;
+			size_t											capacity;
+			unsigned char*							memory;		// map 된 주소, 또는 fallback
+			std::vector<unsigned char>	fallback;	// map 할 수 없을 때 쓰는 메모리
+			GLsync											fence;
+		};
+
+		std::thread										_worker;
+		std::mutex										_mutex;
+		std::condition_variable				_condition;
+		std::deque<std::pair<unsigned int, TextureRequest> >	_pending;
+		std::deque<StagedLevel>				_staged;
+		std::set<unsigned int>				_cancelled;
+		unsigned int									_activeTicket;
+		bool													_stop;
+
+		// 비어 있는 (map 된) staging 버퍼. _staging 의 원소는 이 목록에 있는 동안 GL 스레드가 건드리지 않습니다.
+		std::vector<StagingBuffer>		_staging;
+		std::deque<int>								_freeStaging;
+		size_t												_stagingWanted;	// worker 가 기다리는 가장 큰 level 크기
+
+		// GL 스레드 전용
+		std::deque<StagedLevel>									_uploading;
+		std::vector<int>												_inFlight;
+		std::map<unsigned int, unsigned int>		_tickets;
+		unsigned int														_nextTicket;
+		size_t																	_budget;
+
+		TextureStreamer();
+		TextureStreamer(const TextureStreamer&);
+		TextureStreamer&	operator=(const TextureStreamer&);
+
+		void				workerLoop();
+		void				stage(unsigned int ticket, const TextureRequest& request, StreamedTexture& texture);
+		int					acquireStaging(size_t size);
+		void				createStaging();
+		void				mapStaging(int index, size_t capacity);
+		void				recycleStaging();
+		void				releaseStaging(int index);
+		void				uploadLevel(const StagedLevel& level);
+		static void	decode(const TextureRequest& request, StreamedTexture& texture);
+
+	public:
+		static const size_t	DEFAULT_UPLOAD_BUDGET = 4 * 1024 * 1024;
+		static const size_t	STAGING_SIZE = 4 * 1024 * 1024;	// 이보다 큰 level 이 오면 버퍼 하나를 키웁니다.
+		static const int		STAGING_COUNT = 4;
+
+		static TextureStreamer&	getInstance();
+		~TextureStreamer();
+
+		void	request(TextureRequest& request);
+		void	cancel(unsigned int textureID);
+		void	update();
+		void	setUploadBudget(size_t bytes);
+		bool	isStreaming(unsigned int textureID) const;
+};
+
+#endif
@@ -0,0 +1,461 @@
+#include "TransformStore.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	// lane 묶음 하나에 대한 연산. float 는 lane 이 하나인 경우입니다.
+	inline float	mul(float a, float b) { return a * b; }
+	inline float	add(float a, float b) { return a + b; }
+	inline float	sub(float a, float b) { return a - b; }
+	inline float	div(float a, float b) { return a / b; }
+	inline float	min(float a, float b) { return a < b ? a : b; }
+	inline float	abs(float a) { return std::fabs(a); }
+
+#if defined(__SSE2__)
+	inline __m128	mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+	inline __m128	add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+	inline __m128	sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+	inline __m128	div(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+	inline __m128	min(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+	inline __m128	abs(__m128 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+#endif
+
+#if defined(__AVX__)
+	inline __m256	mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+	inline __m256	add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+	inline __m256	sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+	inline __m256	div(__m256 a, __m256 b) { return _mm256_div_ps(a, b); }
+	inline __m256	min(__m256 a, __m256 b) { return _mm256_min_ps(a, b); }
+	inline __m256	abs(__m256 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+#endif
+
+	template <typename V>	V		load(const float* p);
+	template <typename V>	V		broadcast(float value);
+	template <typename V>	void	store(float* p, V value);
+	template <typename V>	void	storeMatrices(const V* e, Mat4* out);
+
+	template <>	inline float	load<float>(const float* p) { return *p; }
+	template <>	inline float	broadcast<float>(float value) { return value; }
+	template <>	inline void		store<float>(float* p, float value) { *p = value; }
+	template <>	inline void		storeMatrices<float>(const float* e, Mat4* out)
+	{
+		for (int i = 0; i < 16; i++)
+			out->m[i] = e[i];
+	}
+
+#if defined(__SSE2__)
+	template <>	inline __m128	load<__m128>(const float* p) { return _mm_loadu_ps(p); }
+	template <>	inline __m128	broadcast<__m128>(float value) { return _mm_set1_ps(value); }
+	template <>	inline void		store<__m128>(float* p, __m128 value) { _mm_storeu_ps(p, value); }
+
+	// e[k] 는 4 object 의 k 번째 성분입니다. 4 개씩 전치해서 object 별 행렬로 씁니다.
+	template <>	inline void		storeMatrices<__m128>(const __m128* e, Mat4* out)
+	{
+		for (int k = 0; k < 16; k += 4)
+		{
+			__m128	r0 = e[k], r1 = e[k + 1], r2 = e[k + 2], r3 = e[k + 3];
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_store_ps(out[0].m + k, r0);
+			_mm_store_ps(out[1].m + k, r1);
+			_mm_store_ps(out[2].m + k, r2);
+			_mm_store_ps(out[3].m + k, r3);
+		}
+	}
+#endif
+
+#if defined(__AVX__)
+	template <>	inline __m256	load<__m256>(const float* p) { return _mm256_loadu_ps(p); }
+	template <>	inline __m256	broadcast<__m256>(float value) { return _mm256_set1_ps(value); }
+	template <>	inline void		store<__m256>(float* p, __m256 value) { _mm256_storeu_ps(p, value); }
+
+	// 8x8 전치 두 번 (성분 0 ~ 7, 8 ~ 15)
+	template <>	inline void		storeMatrices<__m256>(const __m256* e, Mat4* out)
+	{
+		for (int k = 0; k < 16; k += 8)
+		{
+			__m256	t0 = _mm256_unpacklo_ps(e[k], e[k + 1]), t1 = _mm256_unpackhi_ps(e[k], e[k + 1]);
+			__m256	t2 = _mm256_unpacklo_ps(e[k + 2], e[k + 3]), t3 = _mm256_unpackhi_ps(e[k + 2], e[k + 3]);
+			__m256	t4 = _mm256_unpacklo_ps(e[k + 4], e[k + 5]), t5 = _mm256_unpackhi_ps(e[k + 4], e[k + 5]);
+			__m256	t6 = _mm256_unpacklo_ps(e[k + 6], e[k + 7]), t7 = _mm256_unpackhi_ps(e[k + 6], e[k + 7]);
+			__m256	u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256	u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256	u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256	u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+			_mm256_storeu_ps(out[0].m + k, _mm256_permute2f128_ps(u0, u4, 0x20));
+			_mm256_storeu_ps(out[1].m + k, _mm256_permute2f128_ps(u1, u5, 0x20));
+			_mm256_storeu_ps(out[2].m + k, _mm256_permute2f128_ps(u2, u6, 0x20));
+			_mm256_storeu_ps(out[3].m + k, _mm256_permute2f128_ps(u3, u7, 0x20));
+			_mm256_storeu_ps(out[4].m + k, _mm256_permute2f128_ps(u0, u4, 0x31));
+			_mm256_storeu_ps(out[5].m + k, _mm256_permute2f128_ps(u1, u5, 0x31));
+			_mm256_storeu_ps(out[6].m + k, _mm256_permute2f128_ps(u2, u6, 0x31));
+			_mm256_storeu_ps(out[7].m + k, _mm256_permute2f128_ps(u3, u7, 0x31));
+		}
+	}
+#endif
+
+	// MVP 의 row 로 만든 frustum 평면 6 개 (object 공간) 에 AABB 를 대 봅니다. (Gribb / Hartmann)
+	// 평면 a x + b y + c z + d 에 대해 d + a cx + b cy + c cz + |a| ex + |b| ey + |c| ez 가
+	// 상자에서 가장 안쪽인 꼭짓점의 값이고, 이것이 음수면 상자 전체가 평면 밖입니다. 6 개 중 가장 작은 값을 돌려줍니다.
+	template <typename V>
+	V		frustumMargin(const V* p, const V* centre, const V* extent)
+	{
+		V	margin = broadcast<V>(0.0f);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (int side = 0; side < 2; side++)
+			{
+				V	plane[4];
+				for (int col = 0; col < 4; col++)
+					plane[col] = side ? sub(p[col * 4 + 3], p[col * 4 + axis]) : add(p[col * 4 + 3], p[col * 4 + axis]);
+				V	distance = add(add(add(mul(plane[0], centre[0]), mul(plane[1], centre[1])), mul(plane[2], centre[2])), plane[3]);
+				V	reach = add(add(mul(abs(plane[0]), extent[0]), mul(abs(plane[1]), extent[1])), mul(abs(plane[2]), extent[2]));
+				V	value = add(distance, reach);
+				margin = axis == 0 && side == 0 ? value : min(margin, value);
+			}
+		}
+		return margin;
+	}
+
+	// begin 부터 W 개 object 의 model, MVP, 노멀 행렬과 frustum 안에 있는지를 구합니다.
+	template <typename V, size_t W>
+	void	composeLanes(const std::vector<float>* position, const std::vector<float>* orientation,
+						const std::vector<float>* scale, const std::vector<float>* boundsCentre, const std::vector<float>* boundsExtent,
+						const Mat4& vp, size_t begin, Mat4* model, Mat4* mvp, Mat4* normal, float* cullMargin,
+						std::vector<float>* worldMin, std::vector<float>* worldMax)
+	{
+		// 단위 quaternion 을 회전 행렬로 : 1 - 2(y² + z²), 2(xy - zw), ... (삼각함수 없음)
+		V	qx = load<V>(&orientation[0][begin]), qy = load<V>(&orientation[1][begin]);
+		V	qz = load<V>(&orientation[2][begin]), qw = load<V>(&orientation[3][begin]);
+		V	one = broadcast<V>(1.0f), two = broadcast<V>(2.0f);
+		V	x2 = mul(qx, two), y2 = mul(qy, two), z2 = mul(qz, two);
+		V	xx = mul(qx, x2), yy = mul(qy, y2), zz = mul(qz, z2);
+		V	xy = mul(qx, y2), xz = mul(qx, z2), yz = mul(qy, z2);
+		V	wx = mul(qw, x2), wy = mul(qw, y2), wz = mul(qw, z2);
+		V	scaleX = load<V>(&scale[0][begin]), scaleY = load<V>(&scale[1][begin]), scaleZ = load<V>(&scale[2][begin]);
+		V	zero = broadcast<V>(0.0f);
+
+		// M = T * R * S : R 의 column 을 크기만큼 늘리고 마지막 column 에 위치를 넣습니다.
+		V	m[16];
+		m[0] = mul(sub(one, add(yy, zz)), scaleX);
+		m[1] = mul(add(xy, wz), scaleX);
+		m[2] = mul(sub(xz, wy), scaleX);
+		m[3] = zero;
+		m[4] = mul(sub(xy, wz), scaleY);
+		m[5] = mul(sub(one, add(xx, zz)), scaleY);
+		m[6] = mul(add(yz, wx), scaleY);
+		m[7] = zero;
+		m[8] = mul(add(xz, wy), scaleZ);
+		m[9] = mul(sub(yz, wx), scaleZ);
+		m[10] = mul(sub(one, add(xx, yy)), scaleZ);
+		m[11] = zero;
+		m[12] = load<V>(&position[0][begin]);
+		m[13] = load<V>(&position[1][begin]);
+		m[14] = load<V>(&position[2][begin]);
+		m[15] = one;
+		storeMatrices<V>(m, model + begin);
+
+		// MVP = VP * M, M 의 0 인 성분은 건너뜁니다.
+		V	p[16];
+		for (int row = 0; row < 4; row++)
+		{
+			V	vp0 = broadcast<V>(vp.m[row]), vp1 = broadcast<V>(vp.m[4 + row]);
+			V	vp2 = broadcast<V>(vp.m[8 + row]), vp3 = broadcast<V>(vp.m[12 + row]);
+			for (int col = 0; col < 3; col++)
+				p[col * 4 + row] = add(add(mul(vp0, m[col * 4]), mul(vp1, m[col * 4 + 1])), mul(vp2, m[col * 4 + 2]));
+			p[12 + row] = add(add(add(mul(vp0, m[12]), mul(vp1, m[13])), mul(vp2, m[14])), vp3);
+		}
+		storeMatrices<V>(p, mvp + begin);
+
+		V	centre[3], extent[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			centre[axis] = load<V>(&boundsCentre[axis][begin]);
+			extent[axis] = load<V>(&boundsExtent[axis][begin]);
+		}
+		store<V>(cullMargin + begin, frustumMargin<V>(p, centre, extent));
+
+		// world AABB : 중심은 M 으로 옮기고, 반 크기는 |M 의 3x3| 로 늘립니다. (scene tree 에 씁니다)
+		for (int row = 0; row < 3; row++)
+		{
+			V	worldCentre = add(add(add(mul(m[row], centre[0]), mul(m[4 + row], centre[1])), mul(m[8 + row], centre[2])), m[12 + row]);
+			V	worldExtent = add(add(mul(abs(m[row]), extent[0]), mul(abs(m[4 + row]), extent[1])), mul(abs(m[8 + row]), extent[2]));
+			store<V>(&worldMin[row][begin], sub(worldCentre, worldExtent));
+			store<V>(&worldMax[row][begin], add(worldCentre, worldExtent));
+		}
+
+		// 노멀 행렬 = (M 의 3x3) 의 inverse-transpose = (R * S)^-T = R * S^-1 (R 은 직교행렬)
+		// R 의 column 을 크기로 나누기만 하면 되므로 역행렬을 구하지 않습니다.
+		V	invX = div(one, scaleX), invY = div(one, scaleY), invZ = div(one, scaleZ);
+		V	n[16];
+		n[0] = mul(sub(one, add(yy, zz)), invX);
+		n[1] = mul(add(xy, wz), invX);
+		n[2] = mul(sub(xz, wy), invX);
+		n[3] = zero;
+		n[4] = mul(sub(xy, wz), invY);
+		n[5] = mul(sub(one, add(xx, zz)), invY);
+		n[6] = mul(add(yz, wx), invY);
+		n[7] = zero;
+		n[8] = mul(add(xz, wy), invZ);
+		n[9] = mul(sub(yz, wx), invZ);
+		n[10] = mul(sub(one, add(xx, yy)), invZ);
+		n[11] = zero;
+		n[12] = zero;
+		n[13] = zero;
+		n[14] = zero;
+		n[15] = one;
+		storeMatrices<V>(n, normal + begin);
+	}
+}
+
+// 평면 계수 (수천 이하) 를 곱해도 넘치지 않는 큰 값
+const float	TransformStore::UNBOUNDED = 1e30f;
+
+TransformStore::TransformStore() : _count(0), _allDirty(true)
+{
+}
+
+TransformStore&	TransformStore::getInstance()
+{
+	static TransformStore	instance;
+	return instance;
+}
+
+void	TransformStore::reserve(size_t count)
+{
+	size_t	size = (count + LANES - 1) / LANES * LANES;
+	if (size <= _model.size())
+		return ;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		_position[axis].resize(size, 0.0f);
+		_scale[axis].resize(size, 1.0f);
+	}
+	for (int i = 0; i < 4; i++)
+		_orientation[i].resize(size, i == 3 ? 1.0f : 0.0f);
+	_model.resize(size);
+	_mvp.resize(size);
+	_normal.resize(size);
+	_cullMargin.resize(size, 0.0f);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		_boundsCentre[axis].resize(size, 0.0f);
+		_boundsExtent[axis].resize(size, UNBOUNDED);
+		_worldMin[axis].resize(size, 0.0f);
+		_worldMax[axis].resize(size, 0.0f);
+	}
+	_proxy.resize(size, -1);
+	_groupDirty.resize(size / LANES, 0);
+}
+
+void	TransformStore::markDirty(size_t index)
+{
+	size_t	group = index / LANES;
+	if (_groupDirty[group])
+		return ;
+	_groupDirty[group] = 1;
+	_dirtyGroups.push_back(group * LANES);
+}
+
+unsigned int	TransformStore::create()
+{
+	size_t	index;
+	if (!_free.empty())
+	{
+		index = _free.back();
+		_free.pop_back();
+	}
+	else
+	{
+		index = _count++;
+		reserve(_count);
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		_position[axis][index] = 0.0f;
+		_scale[axis][index] = 1.0f;
+	}
+	for (int i = 0; i < 4; i++)
+		_orientation[i][index] = i == 3 ? 1.0f : 0.0f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		_boundsCentre[axis][index] = 0.0f;
+		_boundsExtent[axis][index] = UNBOUNDED;
+	}
+	markDirty(index);
+	return static_cast<unsigned int>(index + 1);
+}
+
+void	TransformStore::release(unsigned int id)
+{
+	if (id == 0 || id > _count)
+		return ;
+	size_t	index = id - 1;
+	if (_proxy[index] >= 0)
+		_tree.remove(_proxy[index]);
+	_proxy[index] = -1;
+	for (int axis = 0; axis < 3; axis++)
+		_boundsExtent[axis][index] = UNBOUNDED;
+	_free.push_back(index);
+}
+
+float	TransformStore::position(unsigned int id, TransformAxis axis) const
+{
+	return _position[axis][id - 1];
+}
+
+void	TransformStore::setPosition(unsigned int id, TransformAxis axis, float value)
+{
+	if (_position[axis][id - 1] == value)
+		return ;
+	_position[axis][id - 1] = value;
+	markDirty(id - 1);
+}
+
+float	TransformStore::scale(unsigned int id, TransformAxis axis) const
+{
+	return _scale[axis][id - 1];
+}
+
+void	TransformStore::setScale(unsigned int id, TransformAxis axis, float value)
+{
+	if (_scale[axis][id - 1] == value)
+		return ;
+	_scale[axis][id - 1] = value;
+	markDirty(id - 1);
+}
+
+// q = q * step : object 자신의 축 기준으로 돌리고, 오차가 쌓이지 않게 매번 길이를 1 로 맞춥니다.
+void	TransformStore::rotate(unsigned int id, TransformAxis axis, float degree)
+{
+	float	halfRad = degree * (3.1415926f / 180.0f) * 0.5f;
+	float	s = sinf(halfRad), c = cosf(halfRad);
+	float	step[3] = { 0.0f, 0.0f, 0.0f };
+	step[axis] = s;
+
+	size_t	index = id - 1;
+	float	x = _orientation[0][index], y = _orientation[1][index];
+	float	z = _orientation[2][index], w = _orientation[3][index];
+	float	q[4] = {
+		c * x + step[0] * w - step[1] * z + step[2] * y,
+		c * y + step[0] * z + step[1] * w - step[2] * x,
+		c * z - step[0] * y + step[1] * x + step[2] * w,
+		c * w - step[0] * x - step[1] * y - step[2] * z
+	};
+	float	length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for (int i = 0; i < 4; i++)
+		_orientation[i][index] = q[i] / length;
+	markDirty(index);
+}
+
+void	TransformStore::resetRotation(unsigned int id)
+{
+	size_t	index = id - 1;
+	if (_orientation[0][index] == 0.0f && _orientation[1][index] == 0.0f
+		&& _orientation[2][index] == 0.0f && _orientation[3][index] == 1.0f)
+		return ;
+	for (int i = 0; i < 4; i++)
+		_orientation[i][index] = i == 3 ? 1.0f : 0.0f;
+	markDirty(index);
+}
+
+void	TransformStore::setBounds(unsigned int id, const Bounds& bounds)
+{
+	size_t	index = id - 1;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		_boundsCentre[axis][index] = (bounds.min[axis] + bounds.max[axis]) * 0.5f;
+		_boundsExtent[axis][index] = (bounds.max[axis] - bounds.min[axis]) * 0.5f;
+	}
+	markDirty(index);
+}
+
+void	TransformStore::setViewProjection(const Mat4& viewProjection)
+{
+	_viewProjection = viewProjection;
+	_allDirty = true;
+}
+
+const Mat4&	TransformStore::model(unsigned int id) const
+{
+	return _model[id - 1];
+}
+
+const Mat4&	TransformStore::mvp(unsigned int id) const
+{
+	return _mvp[id - 1];
+}
+
+const Mat4&	TransformStore::normal(unsigned int id) const
+{
+	return _normal[id - 1];
+}
+
+bool	TransformStore::visible(unsigned int id) const
+{
+	return _cullMargin[id - 1] >= 0.0f;
+}
+
+bool	TransformStore::bounded(unsigned int id) const
+{
+	return _boundsExtent[0][id - 1] < UNBOUNDED;
+}
+
+const SceneTree&	TransformStore::tree() const
+{
+	return _tree;
+}
+
+// 배열은 LANES 의 배수이므로 마지막 묶음도 범위 안에서 읽습니다. 놓은 자리도 같이 계산합니다.
+void	TransformStore::updateGroup(size_t begin)
+{
+#if defined(__AVX__)
+	composeLanes<__m256, 8>(_position, _orientation, _scale, _boundsCentre, _boundsExtent,
+		_viewProjection, begin, _model.data(), _mvp.data(), _normal.data(), _cullMargin.data(),
+		_worldMin, _worldMax);
+#elif defined(__SSE2__)
+	composeLanes<__m128, 4>(_position, _orientation, _scale, _boundsCentre, _boundsExtent,
+		_viewProjection, begin, _model.data(), _mvp.data(), _normal.data(), _cullMargin.data(),
+		_worldMin, _worldMax);
+	composeLanes<__m128, 4>(_position, _orientation, _scale, _boundsCentre, _boundsExtent,
+		_viewProjection, begin + 4, _model.data(), _mvp.data(), _normal.data(), _cullMargin.data(),
+		_worldMin, _worldMax);
+#else
+	for (size_t i = 0; i < LANES; i++)
+		composeLanes<float, 1>(_position, _orientation, _scale, _boundsCentre, _boundsExtent,
+			_viewProjection, begin + i, _model.data(), _mvp.data(), _normal.data(), _cullMargin.data(),
+			_worldMin, _worldMax);
+#endif
+	_groupDirty[begin / LANES] = 0;
+
+	// 경계가 있는 object 만 scene tree 에 넣고, 이미 있으면 fat 상자를 벗어났을 때만 고칩니다.
+	size_t	end = std::min(begin + LANES, _count);
+	for (size_t index = begin; index < end; index++)
+	{
+		if (_boundsExtent[0][index] >= UNBOUNDED)
+			continue ;
+		float	min[3] = { _worldMin[0][index], _worldMin[1][index], _worldMin[2][index] };
+		float	max[3] = { _worldMax[0][index], _worldMax[1][index], _worldMax[2][index] };
+		if (_proxy[index] < 0)
+			_proxy[index] = _tree.insert(static_cast<unsigned int>(index + 1), min, max);
+		else
+			_tree.move(_proxy[index], min, max);
+	}
+}
+
+void	TransformStore::update()
+{
+	if (_allDirty)
+	{
+		for (size_t begin = 0; begin < _count; begin += LANES)
+			updateGroup(begin);
+		_allDirty = false;
+	}
+	else
+	{
+		for (size_t i = 0; i < _dirtyGroups.size(); i++)
+			updateGroup(_dirtyGroups[i]);
+	}
+	_dirtyGroups.clear();
+	_tree.optimize();
+}
@@ -0,0 +1,95 @@
+#ifndef __TRANSFORMSTORE_HPP__
+# define __TRANSFORMSTORE_HPP__
+
+# include <vector>
+# include <cmath>
+
+# include "Matrix.hpp"
+# include "MeshData.hpp"
+# include "SceneTree.hpp"
+
+enum	TransformAxis {
+	AXIS_X,
+	AXIS_Y,
+	AXIS_Z
+};
+
+// object 들의 위치 / 방향 (quaternion) / 크기를 성분별 배열 (structure of arrays) 로 모아 두고,
+// 한 번의 pass 로 모든 model 행렬과 MVP 행렬을 구합니다.
+// 회전은 입력 한 번마다 object 축 기준의 작은 quaternion 을 곱하고 다시 정규화해서 쌓습니다.
+// Euler 각이 아니므로 gimbal lock 이 없고, sin / cos 는 rotate() 에서만 구합니다.
+// lane 묶음 (AVX 8 개, SSE2 4 개, 그 외 1 개) 마다 M = T * R * S 를 4x4 곱셈 없이 바로 씁니다.
+// 노멀 행렬은 R 의 column i 를 scale i 로 나눈 것이라 역행렬을 구하지 않습니다.
+// 같은 pass 에서 object 공간 AABB 를 MVP 의 frustum 평면 6 개에 대 보고 화면 밖인지 표시합니다.
+// world AABB 도 같이 구해서 바뀐 object 만 scene tree (동적 BVH) 에 반영합니다.
+// 값이 바뀐 object 가 속한 lane 묶음만 dirty 로 표시해 두고 update() 는 그 묶음만 다시 구합니다.
+// view-projection 이 바뀌면 (창 크기 변경) 모든 묶음을 다시 구합니다. 프레임당 일은 바뀐 object 수에 비례합니다.
+// id 0 은 "없음" 입니다. 놓은 자리는 다음 create() 가 다시 씁니다.
+class TransformStore
+{
+	private:
+		std::vector<float>			_position[3];
+		std::vector<float>			_orientation[4];	// 단위 quaternion (x, y, z, w)
+		std::vector<float>			_scale[3];
+		std::vector<Mat4>				_model;
+		std::vector<Mat4>				_mvp;
+		std::vector<Mat4>				_normal;
+		std::vector<float>			_boundsCentre[3];		// object 공간 AABB 중심 / 반 크기
+		std::vector<float>			_boundsExtent[3];
+		std::vector<float>			_cullMargin;				// 음수면 frustum 밖 (평면까지의 정규화하지 않은 거리)
+		std::vector<float>			_worldMin[3];
+		std::vector<float>			_worldMax[3];
+		std::vector<int>				_proxy;							// scene tree 의 leaf (-1 이면 없음)
+		SceneTree								_tree;
+		std::vector<unsigned int>	_free;
+		size_t									_count;		// 쓰고 있는 가장 큰 자리 + 1
+		Mat4										_viewProjection;
+		std::vector<unsigned char>	_groupDirty;		// lane 묶음마다 다시 구해야 하는지
+		std::vector<size_t>			_dirtyGroups;		// dirty 인 묶음의 시작 자리
+		bool										_allDirty;
+
+		TransformStore();
+		TransformStore(const TransformStore&);
+		TransformStore&	operator=(const TransformStore&);
+
+		void	reserve(size_t count);
+		void	markDirty(size_t index);
+		void	updateGroup(size_t begin);
+
+	public:
+		static const size_t	LANES = 8;		// 배열은 이 배수로 늘어나서 마지막 묶음도 끝까지 읽을 수 있습니다.
+		static const float	UNBOUNDED;		// setBounds() 전의 반 크기 : 잘리지 않습니다.
+
+		static TransformStore&	getInstance();
+
+		unsigned int	create();
+		void					release(unsigned int id);
+
+		// 값이 실제로 바뀔 때만 dirty 로 표시합니다.
+		float					position(unsigned int id, TransformAxis axis) const;
+		void					setPosition(unsigned int id, TransformAxis axis, float value);
+		float					scale(unsigned int id, TransformAxis axis) const;
+		void					setScale(unsigned int id, TransformAxis axis, float value);
+		// object 의 axis 를 중심으로 degree 만큼 (오른손 방향) 더 돌립니다. Mat4::rotationX / Y / Z 와 같은 방향입니다.
+		void					rotate(unsigned int id, TransformAxis axis, float degree);
+		void					resetRotation(unsigned int id);
+		// object 공간 (크기 / 회전 / 위치를 적용하기 전) 의 경계
+		void					setBounds(unsigned int id, const Bounds& bounds);
+
+		// 카메라나 창 크기가 바뀌었을 때만 부릅니다. 다음 update() 가 모든 MVP 를 다시 구합니다.
+		void					setViewProjection(const Mat4& viewProjection);
+		// dirty 인 object 의 model, MVP (= viewProjection * model), 노멀 행렬을 다시 구합니다.
+		void					update();
+		const Mat4&		model(unsigned int id) const;
+		const Mat4&		mvp(unsigned int id) const;
+		// 노멀을 world 공간으로 옮기는 행렬 (mat3 으로 쓰고 마지막 row / column 은 단위 행렬과 같습니다)
+		const Mat4&		normal(unsigned int id) const;
+		// 마지막 update() 때 AABB 가 view frustum 과 겹쳤는지 (겹칠 수도 있으면 true)
+		bool					visible(unsigned int id) const;
+		// setBounds() 로 경계를 받았는지 : 경계가 없는 object 는 scene tree 에 없고 잘리지도 않습니다.
+		bool					bounded(unsigned int id) const;
+		// 경계가 있는 object 들의 world AABB BVH : frustum / 광선 query 를 log 시간에 합니다. (id 는 transform id)
+		const SceneTree&	tree() const;
+};
+
+#endif
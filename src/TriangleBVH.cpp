@@ -0,0 +1,442 @@
+#include "TriangleBVH.hpp"
+#include "BinnedSAH.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+	// min / max 는 Node 의 것 : SSE2 에서는 각각 16 byte 를 읽고 4 번째 칸은 버립니다.
+#if defined(__SSE2__)
+	inline bool	intersectBox(const float* min, const float* max, __m128 origin, __m128 inverse, float distance, float& entry)
+	{
+		__m128	lanes = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		__m128	t0 = _mm_mul_ps(_mm_sub_ps(_mm_and_ps(_mm_loadu_ps(min), lanes), origin), inverse);
+		__m128	t1 = _mm_mul_ps(_mm_sub_ps(_mm_and_ps(_mm_loadu_ps(max), lanes), origin), inverse);
+		// 4 번째 칸은 near 가 0, far 가 distance 가 되도록
+		__m128	near = _mm_and_ps(_mm_min_ps(t0, t1), lanes);
+		__m128	far = _mm_or_ps(_mm_and_ps(_mm_max_ps(t0, t1), lanes), _mm_andnot_ps(lanes, _mm_set1_ps(distance)));
+		near = _mm_max_ps(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(1, 0, 3, 2)));
+		near = _mm_max_ps(near, _mm_shuffle_ps(near, near, _MM_SHUFFLE(2, 3, 0, 1)));
+		far = _mm_min_ps(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(1, 0, 3, 2)));
+		far = _mm_min_ps(far, _mm_shuffle_ps(far, far, _MM_SHUFFLE(2, 3, 0, 1)));
+		entry = _mm_cvtss_f32(near);
+		return entry <= _mm_cvtss_f32(far);
+	}
+#else
+	inline bool	intersectBox(const float* min, const float* max, const float* origin, const float* inverse, float distance, float& entry)
+	{
+		float	near = 0.0f, far = distance;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float	t0 = (min[axis] - origin[axis]) * inverse[axis];
+			float	t1 = (max[axis] - origin[axis]) * inverse[axis];
+			near = std::max(near, std::min(t0, t1));
+			far = std::min(far, std::max(t0, t1));
+		}
+		entry = near;
+		return near <= far;
+	}
+#endif
+}
+
+TriangleBVH::TriangleBVH()
+{
+}
+
+void	TriangleBVH::build(const std::vector<float>& vertices, const std::vector<FaceData>& faces, unsigned int threads)
+{
+	_nodes.clear();
+	_packets.clear();
+
+	BuildData	data;
+	for (size_t i = 0; i + 2 < faces.size(); i += 3)
+	{
+		bool	valid = true;
+		for (int k = 0; k < 3; k++)
+		{
+			int	index = faces[i + k].vertex;
+			valid = valid && index >= 0 && static_cast<size_t>(index) * 3 + 2 < vertices.size();
+		}
+		if (!valid)
+			continue ;
+		for (int k = 0; k < 3; k++)
+			data.triangles.push_back(static_cast<unsigned int>(faces[i + k].vertex));
+	}
+	size_t	count = data.triangles.size() / 3;
+	if (count == 0)
+		return ;
+
+	data.references.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Reference&		reference = data.references[i];
+		const float*	p[3];
+		for (int k = 0; k < 3; k++)
+			p[k] = &vertices[data.triangles[i * 3 + k] * 3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			reference.min[axis] = std::min(std::min(p[0][axis], p[1][axis]), p[2][axis]);
+			reference.max[axis] = std::max(std::max(p[0][axis], p[1][axis]), p[2][axis]);
+		}
+		reference.triangle = static_cast<unsigned int>(i);
+		reference.pad = 0.0f;
+	}
+
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	if (count < PARALLEL_TRIANGLES)
+		threads = 1;
+	unsigned int	levels = 0;
+	while ((1u << levels) < threads)
+		levels++;
+
+	// 위의 levels 단계는 여기서 나누고, 그 아래 subtree 는 task 마다 따로 만듭니다.
+	std::vector<Task>	tasks;
+	_nodes.assign(1, Node());
+	buildTop(data, 0, 0, count, 0, levels, tasks);
+
+	std::vector<std::vector<Node> >	subtrees(tasks.size());
+	std::vector<std::thread>				workers;
+	for (size_t t = 1; t < tasks.size(); t++)
+		workers.push_back(std::thread(buildSubtree, std::ref(data), std::cref(tasks[t]), std::ref(subtrees[t])));
+	buildSubtree(data, tasks[0], subtrees[0]);
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	// subtree 의 0 번 node 는 task 자리에, 나머지는 끝에 이어 붙이면서 child 번호를 옮깁니다.
+	for (size_t t = 0; t < tasks.size(); t++)
+	{
+		const std::vector<Node>&	subtree = subtrees[t];
+		unsigned int							offset = static_cast<unsigned int>(_nodes.size()) - 1;
+		for (size_t i = 0; i < subtree.size(); i++)
+		{
+			Node	node = subtree[i];
+			if (node.count == 0)
+				node.first += offset;
+			if (i == 0)
+				_nodes[tasks[t].node] = node;
+			else
+				_nodes.push_back(node);
+		}
+	}
+
+	// leaf 의 삼각형을 packet 으로 : leaf 순서대로 놓습니다.
+	for (size_t i = 0; i < _nodes.size(); i++)
+	{
+		Node&	node = _nodes[i];
+		if (node.count == 0)
+			continue ;
+		Packet	packet = Packet();
+		for (unsigned int lane = 0; lane < node.count; lane++)
+		{
+			const unsigned int*	triangle = &data.triangles[data.references[node.first + lane].triangle * 3];
+			const float*				p0 = &vertices[triangle[0] * 3];
+			const float*				p1 = &vertices[triangle[1] * 3];
+			const float*				p2 = &vertices[triangle[2] * 3];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				packet.v0[axis][lane] = p0[axis];
+				packet.edge1[axis][lane] = p1[axis] - p0[axis];
+				packet.edge2[axis][lane] = p2[axis] - p0[axis];
+			}
+		}
+		node.first = static_cast<unsigned int>(_packets.size());
+		_packets.push_back(packet);
+	}
+}
+
+void	TriangleBVH::buildTop(BuildData& data, unsigned int index, size_t begin, size_t end, unsigned int depth,
+									unsigned int levels, std::vector<Task>& tasks)
+{
+	if (depth == levels || end - begin <= LEAF_SIZE)
+	{
+		Task	task = { index, begin, end, depth };
+		tasks.push_back(task);
+		return ;
+	}
+	fitNode(data, _nodes[index], begin, end);
+	size_t				middle = split(data, begin, end, depth);
+	unsigned int	child = static_cast<unsigned int>(_nodes.size());
+	_nodes.resize(_nodes.size() + 2);
+	_nodes[index].first = child;
+	_nodes[index].count = 0;
+	buildTop(data, child, begin, middle, depth + 1, levels, tasks);
+	buildTop(data, child + 1, middle, end, depth + 1, levels, tasks);
+}
+
+void	TriangleBVH::buildSubtree(BuildData& data, const Task& task, std::vector<Node>& nodes)
+{
+	nodes.assign(1, Node());
+	buildNode(data, nodes, 0, task.begin, task.end, task.depth);
+}
+
+void	TriangleBVH::buildNode(BuildData& data, std::vector<Node>& nodes, unsigned int index, size_t begin, size_t end, unsigned int depth)
+{
+	fitNode(data, nodes[index], begin, end);
+	if (end - begin <= LEAF_SIZE)
+	{
+		nodes[index].first = static_cast<unsigned int>(begin);
+		nodes[index].count = static_cast<unsigned int>(end - begin);
+		return ;
+	}
+	size_t				middle = split(data, begin, end, depth);
+	unsigned int	child = static_cast<unsigned int>(nodes.size());
+	nodes.resize(nodes.size() + 2);
+	nodes[index].first = child;
+	nodes[index].count = 0;
+	buildNode(data, nodes, child, begin, middle, depth + 1);
+	buildNode(data, nodes, child + 1, middle, end, depth + 1);
+}
+
+void	TriangleBVH::fitNode(const BuildData& data, Node& node, size_t begin, size_t end)
+{
+	SAHBin	box;
+	box.reset();
+	for (size_t i = begin; i < end; i++)
+		box.grow(data.references[i].min, data.references[i].max);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		node.min[axis] = box.min[axis];
+		node.max[axis] = box.max[axis];
+	}
+}
+
+// [begin, end) 를 나누는 자리 : 세 축의 중심 bin 경계 가운데 SAH cost 가 가장 작은 곳,
+// 중심이 모두 같거나 너무 깊어지면 가장 긴 축의 가운데 (traversal stack 이 넘치지 않도록)
+// 중심은 (min + max) 로, 절반은 곱하지 않고 씁니다.
+size_t	TriangleBVH::split(BuildData& data, size_t begin, size_t end, unsigned int depth)
+{
+	Reference*	first = data.references.data() + begin;
+	Reference*	last = data.references.data() + end;
+	size_t			count = end - begin;
+	float				centreMin[3] = { 1e30f, 1e30f, 1e30f }, centreMax[3] = { -1e30f, -1e30f, -1e30f };
+	for (const Reference* reference = first; reference != last; reference++)
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float	centre = reference->min[axis] + reference->max[axis];
+			centreMin[axis] = std::min(centreMin[axis], centre);
+			centreMax[axis] = std::max(centreMax[axis], centre);
+		}
+
+	// 세 축을 한 번에 bin 에 넣습니다.
+	float	scale[3];
+	SAHBin	bins[3][BUILD_BINS];
+	bool	binned = false;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float	extent = centreMax[axis] - centreMin[axis];
+		scale[axis] = extent > 0.0f ? BUILD_BINS / extent : 0.0f;
+		binned = binned || extent > 0.0f;
+		for (size_t b = 0; b < BUILD_BINS; b++)
+			bins[axis][b].reset();
+	}
+	binned = binned && depth < MAX_SAH_DEPTH;
+#if defined(__SSE2__)
+	// 상자를 16 byte 로 한 번에 읽고 써서, 같은 bin 에 이어 넣을 때 store forwarding 이 끊기지 않게 합니다.
+	// (float 로 나누어 쓰면 bin 하나에 수십 cycle 이 듭니다. 4 번째 칸은 쓰지 않습니다)
+	__m128	binMin[3][BUILD_BINS], binMax[3][BUILD_BINS];
+	for (int axis = 0; axis < 3; axis++)
+		for (size_t b = 0; b < BUILD_BINS; b++)
+		{
+			binMin[axis][b] = _mm_set1_ps(1e30f);
+			binMax[axis][b] = _mm_set1_ps(-1e30f);
+		}
+	for (const Reference* reference = first; reference != last && binned; reference++)
+	{
+		__m128	min = _mm_load_ps(reference->min), max = _mm_load_ps(reference->max);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			int	b = std::min(static_cast<int>((reference->min[axis] + reference->max[axis] - centreMin[axis]) * scale[axis]),
+							static_cast<int>(BUILD_BINS) - 1);
+			binMin[axis][b] = _mm_min_ps(binMin[axis][b], min);
+			binMax[axis][b] = _mm_max_ps(binMax[axis][b], max);
+			bins[axis][b].count++;
+		}
+	}
+	for (int axis = 0; axis < 3 && binned; axis++)
+		for (size_t b = 0; b < BUILD_BINS; b++)
+		{
+			float	min[4], max[4];
+			_mm_storeu_ps(min, binMin[axis][b]);
+			_mm_storeu_ps(max, binMax[axis][b]);
+			bins[axis][b].grow(min, max);
+		}
+#else
+	for (const Reference* reference = first; reference != last && binned; reference++)
+		for (int axis = 0; axis < 3; axis++)
+		{
+			int		b = static_cast<int>((reference->min[axis] + reference->max[axis] - centreMin[axis]) * scale[axis]);
+			SAHBin&	bin = bins[axis][std::min(b, static_cast<int>(BUILD_BINS) - 1)];
+			bin.grow(reference->min, reference->max);
+			bin.count++;
+		}
+#endif
+
+	int			bestAxis = -1;
+	size_t	bestSplit = 0;
+	float		bestCost = 0.0f;
+	for (int axis = 0; axis < 3 && binned; axis++)
+	{
+		if (scale[axis] == 0.0f)
+			continue ;
+		float		cost = 0.0f;
+		size_t	split = findSAHSplit(bins[axis], count, cost);
+		if (split && (bestAxis < 0 || cost < bestCost))
+		{
+			bestAxis = axis;
+			bestSplit = split;
+			bestCost = cost;
+		}
+	}
+
+	if (bestAxis >= 0)
+	{
+		float	minimum = centreMin[bestAxis], axisScale = scale[bestAxis];
+		int		axis = bestAxis, boundary = static_cast<int>(bestSplit);
+		Reference*	middle = std::partition(first, last, [=](const Reference& reference) {
+			return static_cast<int>((reference.min[axis] + reference.max[axis] - minimum) * axisScale) < boundary;
+		});
+		return begin + (middle - first);
+	}
+
+	int	axis = 0;
+	for (int other = 1; other < 3; other++)
+		if (centreMax[other] - centreMin[other] > centreMax[axis] - centreMin[axis])
+			axis = other;
+	std::nth_element(first, first + count / 2, last, [=](const Reference& a, const Reference& b) {
+		return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis];
+	});
+	return begin + count / 2;
+}
+
+bool	TriangleBVH::intersect(const float* origin, const float* direction, float& distance) const
+{
+	if (_nodes.empty())
+		return false;
+	// 0 인 성분은 아주 작은 값으로 바꿔서 0 * inf (NaN) 가 나오지 않게 합니다.
+	float	inverse[3];
+	for (int axis = 0; axis < 3; axis++)
+		inverse[axis] = 1.0f / (direction[axis] != 0.0f ? direction[axis] : 1e-30f);
+#if defined(__SSE2__)
+	__m128	rayOrigin = _mm_setr_ps(origin[0], origin[1], origin[2], 0.0f);
+	__m128	rayInverse = _mm_setr_ps(inverse[0], inverse[1], inverse[2], 0.0f);
+#else
+	const float*	rayOrigin = origin;
+	const float*	rayInverse = inverse;
+#endif
+
+	// 깊이는 MAX_SAH_DEPTH 에 가운데 나누기 단계를 더한 것보다 얕으므로 stack 은 고정 크기로 충분합니다.
+	// 상자에 들어가는 거리를 같이 넣어 두고, 꺼낼 때 그보다 가까운 삼각형을 이미 찾았으면 건너뜁니다.
+	unsigned int	stack[128];
+	float					stackEntry[128];
+	size_t				top = 0;
+	bool					found = false;
+	float					entry;
+	if (!intersectBox(_nodes[0].min, _nodes[0].max, rayOrigin, rayInverse, distance, entry))
+		return false;
+	stack[top] = 0;
+	stackEntry[top++] = entry;
+	while (top > 0)
+	{
+		top--;
+		if (stackEntry[top] > distance)
+			continue ;
+		const Node&	node = _nodes[stack[top]];
+		if (node.count != 0)
+		{
+			found = intersectPacket(_packets[node.first], origin, direction, distance) || found;
+			continue ;
+		}
+		float	entry0, entry1;
+		bool	hit0 = intersectBox(_nodes[node.first].min, _nodes[node.first].max, rayOrigin, rayInverse, distance, entry0);
+		bool	hit1 = intersectBox(_nodes[node.first + 1].min, _nodes[node.first + 1].max, rayOrigin, rayInverse, distance, entry1);
+		// 가까운 child 를 나중에 넣어서 먼저 꺼냅니다.
+		if (hit0 && hit1 && entry1 < entry0)
+		{
+			stack[top] = node.first;
+			stackEntry[top++] = entry0;
+			stack[top] = node.first + 1;
+			stackEntry[top++] = entry1;
+			continue ;
+		}
+		if (hit1)
+		{
+			stack[top] = node.first + 1;
+			stackEntry[top++] = entry1;
+		}
+		if (hit0)
+		{
+			stack[top] = node.first;
+			stackEntry[top++] = entry0;
+		}
+	}
+	return found;
+}
+
+// Moller-Trumbore : 4 개를 한 번에 계산하고, 맞은 것 가운데 가장 가까운 t 를 고릅니다.
+bool	TriangleBVH::intersectPacket(const Packet& packet, const float* origin, const float* direction, float& distance) const
+{
+	float	t[4];
+	int		mask = 0;
+#if defined(__SSE2__)
+	__m128	dx = _mm_set1_ps(direction[0]), dy = _mm_set1_ps(direction[1]), dz = _mm_set1_ps(direction[2]);
+	__m128	e1x = _mm_load_ps(packet.edge1[0]), e1y = _mm_load_ps(packet.edge1[1]), e1z = _mm_load_ps(packet.edge1[2]);
+	__m128	e2x = _mm_load_ps(packet.edge2[0]), e2y = _mm_load_ps(packet.edge2[1]), e2z = _mm_load_ps(packet.edge2[2]);
+	__m128	px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+	__m128	py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+	__m128	pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+	__m128	det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+	__m128	inverse = _mm_div_ps(_mm_set1_ps(1.0f), det);
+	__m128	tx = _mm_sub_ps(_mm_set1_ps(origin[0]), _mm_load_ps(packet.v0[0]));
+	__m128	ty = _mm_sub_ps(_mm_set1_ps(origin[1]), _mm_load_ps(packet.v0[1]));
+	__m128	tz = _mm_sub_ps(_mm_set1_ps(origin[2]), _mm_load_ps(packet.v0[2]));
+	__m128	u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inverse);
+	__m128	qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+	__m128	qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+	__m128	qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+	__m128	v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+	__m128	hitT = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+	__m128	zero = _mm_setzero_ps();
+	__m128	hit = _mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_cmpge_ps(u, zero));
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+	hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+	hit = _mm_and_ps(hit, _mm_cmpgt_ps(hitT, zero));
+	hit = _mm_and_ps(hit, _mm_cmplt_ps(hitT, _mm_set1_ps(distance)));
+	mask = _mm_movemask_ps(hit);
+	_mm_storeu_ps(t, hitT);
+#else
+	for (int lane = 0; lane < 4; lane++)
+	{
+		float	e1[3] = { packet.edge1[0][lane], packet.edge1[1][lane], packet.edge1[2][lane] };
+		float	e2[3] = { packet.edge2[0][lane], packet.edge2[1][lane], packet.edge2[2][lane] };
+		float	p[3] = { direction[1] * e2[2] - direction[2] * e2[1], direction[2] * e2[0] - direction[0] * e2[2],
+							direction[0] * e2[1] - direction[1] * e2[0] };
+		float	det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+		float	inverse = 1.0f / det;
+		float	s[3] = { origin[0] - packet.v0[0][lane], origin[1] - packet.v0[1][lane], origin[2] - packet.v0[2][lane] };
+		float	u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+		float	q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+		float	v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverse;
+		t[lane] = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverse;
+		if (det != 0.0f && u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t[lane] > 0.0f && t[lane] < distance)
+			mask |= 1 << lane;
+	}
+#endif
+	if (mask == 0)
+		return false;
+	for (int lane = 0; lane < 4; lane++)
+		if ((mask & (1 << lane)) && t[lane] < distance)
+			distance = t[lane];
+	return true;
+}
+
+size_t	TriangleBVH::nodeCount() const
+{
+	return _nodes.size();
+}
+
+bool	TriangleBVH::empty() const
+{
+	return _nodes.empty();
+}
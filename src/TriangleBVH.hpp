@@ -0,0 +1,78 @@
+#ifndef __TRIANGLEBVH_HPP__
+# define __TRIANGLEBVH_HPP__
+
+# include <vector>
+
+# include "Matrix.hpp"
+# include "MeshData.hpp"
+
+// mesh 하나의 삼각형 BVH : 광선이 처음 맞는 삼각형까지의 거리를 구합니다. (object 선택에 씁니다)
+// 세 축의 binned SAH 로 나누고, leaf 하나는 삼각형 4 개를 SoA 로 담아 한 번에 검사합니다. (빈 칸은 맞지 않습니다)
+// 큰 mesh 는 위의 몇 단계를 먼저 나누고, 그 아래 subtree 를 스레드마다 따로 만든 뒤 이어 붙입니다.
+class TriangleBVH
+{
+	private:
+		// leaf 면 count 가 삼각형 수 (1 ~ LEAF_SIZE) 이고 first 가 packet 번호,
+		// 아니면 count 가 0 이고 child 는 first, first + 1 입니다.
+		struct	Node {
+			float					min[3];
+			float					max[3];
+			unsigned int	first;
+			unsigned int	count;
+		};
+
+		struct	alignas(16) Packet {
+			float	v0[3][4];
+			float	edge1[3][4];
+			float	edge2[3][4];
+		};
+
+		// build 하는 동안만 쓰는 삼각형 상자 : 번호가 아니라 상자를 그대로 나누어서 읽기가 이어지게 합니다.
+		struct	alignas(16) Reference {
+			float					min[3];
+			unsigned int	triangle;
+			float					max[3];
+			float					pad;
+		};
+
+		// 삼각형별 정점 번호와 상자, 스레드들은 references 의 서로 다른 구간만 바꿉니다.
+		struct	BuildData {
+			std::vector<unsigned int>	triangles;
+			std::vector<Reference>		references;
+		};
+
+		// 한 스레드가 만드는 subtree : node 자리와 references 구간
+		struct	Task {
+			unsigned int	node;
+			size_t				begin, end;
+			unsigned int	depth;
+		};
+
+		std::vector<Node>		_nodes;
+		std::vector<Packet>	_packets;
+
+		static size_t	split(BuildData& data, size_t begin, size_t end, unsigned int depth);
+		static void		fitNode(const BuildData& data, Node& node, size_t begin, size_t end);
+		static void		buildNode(BuildData& data, std::vector<Node>& nodes, unsigned int index, size_t begin, size_t end, unsigned int depth);
+		static void		buildSubtree(BuildData& data, const Task& task, std::vector<Node>& nodes);
+		void					buildTop(BuildData& data, unsigned int index, size_t begin, size_t end, unsigned int depth,
+										unsigned int levels, std::vector<Task>& tasks);
+		bool					intersectPacket(const Packet& packet, const float* origin, const float* direction, float& distance) const;
+
+	public:
+		static const unsigned int	LEAF_SIZE = 4;
+		static const size_t				BUILD_BINS = 12;
+		static const unsigned int	MAX_SAH_DEPTH = 64;					// 이보다 깊으면 가운데에서 나눕니다.
+		static const size_t				PARALLEL_TRIANGLES = 65536;	// 이보다 작으면 한 스레드로 만듭니다.
+
+		TriangleBVH();
+
+		// faces 는 삼각형마다 3 개 (범위를 벗어난 정점을 가리키는 삼각형은 뺍니다), threads 가 0 이면 코어 수만큼
+		void		build(const std::vector<float>& vertices, const std::vector<FaceData>& faces, unsigned int threads = 0);
+		// origin + t * direction 이 처음 맞는 삼각형의 t 가 distance 보다 작으면 distance 를 바꾸고 true 를 돌려줍니다.
+		bool		intersect(const float* origin, const float* direction, float& distance) const;
+		size_t	nodeCount() const;
+		bool		empty() const;
+};
+
+#endif
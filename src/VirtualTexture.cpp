@@ -0,0 +1,545 @@
+#include "VirtualTexture.hpp"
+#include "TextureResidency.hpp"
+
+VirtualTextureSystem::VirtualTextureSystem() : _stop(false), _slotsPerSide(0), _physicalID(0), _frame(0),
+_feedbackFrame(0), _fbo(0), _feedbackColor(0), _feedbackDepth(0), _feedbackPBO(0), _feedbackWidth(0),
+_feedbackHeight(0), _feedbackFence(0), _feedbackPending(false)
+{
+	for (int i = 0; i < 4; i++)
+		_viewport[i] = 0;
+}
+
+VirtualTextureSystem::~VirtualTextureSystem()
+{
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+	if (_worker.joinable())
+		_worker.join();
+}
+
+VirtualTextureSystem&	VirtualTextureSystem::getInstance()
+{
+	static VirtualTextureSystem	instance;
+	return instance;
+}
+
+unsigned long long	VirtualTextureSystem::pageKey(unsigned int texture, unsigned int level, unsigned int x, unsigned int y)
+{
+	return (static_cast<unsigned long long>(texture) << 48) | (static_cast<unsigned long long>(level) << 32)
+		| (static_cast<unsigned long long>(x) << 16) | y;
+}
+
+void	VirtualTextureSystem::push(const PageJob& job)
+{
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_jobs.push_back(job);
+		if (!_worker.joinable())
+			_worker = std::thread(&VirtualTextureSystem::workerLoop, this);
+	}
+	_condition.notify_one();
+}
+
+unsigned int	VirtualTextureSystem::acquire(const std::string& path)
+{
+	std::map<std::string, unsigned int>::iterator	it = _byPath.find(path);
+	if (it != _byPath.end())
+	{
+		_textures[it->second].refCount++;
+		return it->second;
+	}
+
+	// feedback 이 texture 번호를 8 bit 로 쓰므로 1 ~ 255 중 빈 번호를 씁니다.
+	unsigned int	id = 1;
+	while (id < 256 && _textures.count(id))
+		id++;
+	if (id == 256)
+		throw std::runtime_error("ERROR::LOADER::VT::TOO_MANY\ntoo many virtual textures.");
+	if (!_physicalID)
+		createPhysical();
+
+	VirtualTexture	texture;
+	texture.path = path;
+	texture.refCount = 1;
+	texture.ready = false;
+	texture.dirty = false;
+	texture.width = 0;
+	texture.height = 0;
+	texture.levelCount = 0;
+	texture.indirectionID = 0;
+	_textures[id] = texture;
+	_byPath[path] = id;
+
+	PageJob	job = {id, TILE_JOB, 0, 0, path};
+	push(job);
+	return id;
+}
+
+void	VirtualTextureSystem::release(unsigned int id)
+{
+	std::map<unsigned int, VirtualTexture>::iterator	it = _textures.find(id);
+	if (id == 0 || it == _textures.end() || --it->second.refCount > 0)
+		return ;
+
+	for (size_t slot = 0; slot < _slots.size(); slot++)
+		if (_slots[slot].used && _slots[slot].texture == id)
+			_slots[slot].used = false;
+	for (std::set<unsigned long long>::iterator key = _requested.begin(); key != _requested.end();)
+	{
+		if ((*key >> 48) == id)
+			_requested.erase(key++);
+		else
+			++key;
+	}
+	for (std::map<unsigned long long, unsigned int>::iterator failure = _failures.begin(); failure != _failures.end();)
+	{
+		if ((failure->first >> 48) == id)
+			_failures.erase(failure++);
+		else
+			++failure;
+	}
+	if (it->second.indirectionID)
+		glDeleteTextures(1, &it->second.indirectionID);
+	_byPath.erase(it->second.path);
+	_textures.erase(it);
+
+	PageJob	job = {id, CLOSE_JOB, 0, 0, ""};
+	push(job);
+}
+
+// physical cache : VT_SLOT_SIZE 크기의 칸을 격자로 가진 텍스처 하나를 모든 가상 텍스처가 같이 씁니다.
+void	VirtualTextureSystem::createPhysical()
+{
+	GLint	maxSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	_slotsPerSide = std::max(1u, static_cast<unsigned int>(maxSize) / VT_SLOT_SIZE);
+	if (_slotsPerSide > MAX_SLOTS_PER_SIDE)
+		_slotsPerSide = MAX_SLOTS_PER_SIDE;
+
+	Slot	empty = {false, 0, 0, 0, 0, 0};
+	_slots.assign(_slotsPerSide * _slotsPerSide, empty);
+
+	unsigned int	size = _slotsPerSide * VT_SLOT_SIZE;
+	glGenTextures(1, &_physicalID);
+	TextureCache::getInstance().bind(TEXTURE_SLOT_VIRTUAL_PAGES, _physicalID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	TextureResidency::getInstance().pin(_physicalID, static_cast<size_t>(size) * size * 4);
+}
+
+void	VirtualTextureSystem::workerLoop()
+{
+	while (true)
+	{
+		PageJob	job;
+		{
+			std::unique_lock<std::mutex>	lock(_mutex);
+			_condition.wait(lock, [this] { return _stop || !_jobs.empty(); });
+			if (_stop)
+				return ;
+			job = _jobs.front();
+			_jobs.pop_front();
+		}
+
+		if (job.level == CLOSE_JOB)
+		{
+			_files.erase(job.texture);
+			continue ;
+		}
+
+		PageResult	result;
+		result.job = job;
+		result.width = 0;
+		result.height = 0;
+		result.levelCount = 0;
+		try
+		{
+			PageFile&	file = _files[job.texture];
+			if (job.level == TILE_JOB)
+			{
+				// page 파일이 없거나 원본이 바뀌었으면 다시 만듭니다.
+				std::string					pagePath = job.path + ".vt";
+				unsigned long long	key = pageSourceKey(job.path);
+				if (!file.open(pagePath, key))
+				{
+					tilePageFile(job.path, pagePath);
+					if (!file.open(pagePath, key))
+						throw std::runtime_error("ERROR::LOADER::VT::WRONG_FORMAT\nfailed to read page file.");
+				}
+				if (file.width() > MAX_VIRTUAL_SIZE || file.height() > MAX_VIRTUAL_SIZE)
+					throw std::runtime_error("ERROR::LOADER::VT::TOO_LARGE\nvirtual texture is larger than 32768.");
+				result.width = file.width();
+				result.height = file.height();
+				result.levelCount = file.levelCount();
+			}
+			else
+				file.readPage(job.level, job.x, job.y, result.data);
+		}
+		catch (const std::exception& e)
+		{
+			result.error = e.what();
+		}
+
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_results.push_back(PageResult());
+		std::swap(_results.back(), result);
+	}
+}
+
+// page 파일이 준비되면 indirection 텍스처를 만들고 가장 작은 level 의 page 를 요청합니다.
+void	VirtualTextureSystem::onTiled(const PageResult& result)
+{
+	VirtualTexture&	texture = _textures[result.job.texture];
+	texture.width = result.width;
+	texture.height = result.height;
+	texture.levelCount = result.levelCount;
+
+	// indirection 의 level 0 은 page 수를 2 의 거듭제곱으로 올린 크기라서 GL mip 크기가 모든 level 의 page 수를 덮습니다.
+	unsigned int	baseWidth = 1, baseHeight = 1;
+	while (baseWidth * VT_PAGE_SIZE < texture.width)
+		baseWidth *= 2;
+	while (baseHeight * VT_PAGE_SIZE < texture.height)
+		baseHeight *= 2;
+	for (unsigned int level = 0; level < texture.levelCount; level++)
+	{
+		unsigned int	levelWidth = std::max(1u, texture.width >> level), levelHeight = std::max(1u, texture.height >> level);
+		texture.pagesX.push_back((levelWidth + VT_PAGE_SIZE - 1) / VT_PAGE_SIZE);
+		texture.pagesY.push_back((levelHeight + VT_PAGE_SIZE - 1) / VT_PAGE_SIZE);
+		texture.indirectionWidth.push_back(std::max(1u, baseWidth >> level));
+		texture.indirectionHeight.push_back(std::max(1u, baseHeight >> level));
+		texture.slotOf.push_back(std::vector<int>(texture.pagesX.back() * texture.pagesY.back(), -1));
+		texture.indirection.push_back(std::vector<unsigned char>(texture.indirectionWidth.back() * texture.indirectionHeight.back() * 4, 0));
+	}
+
+	glGenTextures(1, &texture.indirectionID);
+	TextureCache::getInstance().bind(TEXTURE_SLOT_VIRTUAL_INDIRECTION, texture.indirectionID);
+	for (unsigned int level = 0; level < texture.levelCount; level++)
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, texture.indirectionWidth[level], texture.indirectionHeight[level], 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, texture.indirection[level].data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levelCount - 1);
+	texture.ready = true;
+
+	request(result.job.texture, texture.levelCount - 1, 0, 0);
+}
+
+void	VirtualTextureSystem::request(unsigned int texture, unsigned int level, unsigned int x, unsigned int y)
+{
+	unsigned long long	key = pageKey(texture, level, x, y);
+	std::map<unsigned long long, unsigned int>::const_iterator	failure = _failures.find(key);
+	if (failure != _failures.end() && failure->second > MAX_RETRIES)
+		return ;
+	if (_requested.size() >= MAX_PENDING_PAGES || !_requested.insert(key).second)
+		return ;
+	PageJob	job = {texture, level, x, y, ""};
+	push(job);
+}
+
+// 실패한 작업은 MAX_RETRIES 번까지 다시 요청합니다. 그 뒤로 그 page 는 요청하지 않고 올라와 있는 조상 page 로 그리며,
+// page 파일을 만들지 못한 텍스처는 ready 가 되지 않아 object 의 기본 텍스처로 그립니다.
+void	VirtualTextureSystem::retry(const PageJob& job)
+{
+	bool								isPage = job.level != TILE_JOB;
+	unsigned long long	key = isPage ? pageKey(job.texture, job.level, job.x, job.y) : pageKey(job.texture, 0xFFFF, 0, 0);
+	if (++_failures[key] > MAX_RETRIES)
+	{
+		std::cerr << "ERROR::LOADER::VT::GIVE_UP\n" << (isPage ? _textures[job.texture].path : job.path)
+			<< (isPage ? ": page is not requested again." : ": page file is not made again.") << std::endl;
+		return ;
+	}
+	if (isPage)
+		request(job.texture, job.level, job.x, job.y);
+	else
+		push(job);
+}
+
+// feedback 픽셀 : r = page x, g = page y, b = level, a = texture 번호 (0 이면 가상 텍스처가 아님)
+void	VirtualTextureSystem::processFeedback(const unsigned char* pixels, size_t count)
+{
+	std::set<unsigned long long>	visible;
+	for (size_t i = 0; i < count; i++)
+	{
+		const unsigned char*	p = pixels + i * 4;
+		if (p[3] != 0)
+			visible.insert(pageKey(p[3], p[2], p[0], p[1]));
+	}
+
+	// 보이는 page 와 그 조상들. 큰 level (흐린 page) 부터 요청해서 먼저 올라오게 합니다.
+	std::vector<std::pair<unsigned int, unsigned long long> >	needed;
+	std::set<unsigned long long>															seen;
+	for (std::set<unsigned long long>::iterator it = visible.begin(); it != visible.end(); ++it)
+	{
+		unsigned int	id = *it >> 48, level = (*it >> 32) & 0xFFFF, x = (*it >> 16) & 0xFFFF, y = *it & 0xFFFF;
+		std::map<unsigned int, VirtualTexture>::iterator	texture = _textures.find(id);
+		if (texture == _textures.end() || !texture->second.ready || level >= texture->second.levelCount)
+			continue ;
+		for (; level < texture->second.levelCount; level++, x >>= 1, y >>= 1)
+		{
+			x = std::min(x, texture->second.pagesX[level] - 1);
+			y = std::min(y, texture->second.pagesY[level] - 1);
+			unsigned long long	key = pageKey(id, level, x, y);
+			if (!seen.insert(key).second)
+				break ;
+			needed.push_back(std::make_pair(texture->second.levelCount - level, key));
+		}
+	}
+	std::sort(needed.begin(), needed.end());
+
+	for (size_t i = 0; i < needed.size(); i++)
+	{
+		unsigned long long	key = needed[i].second;
+		unsigned int				id = key >> 48, level = (key >> 32) & 0xFFFF, x = (key >> 16) & 0xFFFF, y = key & 0xFFFF;
+		VirtualTexture&			texture = _textures[id];
+		int									slot = texture.slotOf[level][y * texture.pagesX[level] + x];
+		if (slot >= 0)
+			_slots[slot].lastUsed = _frame;
+		else
+			request(id, level, x, y);
+	}
+	_feedbackFrame = _frame;
+}
+
+// 빈 칸, 없으면 마지막 feedback 에서 보이지 않은 칸 중 가장 오래된 칸. 가장 작은 level 의 page 는 내리지 않습니다.
+int	VirtualTextureSystem::findSlot() const
+{
+	int	best = -1;
+	for (size_t i = 0; i < _slots.size(); i++)
+	{
+		const Slot&	slot = _slots[i];
+		if (!slot.used)
+			return i;
+		std::map<unsigned int, VirtualTexture>::const_iterator	owner = _textures.find(slot.texture);
+		if (slot.lastUsed >= _feedbackFrame || (owner != _textures.end() && slot.level + 1 == owner->second.levelCount))
+			continue ;
+		if (best < 0 || slot.lastUsed < _slots[best].lastUsed)
+			best = i;
+	}
+	return best;
+}
+
+void	VirtualTextureSystem::unmapSlot(int slot)
+{
+	Slot&	old = _slots[slot];
+	if (!old.used)
+		return ;
+	std::map<unsigned int, VirtualTexture>::iterator	owner = _textures.find(old.texture);
+	if (owner != _textures.end())
+	{
+		owner->second.slotOf[old.level][old.y * owner->second.pagesX[old.level] + old.x] = -1;
+		owner->second.dirty = true;
+	}
+	old.used = false;
+}
+
+bool	VirtualTextureSystem::uploadPage(const PageResult& page)
+{
+	int	slot = findSlot();
+	if (slot < 0)
+		return false;
+	unmapSlot(slot);
+
+	TextureCache::getInstance().bind(TEXTURE_SLOT_VIRTUAL_PAGES, _physicalID);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % _slotsPerSide) * VT_SLOT_SIZE, (slot / _slotsPerSide) * VT_SLOT_SIZE,
+		VT_SLOT_SIZE, VT_SLOT_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, page.data.data());
+
+	VirtualTexture&	texture = _textures[page.job.texture];
+	Slot						mapped = {true, page.job.texture, page.job.level, page.job.x, page.job.y, _frame};
+	_slots[slot] = mapped;
+	texture.slotOf[page.job.level][page.job.y * texture.pagesX[page.job.level] + page.job.x] = slot;
+	texture.dirty = true;
+	return true;
+}
+
+// 가장 작은 level 부터 내려가며, 올라와 있지 않은 page 는 부모 page 의 항목을 물려받습니다.
+void	VirtualTextureSystem::rebuildIndirection(VirtualTexture& texture)
+{
+	TextureCache::getInstance().bind(TEXTURE_SLOT_VIRTUAL_INDIRECTION, texture.indirectionID);
+	for (int level = texture.levelCount - 1; level >= 0; level--)
+	{
+		std::vector<unsigned char>&	entries = texture.indirection[level];
+		unsigned int								width = texture.indirectionWidth[level];
+		for (unsigned int y = 0; y < texture.pagesY[level]; y++)
+		{
+			for (unsigned int x = 0; x < texture.pagesX[level]; x++)
+			{
+				unsigned char*	entry = &entries[(y * width + x) * 4];
+				int							slot = texture.slotOf[level][y * texture.pagesX[level] + x];
+				if (slot >= 0)
+				{
+					entry[0] = slot % _slotsPerSide;
+					entry[1] = slot / _slotsPerSide;
+					entry[2] = level;
+					entry[3] = 255;
+				}
+				else if (level + 1 < static_cast<int>(texture.levelCount))
+				{
+					unsigned int	px = std::min(x >> 1, texture.pagesX[level + 1] - 1);
+					unsigned int	py = std::min(y >> 1, texture.pagesY[level + 1] - 1);
+					std::memcpy(entry, &texture.indirection[level + 1][(py * texture.indirectionWidth[level + 1] + px) * 4], 4);
+				}
+				else
+					std::memset(entry, 0, 4);
+			}
+		}
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, texture.indirectionHeight[level], GL_RGBA, GL_UNSIGNED_BYTE, entries.data());
+	}
+	texture.dirty = false;
+}
+
+// 원본을 page 로 나누는 일이 끝나서 가장 작은 level 이 올라와 있는지
+bool	VirtualTextureSystem::isReady(unsigned int id) const
+{
+	std::map<unsigned int, VirtualTexture>::const_iterator	it = _textures.find(id);
+	return it != _textures.end() && it->second.ready && it->second.slotOf[it->second.levelCount - 1][0] >= 0;
+}
+
+// 가상 텍스처를 쓰지 않는 object 는 id 0 으로 불러서 셰이더에서 끕니다.
+void	VirtualTextureSystem::bind(unsigned int id, Shader& shader, int infoUniform)
+{
+	std::map<unsigned int, VirtualTexture>::iterator	it = _textures.find(id);
+	if (id == 0 || it == _textures.end() || !it->second.ready)
+	{
+		shader.setVec4(infoUniform, 0.0f, 0.0f, 0.0f, 0.0f);
+		return ;
+	}
+	TextureCache::getInstance().bind(TEXTURE_SLOT_VIRTUAL_PAGES, _physicalID);
+	TextureCache::getInstance().bind(TEXTURE_SLOT_VIRTUAL_INDIRECTION, it->second.indirectionID);
+	shader.setVec4(infoUniform, it->second.width, it->second.height, it->second.levelCount, id);
+}
+
+// 화면의 1/FEEDBACK_SCALE 크기 framebuffer 로 바꿉니다. false 면 이번 프레임은 feedback 을 건너뜁니다.
+bool	VirtualTextureSystem::beginFeedback(unsigned int screenWidth, unsigned int screenHeight)
+{
+	if (_textures.empty() || _feedbackPending || _frame % FEEDBACK_INTERVAL)
+		return false;
+
+	unsigned int	width = std::max(1u, screenWidth / FEEDBACK_SCALE), height = std::max(1u, screenHeight / FEEDBACK_SCALE);
+	if (!_fbo)
+	{
+		glGenFramebuffers(1, &_fbo);
+		glGenRenderbuffers(1, &_feedbackColor);
+		glGenRenderbuffers(1, &_feedbackDepth);
+		glGenBuffers(1, &_feedbackPBO);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, _fbo);
+	if (width != _feedbackWidth || height != _feedbackHeight)
+	{
+		_feedbackWidth = width;
+		_feedbackHeight = height;
+		glBindRenderbuffer(GL_RENDERBUFFER, _feedbackColor);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, _feedbackDepth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _feedbackColor);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _feedbackDepth);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, _feedbackPBO);
+		glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, NULL, GL_STREAM_READ);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return false;
+	}
+	glGetIntegerv(GL_VIEWPORT, _viewport);
+	glViewport(0, 0, width, height);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	return true;
+}
+
+// 결과는 PBO 로 비동기로 읽고, GPU 가 끝나면 다음 update() 에서 처리합니다.
+void	VirtualTextureSystem::endFeedback()
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, _feedbackPBO);
+	glReadPixels(0, 0, _feedbackWidth, _feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	_feedbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_feedbackPending = true;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
+}
+
+// feedback framebuffer 가 작아서 커진 화면 미분만큼 level 을 낮춥니다.
+float	VirtualTextureSystem::feedbackLodBias() const
+{
+	return -std::log2(static_cast<float>(FEEDBACK_SCALE));
+}
+
+// GL 스레드에서 프레임마다 호출합니다.
+void	VirtualTextureSystem::update()
+{
+	if (_feedbackPending)
+	{
+		GLenum	status = glClientWaitSync(_feedbackFence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+		{
+			glDeleteSync(_feedbackFence);
+			_feedbackFence = 0;
+			_feedbackPending = false;
+			size_t	size = static_cast<size_t>(_feedbackWidth) * _feedbackHeight * 4;
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, _feedbackPBO);
+			const unsigned char*	pixels = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+			if (pixels)
+			{
+				processFeedback(pixels, size / 4);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		while (!_results.empty())
+		{
+			_uploads.push_back(PageResult());
+			std::swap(_uploads.back(), _results.front());
+			_results.pop_front();
+		}
+	}
+
+	// 모든 칸이 지금 보이는 page 면 (full) 남은 page 는 버립니다. 여전히 보이면 다음 feedback 이 다시 요청합니다.
+	unsigned int	uploaded = 0;
+	bool					full = false;
+	while (!_uploads.empty() && uploaded < MAX_UPLOADS_PER_FRAME)
+	{
+		PageResult&	result = _uploads.front();
+		std::map<unsigned int, VirtualTexture>::iterator	texture = _textures.find(result.job.texture);
+		bool				isPage = result.job.level != TILE_JOB;
+		// release 된 texture 의 결과는 요청 목록에 없으므로 버려집니다. (번호가 다시 쓰였어도)
+		bool				wanted = isPage ? _requested.erase(pageKey(result.job.texture, result.job.level, result.job.x, result.job.y)) > 0
+			: texture != _textures.end() && texture->second.path == result.job.path && !texture->second.ready;
+		if (!result.error.empty())
+		{
+			std::cerr << result.error << std::endl;
+			if (wanted)
+				retry(result.job);
+		}
+		else if (!wanted)
+			;
+		else if (!isPage)
+			onTiled(result);
+		else if (!full && uploadPage(result))
+			uploaded++;
+		else
+			full = true;
+		_uploads.pop_front();
+	}
+
+	for (std::map<unsigned int, VirtualTexture>::iterator it = _textures.begin(); it != _textures.end(); ++it)
+		if (it->second.dirty)
+			rebuildIndirection(it->second);
+	_frame++;
+}
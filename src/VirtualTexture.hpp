@@ -0,0 +1,143 @@
+#ifndef __VIRTUALTEXTURE_HPP__
+# define __VIRTUALTEXTURE_HPP__
+
+#include <glad/glad.h> // include glad to get the required OpenGL headers
+
+# include <vector>
+# include <deque>
+# include <map>
+# include <set>
+# include <string>
+# include <thread>
+# include <mutex>
+# include <condition_variable>
+# include <iostream>
+# include <cmath>
+
+# include "TextureCache.hpp"
+# include "Shader.hpp"
+# include "PageTiler.hpp"
+
+// 가상 텍스처 : VRAM 에 다 올릴 수 없는 큰 diffuse 텍스처 (16k ~ 32k) 를 page 단위로 올립니다.
+// 1. 원본은 처음 한 번 <file>.vt 로 나뉩니다. (PageTiler, 원본 전체를 메모리에 올리지 않음)
+// 2. feedback pass 가 작은 framebuffer 에 화면에 보이는 (texture, level, page) 를 그리고,
+//    한 프레임 뒤에 PBO 로 읽어서 필요한 page 를 worker 스레드에 요청합니다.
+// 3. 읽어 온 page 는 physical cache 텍스처의 빈 칸 (없으면 가장 오래 안 보인 칸) 에 올라가고,
+//    texture 마다 있는 indirection 텍스처 (page 마다 texel 하나, level 마다 mip 하나) 가
+//    page 가 놓인 칸을 가리킵니다. 올라와 있지 않은 page 는 올라와 있는 가장 가까운 조상 page 를 가리킵니다.
+// 가장 작은 level 은 page 하나로 늘 올라와 있어서, 구멍 없이 흐리게만 보입니다.
+class VirtualTextureSystem
+{
+	private:
+		static const unsigned int	TILE_JOB = 0xFFFFFFFFu;
+		static const unsigned int	CLOSE_JOB = 0xFFFFFFFEu;
+
+		struct	VirtualTexture {
+			std::string																path;
+			unsigned int															refCount;
+			bool																			ready;
+			bool																			dirty;
+			unsigned int															width;
+			unsigned int															height;
+			unsigned int															levelCount;
+			std::vector<unsigned int>									pagesX, pagesY;
+			std::vector<unsigned int>									indirectionWidth, indirectionHeight;
+			std::vector<std::vector<int> >						slotOf;				// level 별 page -> 칸, 없으면 -1
+			std::vector<std::vector<unsigned char> >	indirection;	// level 별 RGBA (칸 x, 칸 y, level, 유효)
+			unsigned int															indirectionID;
+		};
+
+		struct	Slot {
+			bool								used;
+			unsigned int				texture;
+			unsigned int				level;
+			unsigned int				x;
+			unsigned int				y;
+			unsigned long long	lastUsed;
+		};
+
+		struct	PageJob {
+			unsigned int	texture;
+			unsigned int	level;	// TILE_JOB / CLOSE_JOB 이면 page 가 아닌 작업
+			unsigned int	x;
+			unsigned int	y;
+			std::string		path;
+		};
+
+		struct	PageResult {
+			PageJob											job;
+			std::vector<unsigned char>	data;
+			unsigned int								width;
+			unsigned int								height;
+			unsigned int								levelCount;
+			std::string									error;
+		};
+
+		// worker 스레드
+		std::thread								_worker;
+		std::mutex								_mutex;
+		std::condition_variable		_condition;
+		std::deque<PageJob>				_jobs;
+		std::deque<PageResult>		_results;
+		bool											_stop;
+		std::map<unsigned int, PageFile>	_files;	// worker 스레드 전용
+
+		// GL 스레드 전용
+		std::map<unsigned int, VirtualTexture>	_textures;
+		std::map<std::string, unsigned int>			_byPath;
+		std::set<unsigned long long>						_requested;
+		std::map<unsigned long long, unsigned int>	_failures;	// 실패한 작업의 key 별 횟수 (page 파일 만들기는 level 0xFFFF)
+		std::deque<PageResult>									_uploads;
+		std::vector<Slot>												_slots;
+		unsigned int														_slotsPerSide;
+		unsigned int														_physicalID;
+		unsigned long long											_frame;
+		unsigned long long											_feedbackFrame;
+
+		unsigned int	_fbo, _feedbackColor, _feedbackDepth, _feedbackPBO;
+		unsigned int	_feedbackWidth, _feedbackHeight;
+		GLsync				_feedbackFence;
+		bool					_feedbackPending;
+		GLint					_viewport[4];
+
+		VirtualTextureSystem();
+		VirtualTextureSystem(const VirtualTextureSystem&);
+		VirtualTextureSystem&	operator=(const VirtualTextureSystem&);
+
+		void		workerLoop();
+		void		push(const PageJob& job);
+		void		createPhysical();
+		void		onTiled(const PageResult& result);
+		void		processFeedback(const unsigned char* pixels, size_t count);
+		void		request(unsigned int texture, unsigned int level, unsigned int x, unsigned int y);
+		void		retry(const PageJob& job);
+		bool		uploadPage(const PageResult& page);
+		int			findSlot() const;
+		void		unmapSlot(int slot);
+		void		rebuildIndirection(VirtualTexture& texture);
+		static unsigned long long	pageKey(unsigned int texture, unsigned int level, unsigned int x, unsigned int y);
+
+	public:
+		static const unsigned int	MIN_VIRTUAL_SIZE = 8192;			// 이보다 큰 diffuse 텍스처는 가상 텍스처로 올립니다.
+		static const unsigned int	MAX_VIRTUAL_SIZE = 32768;			// feedback 이 page 좌표를 8 bit 로 씁니다.
+		static const unsigned int	MAX_SLOTS_PER_SIDE = 16;
+		static const unsigned int	MAX_UPLOADS_PER_FRAME = 8;
+		static const unsigned int	MAX_PENDING_PAGES = 64;
+		static const unsigned int	MAX_RETRIES = 3;						// 실패한 작업을 다시 요청하는 횟수
+		static const unsigned int	FEEDBACK_SCALE = 8;
+		static const unsigned int	FEEDBACK_INTERVAL = 2;
+
+		static VirtualTextureSystem&	getInstance();
+		~VirtualTextureSystem();
+
+		unsigned int	acquire(const std::string& path);
+		void					release(unsigned int id);
+		void					bind(unsigned int id, Shader& shader, int infoUniform);
+		bool					isReady(unsigned int id) const;
+		bool					beginFeedback(unsigned int screenWidth, unsigned int screenHeight);
+		void					endFeedback();
+		float					feedbackLodBias() const;
+		void					update();
+};
+
+#endif
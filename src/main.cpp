@@ -1,17 +1,31 @@
 #include "Shader.hpp"
 #include "utils.hpp"
 #include "Object.hpp"
+#include "TextureStreamer.hpp"
+#include "TextureResidency.hpp"
+#include "VirtualTexture.hpp"
+#include "TransformStore.hpp"
+#include "MatrixExpr.hpp"
+#include "OcclusionBuffer.hpp"
+
+#include <cstdlib>
+#include <algorithm>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void process_input(Object& object);
-void cameraMove(const float* model, unsigned int uMVPLoc);
+Mat4 cameraViewProjection();
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+int pick_object(const std::vector<Object>& objects, const std::map<unsigned int, int>& objectByTransform, double x, double y);
 
 // settings
 unsigned int	SCR_WIDTH = 800;
 unsigned int	SCR_HEIGHT = 600;
 bool            g_translate[7] = {false}, g_rotation[7] = {false}, g_textureMode = false;
 int			    g_objectIndex = 0, g_objectTotal;
+bool            g_cameraChanged = true;     // view-projection 을 다시 구해야 하는지 (창 크기 변경)
+bool            g_pick = false;             // 클릭한 곳의 object 를 고를지
+double          g_pickX, g_pickY;           // 클릭한 곳 : 창 크기에 대한 비율 (왼쪽 위가 0, 0)
 
 int main(int argc, char* argv[])
 {
@@ -43,6 +57,7 @@ int main(int argc, char* argv[])
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetKeyCallback(window, key_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
@@ -53,9 +68,35 @@ int main(int argc, char* argv[])
 	}
     glEnable(GL_DEPTH_TEST);
 
+    // texture compression : SCOP_TEXTURE_COMPRESSION=off|fast|normal|high
+    // ------------------------------------------------------------------
+    const char*     compression = std::getenv("SCOP_TEXTURE_COMPRESSION");
+    if (compression)
+    {
+        std::string mode(compression);
+        if (mode == "off")
+            TextureCache::getInstance().setCompression(false, BC_QUALITY_NORMAL);
+        else if (mode == "fast")
+            TextureCache::getInstance().setCompression(true, BC_QUALITY_FAST);
+        else if (mode == "high")
+            TextureCache::getInstance().setCompression(true, BC_QUALITY_HIGH);
+    }
+
+    // texture memory budget : SCOP_TEXTURE_BUDGET_MB=<MiB>
+    // ----------------------------------------------------
+    const char*     budget = std::getenv("SCOP_TEXTURE_BUDGET_MB");
+    if (budget && std::atol(budget) > 0)
+        TextureResidency::getInstance().setBudget(static_cast<size_t>(std::atol(budget)) * 1024 * 1024);
+
+    // occlusion culling : SCOP_OCCLUSION_CULLING=off 이면 frustum 밖인 object 만 건너뜁니다.
+    // ------------------------------------------------------------------------------
+    const char*     occlusionCulling = std::getenv("SCOP_OCCLUSION_CULLING");
+    bool            useOcclusion = !(occlusionCulling && std::string(occlusionCulling) == "off");
+
     // build and compile our shader program
     // ------------------------------------
     Shader  shader("./src/shaders/vertexShaderSource.glsl", "./src/shaders/fragmentShaderSource.glsl");
+    Shader  feedbackShader("./src/shaders/vertexShaderSource.glsl", "./src/shaders/feedbackShaderSource.glsl");
 
     // set up vertex data
     // ------------------
@@ -68,6 +109,12 @@ int main(int argc, char* argv[])
     {
         for (int i = 0; i < g_objectTotal; i++)
 			objects[i].setObject();
+
+        // 텍스처는 처음 텍스처 모드로 바꿀 때 디코딩합니다. SCOP_TEXTURE_PREFETCH=on 이면 시작할 때 미리 읽습니다.
+        const char* prefetch = std::getenv("SCOP_TEXTURE_PREFETCH");
+        if (prefetch && std::string(prefetch) == "on")
+            for (int i = 0; i < g_objectTotal; i++)
+                objects[i].prefetchTextures();
     }
     catch(const std::exception& e)
     {
@@ -75,16 +122,40 @@ int main(int argc, char* argv[])
         return -1;
     }
 
-    unsigned int    uMVPLoc = glGetUniformLocation(shader.ID, "uMVP");
-    unsigned int    modelLoc = glGetUniformLocation(shader.ID, "model");
-    unsigned int    lightPosLoc = glGetUniformLocation(shader.ID, "lightPos");
-    unsigned int    lightColorLoc = glGetUniformLocation(shader.ID, "lightColor");
-    unsigned int    objectColorLoc = glGetUniformLocation(shader.ID, "objectColor");
-    unsigned int    textureRatioLoc = glGetUniformLocation(shader.ID, "textureRatio");
-    unsigned int    bumpSamplerLoc = glGetUniformLocation(shader.ID, "BumpSampler");
-    unsigned int    diffuseSamplerLoc = glGetUniformLocation(shader.ID, "DiffuseSampler");
+    // 매 프레임 올리는 uniform 의 handle : shader 가 link 할 때 읽어 둔 표에서 찾습니다.
+    int             uMVPUniform = shader.uniform("uMVP");
+    int             modelUniform = shader.uniform("model");
+    int             normalMatrixUniform = shader.uniform("normalMatrix");
+    int             lightPosUniform = shader.uniform("lightPos");
+    int             lightColorUniform = shader.uniform("lightColor");
+    int             objectColorUniform = shader.uniform("objectColor");
+    int             textureRatioUniform = shader.uniform("textureRatio");
+    int             virtualInfoUniform = shader.uniform("virtualInfo");
+    int             feedbackMVPUniform = feedbackShader.uniform("uMVP");
+    int             feedbackModelUniform = feedbackShader.uniform("model");
+    int             feedbackNormalMatrixUniform = feedbackShader.uniform("normalMatrix");
+    int             feedbackInfoUniform = feedbackShader.uniform("virtualInfo");
+    VirtualTextureSystem&   virtualTextures = VirtualTextureSystem::getInstance();
+    shader.use();
+    shader.setInt("BumpSampler", TEXTURE_SLOT_BUMP);
+    shader.setInt("DiffuseSampler", TEXTURE_SLOT_DIFFUSE);
+    shader.setInt("VirtualPages", TEXTURE_SLOT_VIRTUAL_PAGES);
+    shader.setInt("VirtualIndirection", TEXTURE_SLOT_VIRTUAL_INDIRECTION);
+    feedbackShader.use();
+    feedbackShader.setFloat("lodBias", virtualTextures.feedbackLodBias());
     float           lightColor = 1.0f;
     float           lightChange = -0.005f;
+    std::vector<unsigned char>  drawable(g_objectTotal);
+    std::map<unsigned int, int> objectByTransform;      // transform id -> objects 의 번호 (scene tree 의 결과를 object 로)
+    for (int i = 0; i < g_objectTotal; i++)
+        objectByTransform[objects[i].getTransformID()] = i;
+    OcclusionBuffer&    occlusion = OcclusionBuffer::getInstance();
+    Mat4                viewProjection;
+    std::vector<unsigned int>   candidates;            // scene tree 의 frustum query 결과 (transform id)
+    std::vector<unsigned int>   unbounded;             // scene tree 에 없는 (경계가 없는) object 는 언제나 후보입니다.
+    for (int i = 0; i < g_objectTotal; i++)
+        if (!TransformStore::getInstance().bounded(objects[i].getTransformID()))
+            unbounded.push_back(objects[i].getTransformID());
 
     // render loop
     // -----------
@@ -102,33 +173,115 @@ int main(int argc, char* argv[])
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shader.use();
 
-        process_input(objects[g_objectIndex]);
+        // 클릭한 곳에서 처음 맞는 object 를 고릅니다. 행렬은 아직 지난 프레임 (화면에 보인 그대로) 입니다.
+        if (g_pick)
+        {
+            int picked = pick_object(objects, objectByTransform, g_pickX, g_pickY);
+            if (picked >= 0)
+                g_objectIndex = picked;
+            g_pick = false;
+        }
+
+        // 텍스처 모드로 처음 바꿀 때 텍스처를 읽으므로, 읽지 못하면 여기서 종료합니다.
+        try
+        {
+            process_input(objects[g_objectIndex]);
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+            glfwSetWindowShouldClose(window, true);
+        }
+
+        // 디코딩이 끝난 텍스처를 프레임당 예산만큼 업로드합니다.
+        TextureStreamer::getInstance().update();
+        // 예산을 넘으면 오래 쓰이지 않은 텍스처를 줄이고, 다시 쓰이는 텍스처는 다시 올립니다.
+        TextureResidency::getInstance().update();
+
+        // 바뀐 object 의 model / MVP 행렬과 frustum 안에 있는지만 다시 구합니다. 카메라가 바뀌면 모두 다시 구합니다.
+        if (g_cameraChanged)
+        {
+            viewProjection = cameraViewProjection();
+            TransformStore::getInstance().setViewProjection(viewProjection);
+            g_cameraChanged = false;
+        }
+        TransformStore::getInstance().update();
+
+        // scene tree 에서 frustum 과 겹칠 수 있는 object 만 log 시간에 골라서, 그것들만 정확히 검사합니다.
+        // (tree 는 fat 상자라 넉넉하므로 isVisible() 로 다시 거릅니다)
+        candidates.assign(unbounded.begin(), unbounded.end());
+        TransformStore::getInstance().tree().queryFrustum(viewProjection, candidates);
+        std::fill(drawable.begin(), drawable.end(), 0);
+        for (size_t c = 0; c < candidates.size(); c++)
+        {
+            std::map<unsigned int, int>::const_iterator found = objectByTransform.find(candidates[c]);
+            if (found != objectByTransform.end() && objects[found->second].isVisible())
+                drawable[found->second] = 1;
+        }
+
+        // 큰 object 로 CPU depth buffer 를 그리고, 그 뒤에 숨은 object 는 이번 프레임에 그리지 않습니다.
+        if (useOcclusion)
+        {
+            occlusion.begin();
+            for (int i = 0; i < g_objectTotal; i++)
+                if (drawable[i])
+                    occlusion.addOccluder(objects[i].getMVPMatrix(), objects[i].getBounds(), objects[i].getOccluder());
+            occlusion.render();
+            for (int i = 0; i < g_objectTotal; i++)
+                if (drawable[i] && occlusion.isOccluded(objects[i].getMVPMatrix(), objects[i].getBounds()))
+                    drawable[i] = 0;
+        }
+
+        // 가상 텍스처 : 작은 framebuffer 에 보이는 page 를 그려서 필요한 page 를 요청합니다.
+        // 가상 텍스처가 없는 object 도 가림을 위해 같이 그립니다.
+        if (virtualTextures.beginFeedback(SCR_WIDTH, SCR_HEIGHT))
+        {
+            feedbackShader.use();
+            for (int i = 0; i < g_objectTotal; i++)
+            {
+                if (!drawable[i])
+                    continue;
+                feedbackShader.setMat4(feedbackModelUniform, objects[i].getModelMatrix().m);
+                feedbackShader.setMat4(feedbackMVPUniform, objects[i].getMVPMatrix().m);
+                feedbackShader.setMat4(feedbackNormalMatrixUniform, objects[i].getNormalMatrix().m);
+                virtualTextures.bind(objects[i].getVirtualTexture(), feedbackShader, feedbackInfoUniform);
+                objects[i].drawGeometry();
+            }
+            virtualTextures.endFeedback();
+            shader.use();
+        }
+        virtualTextures.update();
 
         // Apply camera move & rotation
         // ----------------------------
-        glUniform3f(lightPosLoc, 3.0f, 3.0f, 5.0f);
-        glUniform3f(objectColorLoc, 0.8f, 0.8f, 0.8f);
+        shader.setVec3(lightPosUniform, 3.0f, 3.0f, 5.0f);
+        shader.setVec3(objectColorUniform, 0.8f, 0.8f, 0.8f);
 		
 		for (int i = 0; i < g_objectTotal; i++)
 		{
 			Object&	object = objects[i];
+            if (!drawable[i])
+            {
+                // 화면 밖에서도 텍스처 전환은 계속 진행합니다.
+                object.updateTextureBlendRatio();
+                continue;
+            }
 
-        	float   model[16];
-        	object.getModelMatrix(model);
-        	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, model);
-
-        	cameraMove(model, uMVPLoc);
+        	shader.setMat4(modelUniform, object.getModelMatrix().m);
+        	shader.setMat4(uMVPUniform, object.getMVPMatrix().m);
+        	shader.setMat4(normalMatrixUniform, object.getNormalMatrix().m);
 
             if (i == g_objectIndex)
-                glUniform3f(lightColorLoc, lightColor, lightColor, lightColor);
+                shader.setVec3(lightColorUniform, lightColor, lightColor, lightColor);
             else
-                glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f);
-        	glUniform1f(textureRatioLoc, object.getTextureRatio());
+                shader.setVec3(lightColorUniform, 1.0f, 1.0f, 1.0f);
+        	shader.setFloat(textureRatioUniform, object.getTextureRatio());
 
         	// Draw object
         	// -----------
         	object.updateTextureBlendRatio();
-        	object.drawObject(bumpSamplerLoc, diffuseSamplerLoc);
+        	virtualTextures.bind(object.getVirtualTexture(), shader, virtualInfoUniform);
+        	object.drawObject();
 		}
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -143,19 +296,46 @@ int main(int argc, char* argv[])
     return 0;
 }
 
-void    cameraMove(const float* model, unsigned int uMVPLoc)
+// 카메라는 고정되어 있으므로 view 와 (aspect 를 뺀) projection 은 컴파일 때 계산됩니다.
+static constexpr TMat<4, 4> CAMERA_VIEW = constLookAt(0.0f, 0.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+static constexpr TMat<4, 4> CAMERA_PROJECTION = constPerspective(45.0f, 1.0f, 0.1f, 100.0f);
+
+Mat4    cameraViewProjection()
 {
-    // MVP 행렬 계산 및 전달
-    // -----------------
-    float   view[16], proj[16], mvp[16];
-    makeLookAt(view, 0.0f, 0.0f, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-    makePerspective(proj, 45.0f, (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 100.0f);
-
-    multiplyMatrix(mvp, proj, view);
-    multiplyMatrix(mvp, mvp, model);
-    // uniform 전달
-    // -----------
-    glUniformMatrix4fv(uMVPLoc, 1, GL_FALSE, mvp);
+    // View / Projection 행렬 계산 : 창 크기에 따라 바뀌는 (0, 0) 만 실행 중에 채웁니다.
+    // ------------------------
+    TMat<4, 4>  proj = CAMERA_PROJECTION;
+    proj.at(0, 0) = CAMERA_PROJECTION(1, 1) / ((float)SCR_WIDTH / SCR_HEIGHT);
+
+    return toMat4(proj * CAMERA_VIEW);
+}
+
+// 커서를 지나는 광선을 near 평면에서 far 평면까지 (t 가 0 ~ 1) 쏩니다.
+// scene tree 가 상자가 가까운 object 부터 넘겨 주고, 각 object 는 자기 삼각형 BVH 로 정확히 봅니다.
+// 처음 맞는 object 의 번호, 아무것도 맞지 않으면 -1 을 돌려줍니다.
+int     pick_object(const std::vector<Object>& objects, const std::map<unsigned int, int>& objectByTransform, double x, double y)
+{
+    Mat4    inverseViewProjection;
+    if (!inverse(cameraViewProjection(), inverseViewProjection))
+        return -1;
+    float   ndcX = static_cast<float>(x * 2.0 - 1.0), ndcY = static_cast<float>(1.0 - y * 2.0);
+    Vec4    nearPoint = inverseViewProjection * Vec4(ndcX, ndcY, -1.0f, 1.0f);
+    Vec4    farPoint = inverseViewProjection * Vec4(ndcX, ndcY, 1.0f, 1.0f);
+    float   origin[3], direction[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        origin[axis] = nearPoint.v[axis] / nearPoint.v[3];
+        direction[axis] = farPoint.v[axis] / farPoint.v[3] - origin[axis];
+    }
+
+    int     picked = -1;
+    TransformStore::getInstance().tree().raycast(origin, direction, 1.0f, [&](unsigned int id, float maxDistance) {
+        std::map<unsigned int, int>::const_iterator found = objectByTransform.find(id);
+        if (found != objectByTransform.end() && objects[found->second].intersectRay(origin, direction, maxDistance))
+            picked = found->second;
+        return maxDistance;
+    });
+    return picked;
 }
 
 void    process_input(Object& object)
@@ -268,6 +448,26 @@ void    key_callback(GLFWwindow* window, int key, int scancode, int action, int
         g_rotation[6] = false;
 	if (key == GLFW_KEY_C && action == GLFW_PRESS)
 		g_objectIndex = (g_objectIndex + 1) % g_objectTotal;
+	if (key == GLFW_KEY_I && action == GLFW_PRESS)
+		TextureResidency::getInstance().printStats(std::cout);
+}
+
+// 왼쪽 클릭 : 커서 아래의 object 를 고릅니다. (다음 프레임 처음에)
+void    mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    (void)mods;
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+        return;
+    // 커서 좌표는 framebuffer 가 아니라 창 좌표라서 (retina) 창 크기로 나눕니다.
+    double  x, y;
+    int     width, height;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &width, &height);
+    if (width <= 0 || height <= 0)
+        return;
+    g_pickX = x / width;
+    g_pickY = y / height;
+    g_pick = true;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -279,5 +479,6 @@ void    framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // height will be significantly larger than specified on retina displays.
 	SCR_WIDTH = width;
 	SCR_HEIGHT = height;
+	g_cameraChanged = true;
     glViewport(0, 0, width, height);
 }
@@ -0,0 +1,23 @@
+#version 330 core
+in vec2 UV;
+
+out vec4 FragColor;
+
+uniform vec4 virtualInfo;   // (width, height, level 수, 가상 텍스처 번호), 번호가 0 이면 가상 텍스처가 아님
+uniform float lodBias;      // feedback framebuffer 가 작은 만큼 level 을 낮춥니다.
+
+// 이 픽셀이 쓰는 page 를 (page x, page y, level, 번호) 로 기록합니다. 0 은 "필요한 page 없음" 입니다.
+void main()
+{
+    if (virtualInfo.w <= 0.0)
+    {
+        FragColor = vec4(0.0);
+        return;
+    }
+    vec2 texel = UV * virtualInfo.xy;
+    float rho = max(dot(dFdx(texel), dFdx(texel)), dot(dFdy(texel), dFdy(texel)));
+    float lod = clamp(floor(0.5 * log2(max(rho, 1e-8)) + lodBias), 0.0, virtualInfo.z - 1.0);
+    vec2 levelSize = max(floor(virtualInfo.xy / exp2(lod)), vec2(1.0));
+    vec2 page = floor(fract(UV) * levelSize / 128.0);
+    FragColor = vec4(page, lod, virtualInfo.w) / 255.0;
+}
@@ -1,6 +1,8 @@
 #version 330 core
 in vec3 FragPos;  
 in vec3 Normal;
+in vec3 Tangent;
+in vec3 Bitangent;
 in vec2 UV;
 
 out vec4 FragColor;
@@ -11,26 +13,51 @@ uniform vec3 objectColor;
 uniform float textureRatio;
 uniform sampler2D BumpSampler;
 uniform sampler2D DiffuseSampler;
+uniform sampler2D VirtualPages;         // physical page cache (칸마다 테두리 4 texel 을 포함한 136x136)
+uniform sampler2D VirtualIndirection;   // page 마다 (칸 x, 칸 y, 올라와 있는 level, 유효)
+uniform vec4 virtualInfo;               // (width, height, level 수, 번호), 번호가 0 이면 DiffuseSampler 를 씁니다.
+
+// 가상 텍스처 : 필요한 level 의 page 가 없으면 indirection 이 가리키는 조상 page 를 씁니다.
+vec3 sampleVirtual(vec2 uv, vec3 fallback)
+{
+    vec2 texel = uv * virtualInfo.xy;
+    float rho = max(dot(dFdx(texel), dFdx(texel)), dot(dFdy(texel), dFdy(texel)));
+    float lod = clamp(floor(0.5 * log2(max(rho, 1e-8))), 0.0, virtualInfo.z - 1.0);
+    vec2 wrapped = fract(uv);
+    vec2 page = floor(wrapped * max(floor(virtualInfo.xy / exp2(lod)), vec2(1.0)) / 128.0);
+    vec4 entry = texelFetch(VirtualIndirection, ivec2(page), int(lod));
+    if (entry.a < 0.5)
+        return fallback;
+
+    float resident = floor(entry.b * 255.0 + 0.5);
+    vec2 residentSize = max(floor(virtualInfo.xy / exp2(resident)), vec2(1.0));
+    vec2 residentPage = min(floor(page / exp2(resident - lod)), ceil(residentSize / 128.0) - 1.0);
+    vec2 local = wrapped * residentSize - residentPage * 128.0;
+    vec2 slot = floor(entry.rg * 255.0 + 0.5);
+    return textureLod(VirtualPages, (slot * 136.0 + 4.0 + local) / vec2(textureSize(VirtualPages, 0)), 0.0).rgb;
+}
 
 void main()
 {
     // 광원 방향
     vec3 lightDir = normalize(lightPos - FragPos);
     vec3 norm = normalize(Normal);
-    vec3 normalMap = texture(BumpSampler, UV).rgb;
-    vec3 bumpedNormal = normalize(normalMap);
+    // tangent space 노멀 맵 : x, y 만 읽고 z 는 단위 벡터에서 복원합니다. (BC5 는 두 채널만 저장)
+    vec2 normalXY = texture(BumpSampler, UV).rg * 2.0 - 1.0;
+    vec3 normalMap = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+    vec3 bumpedNormal = normalize(mat3(Tangent, Bitangent, norm) * normalMap);
 
     // Lambert (diffuse)
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * lightColor;
-    float diffBump = max(dot(norm, lightDir), 0.0);
+    float diffBump = max(dot(bumpedNormal, lightDir), 0.0);
     vec3 diffuseBump = diffBump * lightColor;
 
     // ambient (약간의 기본 빛)
     vec3 ambient = 0.2 * lightColor; // 0.2 는 환경광의 세기
 
     // 텍스처 색상 적용
-    vec3 texColor = texture(DiffuseSampler, UV).rgb;
+    vec3 texColor = virtualInfo.w > 0.0 ? sampleVirtual(UV, objectColor) : texture(DiffuseSampler, UV).rgb;
     vec3 baseColor = mix(objectColor, texColor, textureRatio);
 
     // 최종 색상
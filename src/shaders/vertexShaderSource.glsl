@@ -2,18 +2,28 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 vertexUV;
+layout(location = 3) in vec4 aTangent; // xyz : tangent, w : bitangent 방향
 
 out vec3 FragPos;  
 out vec3 Normal;
+out vec3 Tangent;
+out vec3 Bitangent;
 out vec2 UV;
 
 uniform mat4 model;
 uniform mat4 uMVP;
+uniform mat4 normalMatrix; // transpose(inverse(model)), CPU 에서 object 마다 한 번 구합니다. (mat3 만 씁니다)
 
 void main() 
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal  = mat3(transpose(inverse(model))) * aNormal;
+    Normal  = mat3(normalMatrix) * aNormal;
+    // tangent 는 표면을 따라가므로 model 로 변환하고, 노멀에 수직이 되게 맞춥니다. (Gram-Schmidt)
+    vec3 N = normalize(Normal);
+    vec3 T = mat3(model) * aTangent.xyz;
+    T = T - dot(T, N) * N;
+    Tangent = length(T) > 0.0 ? normalize(T) : vec3(0.0);
+    Bitangent = cross(N, Tangent) * aTangent.w;
     gl_Position = uMVP * vec4(aPos, 1.0);
     UV = vertexUV;
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 # include <cmath>
 # include <cstring>
 
+# include "Matrix.hpp"
+
 void loadIdentity(float* m);
 void multiplyMatrix(float* result, const float* a, const float* b);
 void makePerspective(float* m, float fov, float aspect, float nearZ, float farZ);
@@ -18,4 +20,11 @@ void makeRotationY(float* m, float angleDeg);
 void makeRotationZ(float* m, float angleDeg);
 void makeRotation(float* m, float angleDegX, float angleDegY, float angleDegZ);
 
+// 배치 판 : 각도 count 개로 행렬 count 개 (m 은 float[16 * count]) 를 만듭니다.
+// sin / cos 는 sinCos() 로 여러 개씩 구하므로 libm 판과 ulp 몇 개 다를 수 있습니다.
+void makeRotationXBatch(float* m, const float* angleDeg, size_t count);
+void makeRotationYBatch(float* m, const float* angleDeg, size_t count);
+void makeRotationZBatch(float* m, const float* angleDeg, size_t count);
+void makeRotationBatch(float* m, const float* angleDegX, const float* angleDegY, const float* angleDegZ, size_t count);
+
 #endif